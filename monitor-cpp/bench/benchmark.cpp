@@ -0,0 +1,828 @@
+// Benchmark do monitor.
+// Gera uma árvore sintética, mede no próprio processo a varredura, o hash e a cópia
+// (com o mesmo código usado pelo monitor) e depois dirige um monitor_app real, no
+// modo --config, para medir a latência entre a escrita de um arquivo e a captura
+// da versão correspondente, lida do log de eventos do monitor. O resultado sai em
+// JSON na saída padrão.
+#include "cripto.h"
+#include "ignore.h"
+#include "indice.h"
+#include "leitor_versao.h"
+#include "log_eventos.h"
+#include "monitor.h"
+#include "motor_es.h"
+#include "store.h"
+#include "tabela_arquivos.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <openssl/evp.h>
+#include <poll.h>
+#include <random>
+#include <string>
+#include <sys/inotify.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace fs = std::filesystem;
+using Relogio = std::chrono::steady_clock;
+
+namespace {
+
+struct Opcoes {
+    size_t arquivos = 10000;
+    size_t por_diretorio = 500;
+    uint64_t tamanho_min = 1024;
+    uint64_t tamanho_max = 1 << 20;
+    std::string distribuicao = "lognormal"; // fixa | uniforme | lognormal
+    std::string padrao = "uniforme";        // uniforme | quente | rajada
+    size_t mutacoes = 200;                  // arquivos alterados por rodada
+    size_t rodadas = 5;
+    unsigned threads = 0;
+    unsigned intervalo_ms = 200;
+    bool eventos = false;
+    double limite_s = 300; // espera máxima por cada fase de captura
+    uint64_t semente = 42;
+    fs::path dir = fs::temp_directory_path() / "monitor_bench";
+    fs::path app;
+    std::string implementacao = "cpp"; // cpp | go
+    fs::path comparar;                 // binário do monitor-golang: roda as duas implementações
+    bool conformidade = false;
+    fs::path saida; // vazio: saída padrão
+    bool manter = false;
+};
+
+void ajuda() {
+    std::cerr << "Uso: monitor_bench [opções]\n"
+              << "  --arquivos <n>          arquivos na árvore sintética (10000)\n"
+              << "  --por-diretorio <n>     arquivos por diretório (500)\n"
+              << "  --tamanho-min <bytes>   menor arquivo (1024)\n"
+              << "  --tamanho-max <bytes>   maior arquivo (1048576)\n"
+              << "  --distribuicao <d>      fixa | uniforme | lognormal (lognormal)\n"
+              << "  --padrao <p>            arquivos alterados em cada rodada:\n"
+              << "                            uniforme: sorteados na árvore toda\n"
+              << "                            quente:   90% dentro de 10% dos arquivos\n"
+              << "                            rajada:   um diretório inteiro de uma vez\n"
+              << "  --mutacoes <n>          arquivos alterados por rodada (200)\n"
+              << "  --rodadas <n>           rodadas de alteração (5)\n"
+              << "  --threads <n>           threads do monitor (núcleos)\n"
+              << "  --intervalo <ms>        intervalo de varredura do monitor (200)\n"
+              << "  --eventos               usa fanotify em vez de varredura periódica\n"
+              << "  --limite <s>            espera máxima por cada fase de captura (300)\n"
+              << "  --semente <n>           semente do gerador (42)\n"
+              << "  --dir <pasta>           onde criar a árvore e o store\n"
+              << "  --app <monitor_app>     executável a medir (ao lado do benchmark)\n"
+              << "  --implementacao <i>     cpp | go: formato de invocação de --app (cpp)\n"
+              << "  --comparar <binário go> roda o monitor-cpp e o monitor-golang sobre a mesma carga\n"
+              << "  --conformidade          verifica o store resultante (ver FORMATO_STORE.md)\n"
+              << "  --saida <arquivo>       grava o JSON no arquivo\n"
+              << "  --manter                não apaga a árvore ao final\n";
+}
+
+bool ler_opcoes(int argc, char *argv[], Opcoes &o) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto valor = [&]() -> std::string {
+            if (i + 1 >= argc) throw std::invalid_argument(a + " exige um valor");
+            return argv[++i];
+        };
+        if (a == "--arquivos") o.arquivos = std::stoull(valor());
+        else if (a == "--por-diretorio") o.por_diretorio = std::max<size_t>(1, std::stoull(valor()));
+        else if (a == "--tamanho-min") o.tamanho_min = std::stoull(valor());
+        else if (a == "--tamanho-max") o.tamanho_max = std::stoull(valor());
+        else if (a == "--distribuicao") o.distribuicao = valor();
+        else if (a == "--padrao") o.padrao = valor();
+        else if (a == "--mutacoes") o.mutacoes = std::stoull(valor());
+        else if (a == "--rodadas") o.rodadas = std::stoull(valor());
+        else if (a == "--threads") o.threads = std::stoul(valor());
+        else if (a == "--intervalo") o.intervalo_ms = std::stoul(valor());
+        else if (a == "--eventos") o.eventos = true;
+        else if (a == "--limite") o.limite_s = std::stod(valor());
+        else if (a == "--semente") o.semente = std::stoull(valor());
+        else if (a == "--dir") o.dir = valor();
+        else if (a == "--app") o.app = valor();
+        else if (a == "--implementacao") o.implementacao = valor();
+        else if (a == "--comparar") o.comparar = valor();
+        else if (a == "--conformidade") o.conformidade = true;
+        else if (a == "--saida") o.saida = valor();
+        else if (a == "--manter") o.manter = true;
+        else return false;
+    }
+    if (o.distribuicao != "fixa" && o.distribuicao != "uniforme" && o.distribuicao != "lognormal")
+        throw std::invalid_argument("distribuição desconhecida: " + o.distribuicao);
+    if (o.padrao != "uniforme" && o.padrao != "quente" && o.padrao != "rajada")
+        throw std::invalid_argument("padrão desconhecido: " + o.padrao);
+    if (o.implementacao != "cpp" && o.implementacao != "go")
+        throw std::invalid_argument("implementação desconhecida: " + o.implementacao);
+    if (o.arquivos == 0) throw std::invalid_argument("--arquivos deve ser maior que zero");
+    o.tamanho_max = std::max(o.tamanho_max, o.tamanho_min);
+    o.mutacoes = std::min(o.mutacoes, o.arquivos);
+    return true;
+}
+
+double segundos(Relogio::duration d) {
+    return std::chrono::duration<double>(d).count();
+}
+
+double mb_s(uint64_t bytes, Relogio::duration d) {
+    double s = segundos(d);
+    return s > 0 ? bytes / 1e6 / s : 0;
+}
+
+// ---------------------------------------------------------------------------
+// árvore sintética
+
+struct Arvore {
+    std::vector<std::string> relativos; // "dNNNN/fNNNNNNN.bin"
+    std::vector<uint64_t> tamanhos;
+    uint64_t bytes = 0;
+};
+
+std::string nome_relativo(size_t i, size_t por_diretorio) {
+    char nome[64];
+    std::snprintf(nome, sizeof(nome), "d%04zu/f%07zu.bin", i / por_diretorio, i);
+    return nome;
+}
+
+uint64_t sortear_tamanho(const Opcoes &o, std::mt19937_64 &rng) {
+    if (o.distribuicao == "fixa" || o.tamanho_min == o.tamanho_max) return o.tamanho_min;
+    if (o.distribuicao == "uniforme")
+        return std::uniform_int_distribution<uint64_t>(o.tamanho_min, o.tamanho_max)(rng);
+    // lognormal: mediana na média geométrica dos limites, muitos pequenos e poucos grandes
+    double lo = std::log(std::max<double>(1, o.tamanho_min)), hi = std::log(static_cast<double>(o.tamanho_max));
+    std::lognormal_distribution<double> d((lo + hi) / 2, (hi - lo) / 6);
+    return std::clamp<uint64_t>(static_cast<uint64_t>(d(rng)), o.tamanho_min, o.tamanho_max);
+}
+
+// conteúdo pseudoaleatório: não deduplica nem comprime
+void escrever_arquivo(const fs::path &caminho, uint64_t tamanho, std::mt19937_64 &rng, std::vector<uint64_t> &buffer) {
+    int fd = ::open(caminho.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) throw std::runtime_error("não foi possível criar " + caminho.string() + ": " + std::strerror(errno));
+    while (tamanho > 0) {
+        size_t n = std::min<uint64_t>(tamanho, buffer.size() * sizeof(uint64_t));
+        for (size_t i = 0; i < (n + 7) / 8; ++i) buffer[i] = rng();
+        const char *p = reinterpret_cast<const char *>(buffer.data());
+        for (size_t resto = n; resto > 0;) {
+            ssize_t w = ::write(fd, p, resto);
+            if (w < 0 && errno == EINTR) continue;
+            if (w < 0) {
+                ::close(fd);
+                throw std::runtime_error("erro escrevendo " + caminho.string());
+            }
+            p += w;
+            resto -= w;
+        }
+        tamanho -= n;
+    }
+    ::close(fd);
+}
+
+Arvore gerar_arvore(const Opcoes &o, const fs::path &entrada, std::mt19937_64 &rng) {
+    Arvore a;
+    std::vector<uint64_t> buffer(1 << 13);
+    for (size_t i = 0; i < o.arquivos; ++i) {
+        std::string rel = nome_relativo(i, o.por_diretorio);
+        if (i % o.por_diretorio == 0) fs::create_directories(entrada / rel.substr(0, rel.find('/')));
+        uint64_t tamanho = sortear_tamanho(o, rng);
+        escrever_arquivo(entrada / rel, tamanho, rng, buffer);
+        a.relativos.push_back(std::move(rel));
+        a.tamanhos.push_back(tamanho);
+        a.bytes += tamanho;
+    }
+    return a;
+}
+
+// índices dos arquivos alterados em uma rodada, sem repetição
+std::vector<size_t> escolher_mutacoes(const Opcoes &o, std::mt19937_64 &rng) {
+    std::vector<size_t> escolhidos;
+    if (o.padrao == "rajada") {
+        size_t diretorios = (o.arquivos + o.por_diretorio - 1) / o.por_diretorio;
+        size_t inicio = std::uniform_int_distribution<size_t>(0, diretorios - 1)(rng) * o.por_diretorio;
+        for (size_t i = inicio; escolhidos.size() < o.mutacoes; i = (i + 1) % o.arquivos) escolhidos.push_back(i);
+        return escolhidos;
+    }
+
+    size_t quentes = std::max<size_t>(1, o.arquivos / 10);
+    std::unordered_set<size_t> usados;
+    std::uniform_int_distribution<size_t> todos(0, o.arquivos - 1), conjunto_quente(0, quentes - 1);
+    std::bernoulli_distribution quente(0.9);
+    while (escolhidos.size() < o.mutacoes) {
+        // o conjunto quente pode ser menor que a rodada; o restante sai da árvore toda
+        bool do_quente = o.padrao == "quente" && usados.size() < quentes && quente(rng);
+        size_t i = do_quente ? conjunto_quente(rng) : todos(rng);
+        if (usados.insert(i).second) escolhidos.push_back(i);
+    }
+    return escolhidos;
+}
+
+// ---------------------------------------------------------------------------
+// medições no próprio processo
+
+struct Varredura {
+    size_t entradas = 0;
+    double ms_primeira = 0; // tabela vazia: inclui internar todos os caminhos
+    double ms_por_100k = 0; // mediana das passadas seguintes, como nas varreduras periódicas
+};
+
+Varredura medir_varredura(const fs::path &entrada) {
+    TabelaArquivos tabela;
+    FiltroIgnorar filtro;
+    Varredura v;
+    std::vector<double> passadas;
+    for (int rodada = 0; rodada < 4; ++rodada) {
+        size_t vistos = 0;
+        auto inicio = Relogio::now();
+        // mesmo trabalho por entrada da varredura do monitor: mtime e tamanho
+        varrer_diretorio(entrada, tabela, TabelaArquivos::RAIZ, filtro, filtro.estado_inicial(),
+                         [&](const fs::directory_entry &e, TabelaArquivos::Id id) {
+                             std::error_code ec;
+                             auto &r = tabela.registro(id);
+                             r.mtime = e.last_write_time(ec).time_since_epoch().count();
+                             r.tamanho = e.file_size(ec);
+                             ++vistos;
+                         });
+        double ms = segundos(Relogio::now() - inicio) * 1000;
+        v.entradas = vistos;
+        if (rodada == 0) v.ms_primeira = ms;
+        else passadas.push_back(ms);
+    }
+    std::sort(passadas.begin(), passadas.end());
+    if (v.entradas) v.ms_por_100k = passadas[passadas.size() / 2] * 100000 / v.entradas;
+    return v;
+}
+
+struct Vazao {
+    double hash_mb_s = 0;
+    double copia_mb_s = 0;
+    bool uring = false;
+};
+
+// mesmo motor e tamanho de lote usados na captura; os dados já estão no cache de
+// páginas (a árvore acabou de ser escrita), então mede CPU e caminho de E/S, não o disco
+Vazao medir_vazao(const fs::path &entrada, const Arvore &arvore, const fs::path &copia) {
+    constexpr size_t LOTE = 32;
+    MotorES motor;
+    Vazao v;
+    v.uring = motor.usando_uring();
+    fs::create_directories(copia);
+
+    auto rodar = [&](bool hash, bool copiar) {
+        uint64_t bytes = 0;
+        auto inicio = Relogio::now();
+        for (size_t base = 0; base < arvore.relativos.size(); base += LOTE) {
+            std::vector<ArquivoLote> lote;
+            for (size_t i = base; i < std::min(base + LOTE, arvore.relativos.size()); ++i) {
+                ArquivoLote a;
+                a.origem = entrada / arvore.relativos[i];
+                if (copiar) a.destino = copia / std::to_string(i);
+                lote.push_back(std::move(a));
+            }
+            motor.executar(lote, hash, false);
+            for (auto &a : lote) {
+                if (a.erro) throw std::runtime_error("erro de E/S em " + a.origem.string() + ": " + std::strerror(a.erro));
+                bytes += a.bytes;
+            }
+        }
+        return mb_s(bytes, Relogio::now() - inicio);
+    };
+    v.hash_mb_s = rodar(true, false);
+    v.copia_mb_s = rodar(false, true);
+    fs::remove_all(copia);
+    return v;
+}
+
+// ---------------------------------------------------------------------------
+// monitor em processo filho
+
+// guarda, para cada arquivo, o instante da última captura. Duas fontes:
+//  - log de eventos do monitor-cpp: instante registrado pelo próprio monitor (o atraso
+//    da drenagem do log não conta);
+//  - store: instante em que a versão aparece com o nome definitivo (inotify), que vale
+//    para qualquer implementação do formato e é o usado nas comparações.
+class Capturas {
+public:
+    explicit Capturas(const fs::path &saida) : saida(saida), prefixo(saida.string() + "/") {}
+
+    void acompanhar_log(const fs::path &log) {
+        std::unique_ptr<LeitorEventos> leitor;
+        Evento evento;
+        while (!parar) {
+            if (!leitor) {
+                try {
+                    leitor = std::make_unique<LeitorEventos>(log);
+                } catch (const std::exception &) {
+                    // o monitor ainda não criou o log
+                }
+            }
+            bool novos = false;
+            while (leitor && leitor->proximo(evento)) {
+                if (evento.tipo == TipoEvento::VERSAO_SALVA) registrar(evento.texto, evento.instante_ns);
+                novos = true;
+            }
+            if (!novos) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    void acompanhar_store() {
+        int fd = ::inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+        if (fd < 0) throw std::runtime_error("inotify indisponível");
+        std::unordered_map<int, std::string> pastas;
+        std::function<void(const std::string &)> observar = [&](const std::string &pasta) {
+            int wd = ::inotify_add_watch(fd, pasta.c_str(), IN_CREATE | IN_MOVED_TO | IN_CLOSE_WRITE | IN_ONLYDIR);
+            if (wd < 0) return;
+            pastas[wd] = pasta;
+            // o que foi criado antes da marca
+            std::error_code ec;
+            for (auto &e : fs::directory_iterator(pasta, ec)) {
+                if (e.path().filename() == ".monitor" && pasta == saida.string()) continue;
+                if (e.is_directory(ec)) observar(e.path().string());
+                else registrar(e.path().string(), agora_ns());
+            }
+        };
+        observar(saida.string());
+
+        alignas(inotify_event) char buffer[64 * 1024];
+        while (!parar) {
+            pollfd p{fd, POLLIN, 0};
+            if (::poll(&p, 1, 50) <= 0) continue;
+            int64_t agora = agora_ns();
+            ssize_t n;
+            while ((n = ::read(fd, buffer, sizeof(buffer))) > 0) {
+                for (char *q = buffer; q < buffer + n;) {
+                    auto *ev = reinterpret_cast<inotify_event *>(q);
+                    q += sizeof(inotify_event) + ev->len;
+                    auto it = pastas.find(ev->wd);
+                    if (it == pastas.end() || ev->len == 0) continue;
+                    std::string caminho = it->second + "/" + ev->name;
+                    if (it->second == saida.string() && std::string(ev->name) == ".monitor") continue;
+                    if (ev->mask & IN_ISDIR) observar(caminho);
+                    else registrar(caminho, agora);
+                }
+            }
+        }
+        ::close(fd);
+    }
+
+    void encerrar() {
+        parar = true;
+        std::lock_guard<std::mutex> lock(mtx);
+        cv.notify_all();
+    }
+
+    // espera até todos os arquivos terem uma captura posterior ao instante indicado
+    bool aguardar(const std::unordered_map<std::string, int64_t> &alterados, Relogio::time_point limite) {
+        std::unique_lock<std::mutex> lock(mtx);
+        return cv.wait_until(lock, limite, [&] {
+            for (auto &[rel, quando] : alterados) {
+                auto it = ultima.find(rel);
+                if (it == ultima.end() || it->second < quando) return false;
+            }
+            return true;
+        });
+    }
+
+    bool aguardar_total(size_t total, Relogio::time_point limite) {
+        std::unique_lock<std::mutex> lock(mtx);
+        return cv.wait_until(lock, limite, [&] { return ultima.size() >= total; });
+    }
+
+    bool capturado_apos(const std::string &rel, int64_t quando, int64_t &captura) {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = ultima.find(rel);
+        if (it == ultima.end() || it->second < quando) return false;
+        captura = it->second;
+        return true;
+    }
+
+    static int64_t agora_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+private:
+    fs::path saida;
+    std::string prefixo;
+    std::atomic<bool> parar{false};
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::unordered_map<std::string, int64_t> ultima;
+
+    void registrar(const std::string &destino, int64_t instante_ns) {
+        if (destino.compare(0, prefixo.size(), prefixo) != 0) return;
+        std::string nome, hash;
+        if (!separar_versao(destino.substr(prefixo.size()), nome, hash)) return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        ultima[nome] = instante_ns;
+        cv.notify_all();
+    }
+};
+
+pid_t iniciar_monitor(const std::string &implementacao, const fs::path &app, const fs::path &config,
+                      const fs::path &entrada, const fs::path &saida, unsigned intervalo_ms,
+                      const fs::path &saida_monitor) {
+    pid_t pid = ::fork();
+    if (pid < 0) throw std::runtime_error("fork falhou");
+    if (pid == 0) {
+        int fd = ::open(saida_monitor.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd >= 0) {
+            ::dup2(fd, STDOUT_FILENO);
+            ::dup2(fd, STDERR_FILENO);
+        }
+        if (implementacao == "go") {
+            // o monitor-golang é configurado só pelo ambiente
+            ::setenv("MONITOR_INPUT", entrada.c_str(), 1);
+            ::setenv("MONITOR_OUTPUT", saida.c_str(), 1);
+            ::setenv("MONITOR_INTERVALO_MS", std::to_string(intervalo_ms).c_str(), 1);
+            ::execl(app.c_str(), app.c_str(), static_cast<char *>(nullptr));
+        } else {
+            ::execl(app.c_str(), app.c_str(), "--config", config.c_str(), static_cast<char *>(nullptr));
+        }
+        ::_exit(127);
+    }
+    return pid;
+}
+
+// ---------------------------------------------------------------------------
+// conformidade com FORMATO_STORE.md
+
+struct Conformidade {
+    bool formato = false;        // marcador presente e legível
+    size_t versoes = 0;
+    size_t nomes_invalidos = 0;  // fora de <relativo>_<sha256>
+    size_t hashes_invalidos = 0; // conteúdo não confere com o nome
+    size_t sem_versao = 0;       // conteúdo atual de um arquivo da árvore ausente do store
+    size_t fora_do_indice = 0;   // versão presente, mas não encontrada pelo índice do monitor-cpp
+
+    bool ok() const {
+        return formato && nomes_invalidos == 0 && hashes_invalidos == 0 && sem_versao == 0 && fora_do_indice == 0;
+    }
+};
+
+std::string sha256_hex(LeitorVersao &leitor) {
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr);
+    std::vector<char> buffer(1 << 16);
+    while (size_t n = leitor.ler(buffer.data(), buffer.size())) EVP_DigestUpdate(ctx, buffer.data(), n);
+    unsigned char hash[32];
+    unsigned int tamanho = 0;
+    EVP_DigestFinal_ex(ctx, hash, &tamanho);
+    EVP_MD_CTX_free(ctx);
+    static const char digitos[] = "0123456789abcdef";
+    std::string hex;
+    for (unsigned char b : hash) {
+        hex += digitos[b >> 4];
+        hex += digitos[b & 0xF];
+    }
+    return hex;
+}
+
+Conformidade verificar_store(const fs::path &saida, const fs::path &entrada, const Arvore &arvore) {
+    Conformidade c;
+    try {
+        verificar_formato_store(saida);
+        c.formato = fs::exists(saida / ".monitor" / "formato");
+    } catch (const std::exception &) {
+        c.formato = false;
+    }
+
+    const ChaveCripto *chave = chave_configurada();
+    std::unordered_set<std::string> salvas;
+    percorrer_versoes(saida, [&](const std::string &relativo) {
+        ++c.versoes;
+        std::string nome, hash;
+        if (!separar_versao(relativo, nome, hash)) {
+            ++c.nomes_invalidos;
+            return;
+        }
+        try {
+            LeitorVersao leitor(saida / relativo);
+            std::string calculado = sha256_hex(leitor);
+            // versões cifradas são nomeadas pelo HMAC do hash (ver hash_nome_cifrado)
+            if (calculado != hash && !(leitor.cifrada() && chave && hash_nome_cifrado(calculado, *chave) == hash))
+                ++c.hashes_invalidos;
+        } catch (const std::exception &) {
+            ++c.hashes_invalidos;
+        }
+        salvas.insert(relativo);
+    });
+
+    MotorES motor;
+    IndiceVersoes indice(saida);
+    for (size_t base = 0; base < arvore.relativos.size(); base += 32) {
+        std::vector<ArquivoLote> lote;
+        for (size_t i = base; i < std::min(base + 32, arvore.relativos.size()); ++i) {
+            ArquivoLote a;
+            a.origem = entrada / arvore.relativos[i];
+            lote.push_back(std::move(a));
+        }
+        motor.executar(lote, true, false);
+        for (size_t k = 0; k < lote.size(); ++k) {
+            const std::string &rel = arvore.relativos[base + k];
+            std::string hash = lote[k].hash;
+            if (!lote[k].erro && chave && !salvas.count(rel + "_" + hash)) hash = hash_nome_cifrado(hash, *chave);
+            if (lote[k].erro || !salvas.count(rel + "_" + hash)) {
+                ++c.sem_versao;
+                continue;
+            }
+            IndiceVersoes::Entrada e;
+            if (indice.total(rel) == 0 || !indice.buscar(rel, hash, e)) ++c.fora_do_indice;
+        }
+    }
+    return c;
+}
+
+// ---------------------------------------------------------------------------
+// execução
+
+struct Percentis {
+    size_t amostras = 0;
+    double p50 = 0, p90 = 0, p99 = 0, max = 0;
+};
+
+Percentis percentis(std::vector<double> v) {
+    Percentis p;
+    p.amostras = v.size();
+    if (v.empty()) return p;
+    std::sort(v.begin(), v.end());
+    // método do posto mais próximo
+    auto em = [&](double q) { return v[std::min(v.size() - 1, static_cast<size_t>(std::ceil(q * v.size())) - 1)]; };
+    p.p50 = em(0.50);
+    p.p90 = em(0.90);
+    p.p99 = em(0.99);
+    p.max = v.back();
+    return p;
+}
+
+std::string json_texto(const std::string &s) {
+    std::string r = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') r += '\\';
+        r += c;
+    }
+    return r + "\"";
+}
+
+std::string numero(double v) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%.3f", v);
+    return buf;
+}
+
+struct Execucao {
+    std::string implementacao;
+    std::string fonte; // log | store
+    bool completa = false;
+    Relogio::duration inicial{};
+    std::vector<double> latencias;
+    size_t perdidas = 0;
+    long pico_rss_kb = 0;
+    bool verificada = false;
+    Conformidade conformidade;
+};
+
+// captura inicial e rodadas de alteração sobre a árvore já gerada
+Execucao executar_monitor(const Opcoes &o, const std::string &implementacao, const fs::path &app,
+                          const Arvore &arvore, const fs::path &entrada, const fs::path &saida, bool pelo_store,
+                          bool verificar) {
+    Execucao r;
+    r.implementacao = implementacao;
+    r.fonte = pelo_store ? "store" : "log";
+
+    fs::path log = o.dir / ("eventos_" + implementacao + ".bin"), config = o.dir / "monitor.conf";
+    if (implementacao == "cpp") {
+        std::ofstream c(config);
+        c << "raiz " << entrada.string() << " " << saida.string() << "\n"
+          << "intervalo " << o.intervalo_ms << "\n"
+          << "eventos " << (o.eventos ? "fanotify" : "varredura") << "\n"
+          << "log " << log.string() << "\n";
+        if (o.threads) c << "threads " << o.threads << "\n";
+    }
+
+    Capturas capturas(saida);
+    std::thread leitor([&] {
+        if (pelo_store) capturas.acompanhar_store();
+        else capturas.acompanhar_log(log);
+    });
+    // a marca do inotify precisa existir antes da primeira versão
+    if (pelo_store) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    std::cerr << "⏳ Iniciando " << app << " (" << implementacao << ")" << std::endl;
+    pid_t pid = iniciar_monitor(implementacao, app, config, entrada, saida, o.intervalo_ms,
+                                o.dir / ("monitor_" + implementacao + ".out"));
+
+    auto limite = [&] {
+        return Relogio::now() + std::chrono::duration_cast<Relogio::duration>(std::chrono::duration<double>(o.limite_s));
+    };
+
+    // captura inicial: todos os arquivos da árvore
+    auto inicio = Relogio::now();
+    r.completa = capturas.aguardar_total(arvore.relativos.size(), limite());
+    r.inicial = Relogio::now() - inicio;
+
+    // as alterações usam um gerador próprio: todas as implementações recebem a mesma sequência
+    std::mt19937_64 rng(o.semente + 1);
+    std::vector<uint64_t> buffer(1 << 13);
+    for (size_t rodada = 0; r.completa && rodada < o.rodadas; ++rodada) {
+        std::cerr << "⏳ Rodada " << rodada + 1 << "/" << o.rodadas << std::endl;
+        // sem isso o mtime novo pode coincidir com o anterior em sistemas de arquivos de relógio grosso
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        std::unordered_map<std::string, int64_t> alterados;
+        for (size_t i : escolher_mutacoes(o, rng)) {
+            escrever_arquivo(entrada / arvore.relativos[i], arvore.tamanhos[i], rng, buffer);
+            alterados[arvore.relativos[i]] = Capturas::agora_ns(); // depois do close
+        }
+        capturas.aguardar(alterados, limite());
+        for (auto &[rel, quando] : alterados) {
+            int64_t captura = 0;
+            if (capturas.capturado_apos(rel, quando, captura))
+                r.latencias.push_back(static_cast<double>(captura - quando) / 1e6);
+            else
+                ++r.perdidas;
+        }
+    }
+
+    ::kill(pid, SIGTERM);
+    int status = 0;
+    struct rusage uso {};
+    ::wait4(pid, &status, 0, &uso);
+    r.pico_rss_kb = uso.ru_maxrss;
+    capturas.encerrar();
+    leitor.join();
+
+    if (verificar) {
+        std::cerr << "⏳ Verificando o store de " << implementacao << std::endl;
+        r.conformidade = verificar_store(saida, entrada, arvore);
+        r.verificada = true;
+    }
+    return r;
+}
+
+// campos de uma execução, sem as chaves do objeto
+std::string json_execucao(const Execucao &e, const Arvore &arvore, const std::string &recuo) {
+    Percentis lat = percentis(e.latencias);
+    std::string j;
+    j += recuo + "\"implementacao\": " + json_texto(e.implementacao) + ",\n";
+    j += recuo + "\"fonte_latencia\": " + json_texto(e.fonte) + ",\n";
+    j += recuo + "\"captura_inicial\": {\n";
+    j += recuo + "  \"completa\": " + std::string(e.completa ? "true" : "false") + ",\n";
+    j += recuo + "  \"segundos\": " + numero(segundos(e.inicial)) + ",\n";
+    j += recuo + "  \"mb_s\": " + numero(mb_s(arvore.bytes, e.inicial)) + "\n";
+    j += recuo + "},\n";
+    j += recuo + "\"latencia_ms\": {\n";
+    j += recuo + "  \"amostras\": " + std::to_string(lat.amostras) + ",\n";
+    j += recuo + "  \"perdidas\": " + std::to_string(e.perdidas) + ",\n";
+    j += recuo + "  \"p50\": " + numero(lat.p50) + ",\n";
+    j += recuo + "  \"p90\": " + numero(lat.p90) + ",\n";
+    j += recuo + "  \"p99\": " + numero(lat.p99) + ",\n";
+    j += recuo + "  \"max\": " + numero(lat.max) + "\n";
+    j += recuo + "},\n";
+    if (e.verificada) {
+        const Conformidade &c = e.conformidade;
+        j += recuo + "\"conformidade\": {\n";
+        j += recuo + "  \"ok\": " + std::string(c.ok() ? "true" : "false") + ",\n";
+        j += recuo + "  \"formato\": " + std::string(c.formato ? "true" : "false") + ",\n";
+        j += recuo + "  \"versoes\": " + std::to_string(c.versoes) + ",\n";
+        j += recuo + "  \"nomes_invalidos\": " + std::to_string(c.nomes_invalidos) + ",\n";
+        j += recuo + "  \"hashes_invalidos\": " + std::to_string(c.hashes_invalidos) + ",\n";
+        j += recuo + "  \"sem_versao\": " + std::to_string(c.sem_versao) + ",\n";
+        j += recuo + "  \"fora_do_indice\": " + std::to_string(c.fora_do_indice) + "\n";
+        j += recuo + "},\n";
+    }
+    j += recuo + "\"monitor_pico_rss_kb\": " + std::to_string(e.pico_rss_kb) + "\n";
+    return j;
+}
+
+bool execucao_ok(const Execucao &e) {
+    return e.completa && e.perdidas == 0 && (!e.verificada || e.conformidade.ok());
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Opcoes o;
+    try {
+        if (!ler_opcoes(argc, argv, o)) {
+            ajuda();
+            return 2;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "❌ " << e.what() << std::endl;
+        ajuda();
+        return 2;
+    }
+    if (o.app.empty()) o.app = fs::canonical("/proc/self/exe").parent_path() / "monitor_app";
+    if (!fs::exists(o.app)) {
+        std::cerr << "❌ monitor_app não encontrado em " << o.app << " (use --app)" << std::endl;
+        return 2;
+    }
+    if (!o.comparar.empty() && !fs::exists(o.comparar)) {
+        std::cerr << "❌ monitor-golang não encontrado em " << o.comparar << std::endl;
+        return 2;
+    }
+
+    fs::path entrada = o.dir / "entrada", saida = o.dir / "saida";
+    // árvore e store do zero: a mesma semente gera a mesma carga para cada implementação
+    auto preparar = [&] {
+        fs::remove_all(entrada);
+        fs::remove_all(saida);
+        fs::create_directories(entrada);
+        fs::create_directories(saida);
+        entrada = fs::canonical(entrada);
+        saida = fs::canonical(saida);
+        std::mt19937_64 rng(o.semente);
+        std::cerr << "⏳ Gerando " << o.arquivos << " arquivos em " << entrada << std::endl;
+        return gerar_arvore(o, entrada, rng);
+    };
+    fs::remove_all(o.dir);
+    Arvore arvore = preparar();
+
+    std::cerr << "⏳ Medindo varredura, hash e cópia" << std::endl;
+    Varredura varredura = medir_varredura(entrada);
+    Vazao vazao = medir_vazao(entrada, arvore, o.dir / "copia");
+
+    std::vector<Execucao> execucoes;
+    if (o.comparar.empty()) {
+        // sozinho, o monitor-cpp é medido pelo próprio log; o monitor-golang só pelo store
+        execucoes.push_back(executar_monitor(o, o.implementacao, o.app, arvore, entrada, saida,
+                                             o.implementacao == "go", o.conformidade));
+    } else {
+        // as duas pelo store, para que a latência meça a mesma coisa
+        execucoes.push_back(executar_monitor(o, "cpp", o.app, arvore, entrada, saida, true, true));
+        arvore = preparar();
+        execucoes.push_back(executar_monitor(o, "go", o.comparar, arvore, entrada, saida, true, true));
+    }
+
+    std::string j;
+    j += "{\n";
+    j += "  \"parametros\": {\n";
+    j += "    \"arquivos\": " + std::to_string(o.arquivos) + ",\n";
+    j += "    \"bytes\": " + std::to_string(arvore.bytes) + ",\n";
+    j += "    \"distribuicao\": " + json_texto(o.distribuicao) + ",\n";
+    j += "    \"tamanho_min\": " + std::to_string(o.tamanho_min) + ",\n";
+    j += "    \"tamanho_max\": " + std::to_string(o.tamanho_max) + ",\n";
+    j += "    \"padrao\": " + json_texto(o.padrao) + ",\n";
+    j += "    \"mutacoes\": " + std::to_string(o.mutacoes) + ",\n";
+    j += "    \"rodadas\": " + std::to_string(o.rodadas) + ",\n";
+    j += "    \"intervalo_ms\": " + std::to_string(o.intervalo_ms) + ",\n";
+    j += "    \"eventos\": " + json_texto(o.eventos ? "fanotify" : "varredura") + ",\n";
+    j += "    \"threads\": " + std::to_string(o.threads) + ",\n";
+    j += "    \"semente\": " + std::to_string(o.semente) + "\n";
+    j += "  },\n";
+    j += "  \"varredura\": {\n";
+    j += "    \"entradas\": " + std::to_string(varredura.entradas) + ",\n";
+    j += "    \"ms_primeira\": " + numero(varredura.ms_primeira) + ",\n";
+    j += "    \"ms_por_100k\": " + numero(varredura.ms_por_100k) + "\n";
+    j += "  },\n";
+    j += "  \"motor_es\": " + json_texto(vazao.uring ? "io_uring" : "bloqueante") + ",\n";
+    j += "  \"hash_mb_s\": " + numero(vazao.hash_mb_s) + ",\n";
+    j += "  \"copia_mb_s\": " + numero(vazao.copia_mb_s) + ",\n";
+    if (execucoes.size() == 1) {
+        j += json_execucao(execucoes[0], arvore, "  ");
+    } else {
+        for (size_t i = 0; i < execucoes.size(); ++i) {
+            j += "  " + json_texto(execucoes[i].implementacao) + ": {\n";
+            j += json_execucao(execucoes[i], arvore, "    ");
+            j += std::string("  }") + (i + 1 < execucoes.size() ? "," : "") + "\n";
+        }
+    }
+    j += "}\n";
+
+    if (o.saida.empty()) {
+        std::cout << j;
+    } else {
+        std::ofstream(o.saida) << j;
+    }
+
+    if (!o.manter) fs::remove_all(o.dir);
+    int rc = 0;
+    for (auto &e : execucoes) {
+        if (!e.completa)
+            std::cerr << "❌ " << e.implementacao << " não capturou a árvore inicial dentro do limite" << std::endl;
+        else if (e.verificada && !e.conformidade.ok())
+            std::cerr << "❌ O store de " << e.implementacao << " não segue FORMATO_STORE.md" << std::endl;
+        if (!execucao_ok(e)) rc = 1;
+    }
+    return rc;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+// Filtro de Bloom em blocos (cada chave toca uma única linha de cache de 512 bits),
+// persistido em arquivo e mapeado com mmap: as inserções vão para o disco pelo
+// próprio kernel, sem reescrever o filtro inteiro. Responde "com certeza não existe"
+// sem E/S; um "talvez" ainda precisa ser confirmado no disco.
+class FiltroBloom {
+public:
+    FiltroBloom() = default;
+    ~FiltroBloom();
+
+    FiltroBloom(const FiltroBloom &) = delete;
+    FiltroBloom &operator=(const FiltroBloom &) = delete;
+
+    // abre o filtro existente; retorna false se o arquivo não existir ou for inválido
+    bool abrir(const std::filesystem::path &arquivo);
+
+    // cria um filtro vazio dimensionado para `capacidade` chaves (substitui o arquivo)
+    void criar(const std::filesystem::path &arquivo, uint64_t capacidade);
+
+    void adicionar(std::string_view chave);
+    bool talvez_contem(std::string_view chave) const;
+
+    bool aberto() const { return cabecalho != nullptr; }
+    uint64_t chaves() const;
+    uint64_t capacidade() const;
+    bool cheio() const { return aberto() && chaves() > capacidade(); }
+
+private:
+    struct Cabecalho {
+        char magica[4];
+        uint32_t versao;
+        uint64_t blocos;
+        uint64_t capacidade;
+        uint64_t chaves;
+        uint64_t reservado[4];
+    };
+
+    static constexpr size_t BYTES_BLOCO = 64;
+
+    Cabecalho *cabecalho = nullptr;
+    uint64_t *bits = nullptr;
+    size_t tamanho_mapa = 0;
+
+    void fechar();
+    bool mapear(int fd, size_t tamanho);
+};
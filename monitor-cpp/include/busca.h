@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <ostream>
+#include <string>
+
+struct OpcoesBusca {
+    std::string padrao;
+    bool regex = false;    // padrao é uma expressão regular (ECMAScript) em vez de texto literal
+    unsigned threads = 0;  // 0 = número de núcleos
+};
+
+// Procura o padrão em todas as versões do store, em paralelo.
+// Versões com o mesmo hash têm o mesmo conteúdo e são lidas uma única vez; cada
+// ocorrência é reportada para todos os arquivos que compartilham aquele conteúdo.
+// As ocorrências são impressas à medida que cada trecho da versão é lido, sem ordem
+// entre versões diferentes; a data é a da captura registrada no índice. Uma linha maior
+// que o buffer de leitura (1 MiB) é procurada em pedaços e pode ter mais de uma
+// ocorrência reportada. Retorna o número de ocorrências impressas.
+size_t buscar_versoes(const std::filesystem::path &backup_dir, const OpcoesBusca &opcoes, std::ostream &saida);
@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Cache do SHA-256 dos arquivos monitorados no atributo estendido user.monitor.sha256
+// do próprio arquivo de origem, para que reinícios e outras ferramentas não precisem
+// reler arquivos que não mudaram. O valor é texto, legível com getfattr:
+//   "1 <sha256 hex> <inode> <tamanho> <mtime ns> <ctime ns>"
+// O hash só vale enquanto inode, tamanho e mtime forem os mesmos do cálculo. Como a
+// própria gravação do atributo atualiza o ctime, o campo ctime guarda o instante da
+// gravação: um ctime posterior (chmod, novo link, conteúdo alterado com mtime
+// restaurado) invalida o cache. Atributo ausente, inválido ou vencido = hash normal.
+// Falhas ao gravar (sistema de arquivos sem xattr, sem permissão) são ignoradas.
+// MONITOR_XATTR=0 desliga o cache.
+
+struct IdentidadeArquivo {
+    uint64_t dispositivo = 0;
+    uint64_t inode = 0;
+    uint64_t tamanho = 0;
+    int64_t mtime_ns = 0;
+    int64_t ctime_ns = 0;
+};
+
+// stat do arquivo; false se não existir
+bool identificar_arquivo(const std::filesystem::path &arquivo, IdentidadeArquivo &saida);
+
+// hash gravado no atributo, se ainda corresponder a `atual`
+bool hash_em_cache(const std::filesystem::path &arquivo, const IdentidadeArquivo &atual, std::string &hash);
+
+// grava o hash calculado a partir do conteúdo lido quando o arquivo tinha a identidade
+// `lida`; não grava se o arquivo mudou desde então ou se foi modificado há muito pouco
+// tempo (uma escrita no mesmo tique do relógio não alteraria o mtime)
+void guardar_hash(const std::filesystem::path &arquivo, const IdentidadeArquivo &lida, const std::string &hash);
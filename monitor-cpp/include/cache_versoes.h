@@ -0,0 +1,22 @@
+#pragma once
+#include <filesystem>
+
+// Cache de versões materializadas para restaurações repetidas.
+// Na primeira restauração de uma versão, o conteúdo original (já decifrado, se for o
+// caso) é copiado para um diretório em tmpfs e conferido com o SHA-256 do nome. As
+// seguintes copiam dali, sem passar pelo store nem pelo AES-GCM. As entradas se chamam
+// <sha256>: o mesmo conteúdo, em qualquer arquivo ou store, ocupa uma entrada só.
+//
+// O cache é desligado por padrão: MONITOR_CACHE_VERSOES=<MiB> o liga com esse orçamento.
+// O diretório é $XDG_RUNTIME_DIR/monitor-versoes ou /dev/shm/monitor-versoes-<uid>,
+// acessível só ao dono (0700). Se não for, o cache fica desligado. O mtime de cada
+// entrada marca o último uso. Entradas sem uso há uma hora são removidas no primeiro
+// acesso de cada processo e a cada inserção; ao inserir, as menos usadas também saem
+// até o total caber no orçamento.
+// Versões cifradas só entram com MONITOR_CACHE_VERSOES_CIFRADAS=1: o conteúdo decifrado
+// ficaria em claro na memória, fora do controle da chave.
+
+// caminho de uma cópia materializada da versão, criada agora se ainda não existir;
+// vazio se o cache estiver desligado, a versão não couber ou a cópia falhar, e quem
+// chama lê do store normalmente
+std::filesystem::path versao_materializada(const std::filesystem::path &versao);
@@ -0,0 +1,82 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Criptografia das versões em repouso (AES-256-GCM via OpenSSL EVP, que usa AES-NI
+// quando disponível).
+//
+// Formato de uma versão cifrada:
+//   cabeçalho: "MONENC01" (8) | nonce base (12) | reservado (4)
+//   segmentos: até 64 KiB de texto cifrado + tag GCM (16), cada um com nonce próprio
+//              (nonce base XOR índice) e AAD = índice (u64) + marca de último segmento
+// Segmentos independentes permitem ler em fluxo verificando a autenticidade a cada
+// 64 KiB, e a marca de último segmento detecta arquivos truncados.
+
+using ChaveCripto = std::array<unsigned char, 32>;
+
+constexpr size_t TAMANHO_SEGMENTO_CRIPTO = 64 * 1024;
+constexpr size_t TAMANHO_CABECALHO_CRIPTO = 24;
+constexpr size_t TAMANHO_TAG_CRIPTO = 16;
+
+// chave configurada pela variável de ambiente MONITOR_CHAVE (caminho de um arquivo com
+// 32 bytes ou 64 dígitos hexadecimais); nullptr se a criptografia estiver desligada
+const ChaveCripto *chave_configurada();
+
+// true se o conteúdo começa com o cabeçalho de versão cifrada
+bool cabecalho_cifrado(const unsigned char *dados, size_t n);
+
+// tamanho do texto claro de uma versão cifrada com `tamanho_cifrado` bytes no disco
+uint64_t tamanho_decifrado(uint64_t tamanho_cifrado);
+
+// o inverso: bytes no disco da versão cifrada de `tamanho_claro` bytes
+uint64_t tamanho_cifrado(uint64_t tamanho_claro);
+
+class SomasEmFluxo;
+
+// lê a origem uma única vez calculando o SHA-256 do texto claro e gravando a versão
+// cifrada em `destino`; retorna o hash hexadecimal e o tamanho do texto claro.
+// `somas`, se houver, recebe os bytes gravados (integridade.h)
+std::string capturar_cifrado(const std::filesystem::path &origem, const std::filesystem::path &destino,
+                             const ChaveCripto &chave, uint64_t &tamanho, SomasEmFluxo *somas = nullptr);
+
+// Hash usado no nome (e no índice) de uma versão cifrada: HMAC-SHA256 do SHA-256 do
+// texto claro, com uma chave derivada da chave mestra. Com o SHA-256 puro no nome,
+// quem lê o store confirmaria se um conteúdo conhecido está salvo; o HMAC mantém o nome
+// determinístico, então conteúdos iguais continuam com uma versão só. Recebe e
+// devolve hexadecimal; o SHA-256 vem do cálculo normal (ou do atributo de cache).
+std::string hash_nome_cifrado(const std::string &sha256_hex, const ChaveCripto &chave);
+
+// decifra uma versão segmento a segmento
+class DecifradorVersao {
+public:
+    // entrega até n bytes do texto cifrado, em ordem; 0 no fim
+    using Fonte = std::function<size_t(unsigned char *destino, size_t n)>;
+
+    DecifradorVersao(int fd, const ChaveCripto &chave);
+    DecifradorVersao(Fonte fonte, const ChaveCripto &chave);
+    ~DecifradorVersao();
+
+    DecifradorVersao(const DecifradorVersao &) = delete;
+    DecifradorVersao &operator=(const DecifradorVersao &) = delete;
+
+    size_t ler(char *destino, size_t n);
+
+private:
+    Fonte fonte;
+    void *ctx;
+    ChaveCripto chave;
+    unsigned char nonce_base[12];
+    uint64_t segmento = 0;
+    bool ultimo_lido = false;
+    std::vector<unsigned char> cifrado;
+    std::vector<unsigned char> claro;
+    size_t pos_claro = 0;
+    int espiado = -1; // byte lido além do segmento para saber se ele é o último
+
+    size_t ler_cheio(unsigned char *destino, size_t n);
+    bool proximo_segmento();
+};
@@ -0,0 +1,13 @@
+#pragma once
+#include <filesystem>
+#include <ostream>
+
+// Compara duas versões armazenadas lendo ambas em fluxo, com memória limitada.
+// Trechos idênticos são descartados bloco a bloco, sem quebrar em linhas; só a região
+// que difere passa pelo diff de linhas (Myers, em janelas de até 4096 linhas e 16 MiB).
+// Uma linha com mais de 64 KiB é quebrada em pedaços de 64 KiB, e cada pedaço conta
+// como uma linha na numeração dos trechos. Conteúdo binário é comparado por blocos e
+// reportado como faixas de bytes.
+// Retorna true se as versões forem idênticas.
+bool diff_versoes(const std::filesystem::path &versao_a, const std::filesystem::path &versao_b,
+                  std::ostream &saida);
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+// Escreve em `fd` um tar (ustar, com cabeçalhos pax para caminhos longos e arquivos
+// acima de 8 GiB) com a versão de cada arquivo vigente em `instante_ns`: a captura
+// mais recente feita até aquele momento. O mtime no tar é o do arquivo de origem.
+// Versões com somas (integridade.h) passam pelo LeitorVersao, que confere cada bloco
+// antes de ele ir para a saída e reconstrói pela paridade o que não conferir; as cifradas
+// são decifradas no mesmo fluxo. Só as versões sem somas vão do store para a saída sem
+// passar pelo espaço do usuário: splice quando a saída é um pipe, sendfile nos demais.
+// Remoções não são registradas pelo monitor, então um arquivo apagado antes do
+// instante ainda aparece com sua última versão.
+// Retorna o número de arquivos exportados.
+size_t exportar_tar(const std::filesystem::path &backup_dir, int64_t instante_ns, int fd);
+
+struct ResultadoSnapshot {
+    size_t clonados = 0; // reflink (FICLONE): cópia sob demanda, independente do store
+    size_t ligados = 0;  // hard link para a própria versão no store
+    size_t copiados = 0; // versões cifradas (decifradas) e versões no limite de links
+};
+
+// Materializa em `destino` (novo ou vazio, no mesmo sistema de arquivos do store) a
+// árvore vigente em `instante_ns`, com as mesmas regras de exportar_tar, sem copiar
+// dados: cada arquivo é um reflink da versão quando o sistema de arquivos permite
+// (btrfs, xfs) e um hard link nos demais. Um hard link é o mesmo inode da versão:
+// editar o arquivo no snapshot alteraria o store, então esses arquivos devem ser só
+// lidos. Clones e cópias recebem o mtime do arquivo de origem; hard links mantêm o da
+// versão. Versões cifradas precisam ser decifradas e são as únicas copiadas.
+ResultadoSnapshot criar_snapshot(const std::filesystem::path &backup_dir, int64_t instante_ns,
+                                 const std::filesystem::path &destino);
+
+struct ResultadoRestauracao {
+    size_t arquivos = 0;
+    uint64_t bytes = 0;
+    size_t erros = 0;
+    bool fiemap = false; // a ordem veio da posição física; senão, do número do inode
+};
+
+// Restaura em `destino` a árvore vigente em `instante_ns` (mesmas regras de
+// exportar_tar), substituindo os arquivos que já existirem. As versões são lidas na
+// ordem em que estão no disco: a posição física do primeiro extent de cada uma (FIEMAP)
+// ou, sem FIEMAP, o número do inode, que acompanha a ordem de alocação. Os trabalhadores
+// pegam lotes consecutivos dessa ordem, cada um com seu MotorES, e pedem ao kernel a
+// leitura antecipada do lote seguinte enquanto copiam o atual, de modo que o disco vê
+// uma varredura quase sequencial. Cada arquivo é gravado com um nome temporário na
+// mesma pasta e só substitui o destino (rename) depois de completo: se a versão não
+// puder ser lida, decifrada ou gravada, o arquivo atual fica como estava. O SHA-256
+// calculado durante a cópia precisa ser o do nome da versão; se não for, a versão é
+// copiada de novo pelo LeitorVersao, que reconstrói em memória pela paridade o bloco
+// que não conferir com as somas, e a nova cópia é conferida pelo mesmo SHA-256. O store
+// não é regravado aqui, isso é papel do --verify. O rename também evita escrever
+// através de um hard link (um snapshot, por exemplo) no store.
+// Um único syncfs no fim torna tudo durável.
+ResultadoRestauracao restaurar_arvore(const std::filesystem::path &backup_dir, int64_t instante_ns,
+                                      const std::filesystem::path &destino, unsigned threads = 0);
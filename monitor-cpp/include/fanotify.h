@@ -0,0 +1,41 @@
+#pragma once
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// Fonte de eventos fanotify que cobre sistemas de arquivos inteiros.
+// Cada sistema de arquivos que contém uma das pastas recebe uma única marca
+// FAN_MARK_FILESYSTEM, com eventos identificados por handle do diretório pai + nome
+// (FAN_REPORT_DFID_NAME): não há nenhuma configuração por diretório, então o custo
+// não cresce com o número de pastas. O handle é convertido em caminho com
+// open_by_handle_at, o que exige CAP_SYS_ADMIN e CAP_DAC_READ_SEARCH.
+class FonteFanotify {
+public:
+    // lança std::system_error se o kernel ou as permissões não permitirem
+    explicit FonteFanotify(const std::vector<std::filesystem::path> &pastas);
+    ~FonteFanotify();
+
+    FonteFanotify(const FonteFanotify &) = delete;
+    FonteFanotify &operator=(const FonteFanotify &) = delete;
+
+    // espera até `espera` por eventos e acrescenta em `saida` os caminhos de arquivos
+    // fechados depois de escritos e de entradas criadas ou movidas (diretórios inclusive),
+    // e em `modificados` os de arquivos escritos que ainda não foram fechados.
+    // retorna false se a fila do kernel transbordou (eventos perdidos: varrer tudo)
+    bool aguardar(std::chrono::milliseconds espera, std::vector<std::filesystem::path> &saida,
+                  std::vector<std::filesystem::path> &modificados);
+
+private:
+    struct Montagem {
+        uint64_t fsid;
+        int fd; // qualquer diretório do sistema de arquivos, para open_by_handle_at
+    };
+
+    int fd = -1;
+    std::vector<Montagem> montagens;
+    std::vector<char> buffer;
+
+    void marcar(const std::vector<std::filesystem::path> &pastas);
+    std::string resolver_diretorio(uint64_t fsid, const void *handle);
+};
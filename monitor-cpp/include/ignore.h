@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Regras de exclusão no estilo .gitignore compiladas em uma trie de componentes.
+// Cada regra é quebrada em componentes de caminho; componentes literais, "*sufixo"
+// e "prefixo*" viram consultas em tabelas hash, então o custo por componente não
+// cresce com o número de regras. Os demais globs são agrupados pelos trechos literais
+// que ocupam posição fixa a partir do início e do fim do nome ("log-?-*.t?t" exige
+// "log-" no início e "t" no penúltimo caractere): cada componente só passa pelo
+// fnmatch dos padrões do grupo em que cai. A avaliação é feita componente a componente
+// durante a varredura: o estado de um diretório é o conjunto de nós da trie ainda ativos.
+// Um .monitorignore em uma subpasta vale para o que está abaixo dela, como os
+// .gitignore aninhados: suas regras entram na mesma trie precedidas do caminho da
+// pasta e, carregadas depois das regras das pastas acima, prevalecem sobre elas.
+class FiltroIgnorar {
+public:
+    static constexpr const char *NOME_ARQUIVO = ".monitorignore";
+
+    // conjunto de nós ativos da trie para um diretório já visitado
+    struct Estado {
+        std::vector<uint32_t> nos;
+    };
+
+    FiltroIgnorar();
+
+    // adiciona uma linha no formato .gitignore (comentários e linhas vazias são aceitos);
+    // `base` é a pasta do arquivo de regras, relativa à raiz ('/' como separador)
+    void adicionar_regra(std::string_view linha, std::string_view base = {});
+
+    // carrega as regras de um arquivo; retorna false se o arquivo não existir
+    bool carregar(const std::filesystem::path &arquivo, std::string_view base = {});
+
+    // carrega o .monitorignore de `raiz` e os das subpastas que ele não exclui, cada
+    // pasta antes das suas subpastas; retorna quantos arquivos foram lidos
+    size_t carregar_arvore(const std::filesystem::path &raiz);
+
+    size_t total_regras() const { return regras.size(); }
+
+    // estado da raiz monitorada
+    Estado estado_inicial() const;
+
+    // avalia um componente do caminho a partir do estado do diretório pai.
+    // retorna true se o componente deve ser ignorado; em caso contrário preenche
+    // o estado que deve ser usado para os filhos (apenas relevante para diretórios)
+    bool ignorado(const Estado &pai, std::string_view nome, bool diretorio, Estado &filho) const;
+
+private:
+    static constexpr uint32_t NENHUM = UINT32_MAX;
+
+    struct Regra {
+        bool negar;
+        bool so_diretorio;
+    };
+
+    // posição dos trechos literais usados como chave de um glob: `tamanho_inicio`
+    // caracteres a `deslocamento_inicio` do início do nome e `tamanho_fim` caracteres
+    // terminando a `deslocamento_fim` do fim (tamanho 0: sem trecho)
+    struct FormaGlob {
+        size_t deslocamento_inicio = 0, tamanho_inicio = 0;
+        size_t deslocamento_fim = 0, tamanho_fim = 0;
+        bool operator==(const FormaGlob &) const = default;
+    };
+
+    struct No {
+        std::unordered_map<std::string, uint32_t> literais;
+        std::unordered_map<std::string, uint32_t> sufixos;  // "*sufixo"
+        std::unordered_map<std::string, uint32_t> prefixos; // "prefixo*"
+        std::vector<size_t> tamanhos_sufixo;
+        std::vector<size_t> tamanhos_prefixo;
+        // demais padrões (fnmatch), pela chave dos trechos literais (ver chave_glob)
+        std::unordered_map<std::string, std::vector<std::pair<std::string, uint32_t>>> globs;
+        std::vector<FormaGlob> formas_glob;
+        uint32_t duplo = NENHUM;                             // "**"
+        int32_t regra = -1;                                  // última regra que termina aqui
+        int32_t regra_dir = -1;                              // última regra "dir/" que termina aqui
+    };
+
+    std::vector<No> nos;
+    std::vector<Regra> regras;
+
+    uint32_t novo_no();
+    uint32_t filho_para(uint32_t no, const std::string &componente, bool literal = false);
+    Estado estado_de(std::string_view relativo) const;
+    static FormaGlob forma_glob(std::string_view padrao, std::string &chave);
+    static bool chave_glob(const FormaGlob &forma, std::string_view nome, std::string &chave);
+    void fechar(std::vector<uint32_t> &conjunto, uint32_t no) const;
+    void avancar(uint32_t no, std::string_view nome, std::vector<uint32_t> &saida) const;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+struct MetadadosVersao {
+    int64_t captura_ns = 0;      // momento da captura (system_clock, ns desde a época)
+    uint64_t tamanho = 0;        // bytes do conteúdo original
+    int64_t mtime_origem_ns = 0; // mtime do arquivo de origem quando foi capturado
+    uint32_t modo = 0;           // permissões do arquivo de origem; 0 = desconhecidas
+};
+
+// data/hora local no formato "AAAA-MM-DD HH:MM:SS"
+std::string formatar_instante(int64_t ns);
+
+// inverso de formatar_instante; aceita também "AAAA-MM-DDTHH:MM:SS", "AAAA-MM-DD"
+// (meia-noite) e segundos desde a época. false se o texto não estiver em nenhum formato
+bool interpretar_instante(const std::string &texto, int64_t &ns);
+
+// Índice de versões por arquivo, em .monitor/indice/<caminho>.idx.
+// Cada arquivo de índice tem um cabeçalho fixo seguido de registros de tamanho fixo
+// na ordem de captura (que é a ordem cronológica), então uma página de --list é um
+// único pread, independente de quantas versões o arquivo tenha.
+class IndiceVersoes {
+public:
+    struct Entrada {
+        MetadadosVersao meta;
+        std::string hash;
+    };
+
+    explicit IndiceVersoes(const std::filesystem::path &backup_dir);
+
+    // acrescenta uma versão; ignora repetição do último registro (replay do journal)
+    void adicionar(const std::string &nome, const std::string &hash, const MetadadosVersao &meta);
+
+    // número de versões registradas; cria o índice a partir do store se ainda não existir
+    size_t total(const std::string &nome);
+
+    // lê `quantidade` entradas a partir da posição `inicio` (0 = mais antiga)
+    std::vector<Entrada> ler(const std::string &nome, size_t inicio, size_t quantidade);
+
+    // procura a captura mais recente de um hash específico
+    bool buscar(const std::string &nome, const std::string &hash, Entrada &saida);
+
+private:
+    std::filesystem::path backup_dir;
+    std::filesystem::path dir_indice;
+
+    std::filesystem::path arquivo_indice(const std::string &nome) const;
+    void reconstruir(const std::string &nome);
+};
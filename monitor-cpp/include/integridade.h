@@ -0,0 +1,136 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Integridade das versões por bloco.
+// Cada versão capturada ganha um arquivo de somas em
+// .monitor/integridade/<caminho relativo da versão>.crc:
+//   cabeçalho: "MONCRC01" (8) | tamanho do bloco (u32) | blocos por grupo de paridade
+//              (u32, 0 = sem paridade) | tamanho da versão (u64) | mtime da versão (ns, u64)
+//   CRC32C de cada bloco (u32), seguido do CRC32C do cabeçalho e da tabela (u32)
+//   paridade: para cada grupo, o XOR dos seus blocos (o último completado com zeros)
+// As somas valem para os bytes gravados no store (a forma cifrada, se for o caso). O
+// mtime identifica o arquivo descrito: somas de outro arquivo com o mesmo nome (uma
+// captura interrompida, um store copiado sem preservar tempos) são ignoradas.
+// As leituras pelo LeitorVersao passam pelo LeitorConferido, que confere cada bloco
+// quando ele é lido e reconstrói em memória, pela paridade do grupo, o que não conferir;
+// sem reparo possível a leitura falha naquele bloco. A exportação tar lê assim as versões
+// com somas e só manda as sem somas pelo kernel (ver exportar.h). Só o --verify
+// (conferir_store) regrava o store: o bloco reconstruído volta para a própria versão,
+// sem coordenação com outros leitores, por isso nenhuma leitura comum escreve nela.
+// MONITOR_PARIDADE=<blocos por grupo> liga a paridade nas versões novas (16 custa
+// 1/16 do tamanho); sem a variável só as somas são gravadas.
+
+constexpr uint32_t TAMANHO_BLOCO_INTEGRIDADE = 64 * 1024;
+
+// CRC32C (Castagnoli); com SSE4.2 usa a instrução crc32 do processador.
+// `crc` é o valor de um trecho anterior, para continuar o cálculo (0 no início)
+uint32_t crc32c(uint32_t crc, const void *dados, size_t n);
+
+// blocos por grupo de paridade configurados em MONITOR_PARIDADE; 0 = sem paridade
+uint32_t grupo_paridade_configurado();
+
+// caminho das somas da versão `relativo` (nome_hash relativo ao store)
+std::filesystem::path arquivo_integridade(const std::filesystem::path &backup_dir, const std::string &relativo);
+
+// lê `conteudo` e grava as somas (e a paridade, com `grupo` > 0) em `somas`, de forma
+// atômica; lança std::runtime_error em caso de erro
+void gravar_integridade(const std::filesystem::path &conteudo, const std::filesystem::path &somas, uint32_t grupo);
+
+// Somas calculadas enquanto a versão é gravada, sem reler o arquivo: quem grava entrega a
+// atualizar() os bytes na ordem em que vão para o disco (o MotorES e capturar_cifrado
+// fazem isso) e concluir() publica o arquivo de somas. A paridade é gravada em
+// `temporario` à medida que cada grupo se completa, na posição que `tamanho_previsto`
+// indica; se a versão acabar com outro tamanho, concluir() só a desloca.
+class SomasEmFluxo {
+public:
+    SomasEmFluxo(std::filesystem::path temporario, uint32_t grupo, uint64_t tamanho_previsto);
+    ~SomasEmFluxo(); // remove o temporário se concluir() não o publicou
+
+    SomasEmFluxo(const SomasEmFluxo &) = delete;
+    SomasEmFluxo &operator=(const SomasEmFluxo &) = delete;
+
+    void atualizar(const void *dados, size_t n);
+
+    // grava em `somas` as somas de `versao`, que precisa ter exatamente os bytes entregues;
+    // lança std::runtime_error se não tiver ou se a gravação falhar
+    void concluir(const std::filesystem::path &versao, const std::filesystem::path &somas);
+
+private:
+    std::filesystem::path temporario;
+    uint32_t grupo;
+    size_t blocos_previstos;
+    int fd = -1;
+    int erro = 0; // errno da primeira gravação de paridade que falhou
+    std::vector<uint32_t> crcs;
+    uint32_t crc_atual = 0;
+    size_t no_bloco = 0; // bytes do bloco em andamento
+    uint64_t total = 0;
+    std::vector<unsigned char> paridade; // XOR do grupo em andamento
+
+    void abrir();
+    void fechar_bloco();
+    void gravar_paridade(size_t indice_grupo);
+};
+
+struct VerificacaoVersao {
+    bool com_somas = false; // versão sem somas válidas não é conferida
+    size_t blocos = 0;
+    size_t reparados = 0;
+};
+
+// confere a versão com suas somas; com `reparar`, regrava o que a paridade permitir.
+// Lança std::runtime_error se restar bloco corrompido
+VerificacaoVersao conferir_versao(const std::filesystem::path &versao, bool reparar = false);
+
+// só o cabeçalho das somas, sem ler o conteúdo: lança std::runtime_error se o tamanho
+// da versão não for o registrado (uma versão truncada)
+void conferir_tamanho(const std::filesystem::path &versao);
+
+// Leitura de uma versão que confere cada bloco com as somas no momento em que ele é lido,
+// sem uma passada extra pelo arquivo. Um bloco que não confere é reconstruído em memória
+// pela paridade e entregue correto (o store não é alterado); sem reparo, ler() lança
+// std::runtime_error com o trecho corrompido. Sem somas válidas, entrega os bytes como estão.
+class LeitorConferido {
+public:
+    // `fd` continua sendo do chamador; lança std::runtime_error se o tamanho da versão não
+    // for o registrado nas somas
+    LeitorConferido(int fd, const std::filesystem::path &versao);
+    ~LeitorConferido();
+
+    LeitorConferido(const LeitorConferido &) = delete;
+    LeitorConferido &operator=(const LeitorConferido &) = delete;
+
+    // lê até n bytes a partir de `pos`; menos só no fim da versão
+    size_t ler(void *destino, size_t n, uint64_t pos);
+
+    bool com_somas() const { return estado != nullptr; }
+    size_t reconstruidos() const { return total_reconstruidos; }
+
+private:
+    struct Estado;
+
+    int fd;
+    std::filesystem::path versao;
+    std::unique_ptr<Estado> estado; // nulo sem somas
+    std::vector<unsigned char> bloco;
+    size_t bloco_carregado = SIZE_MAX;
+    size_t total_reconstruidos = 0;
+
+    void ler_trecho(unsigned char *destino, size_t n, uint64_t pos);
+    void conferir_bloco(size_t indice, unsigned char *dados);
+};
+
+struct ResultadoConferencia {
+    size_t conferidas = 0;
+    size_t sem_somas = 0;
+    size_t reparadas = 0;   // versões com algum bloco reconstruído pela paridade
+    size_t corrompidas = 0; // versões com dano que a paridade não cobre (listadas em stderr)
+};
+
+// confere todas as versões do store (o --verify)
+ResultadoConferencia conferir_store(const std::filesystem::path &backup_dir);
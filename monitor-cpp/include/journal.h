@@ -0,0 +1,62 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "indice.h"
+
+// Group commit das versões gravadas no backup.
+// Cada versão é escrita primeiro em .monitor/pendentes/<seq> e registrada no journal
+// (.monitor/journal) sem sincronizar. Quando o grupo enche (ou no fim de cada varredura)
+// um único syncfs torna duráveis todos os dados e o journal; só então o marcador de
+// commit é gravado e os pendentes são renomeados para o nome definitivo (nome_hash).
+// Assim um arquivo com nome de hash nunca fica truncado após uma queda de energia.
+// Os metadados de cada versão seguem no journal e entram no índice na publicação.
+class JournalVersoes {
+public:
+    explicit JournalVersoes(const std::filesystem::path &backup_dir, size_t tamanho_grupo = 256);
+    ~JournalVersoes();
+
+    JournalVersoes(const JournalVersoes &) = delete;
+    JournalVersoes &operator=(const JournalVersoes &) = delete;
+
+    // refaz renomeações já confirmadas e descarta versões que não chegaram ao commit
+    void recuperar();
+
+    // caminho temporário onde a próxima versão deve ser escrita
+    std::filesystem::path proximo_pendente();
+
+    // registra a versão escrita em `pendente`, que será publicada em `destino`
+    void adicionar(const std::filesystem::path &pendente, const std::filesystem::path &destino,
+                   const MetadadosVersao &meta);
+
+    // registra uma nova captura de um conteúdo que já está no store em `destino` (o
+    // arquivo voltou a uma versão anterior): nada a publicar, só a entrada do índice
+    void registrar_existente(const std::filesystem::path &destino, const MetadadosVersao &meta);
+
+    // torna duráveis e publica todas as versões pendentes
+    void confirmar();
+
+    size_t pendentes() const { return grupo.size(); }
+
+private:
+    struct Entrada {
+        std::filesystem::path pendente; // vazio: versão já publicada, só entra no índice
+        std::filesystem::path destino;
+        MetadadosVersao meta;
+    };
+
+    std::filesystem::path backup_dir;
+    std::filesystem::path dir_pendentes;
+    std::filesystem::path caminho_journal;
+    size_t tamanho_grupo;
+    int fd_backup = -1;
+    int fd_journal = -1;
+    unsigned long long sequencia = 0;
+    std::vector<Entrada> grupo;
+    IndiceVersoes indice;
+
+    void escrever(const std::string &registro);
+    void sincronizar(const std::vector<Entrada> &entradas, bool diretorios);
+    void publicar(const std::vector<Entrada> &entradas);
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+
+class DecifradorVersao;
+class LeitorConferido;
+
+// Leitura sequencial do conteúdo de uma versão armazenada.
+// Todo código que consome versões (diff, busca, restauração) passa por aqui, de modo
+// que o formato físico do arquivo no store fica escondido atrás de ler(). Os bytes do
+// store vêm do LeitorConferido (integridade.h): cada bloco é conferido com as somas
+// quando é lido, e um erro aparece em ler(), no bloco corrompido.
+class LeitorVersao {
+public:
+    explicit LeitorVersao(const std::filesystem::path &arquivo);
+    ~LeitorVersao();
+
+    LeitorVersao(const LeitorVersao &) = delete;
+    LeitorVersao &operator=(const LeitorVersao &) = delete;
+
+    // lê até n bytes; retorna 0 no fim do conteúdo
+    size_t ler(char *destino, size_t n);
+
+    bool cifrada() const { return decifrador != nullptr; }
+
+    // a versão tem somas válidas, então tudo o que ler() entrega foi conferido
+    bool conferida() const;
+
+private:
+    int fd = -1;
+    std::unique_ptr<LeitorConferido> conferido;
+    uint64_t posicao = 0; // no arquivo do store
+    std::unique_ptr<DecifradorVersao> decifrador;
+
+    size_t ler_store(unsigned char *destino, size_t n);
+};
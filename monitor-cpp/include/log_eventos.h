@@ -0,0 +1,100 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Log binário de eventos do monitor.
+// registrar_evento() não faz E/S nem trava: cada thread grava registros compactos em
+// seu próprio anel (produtor único, consumidor único, 1 MiB) e a thread de um
+// LogEventos ativo os drena periodicamente para um arquivo que é rotacionado por
+// tamanho. Se o anel de uma thread encher, o registro é descartado e contado; a
+// captura nunca espera pelo log. Sem LogEventos ativo o evento vai direto para a
+// saída padrão, já formatado.
+//
+// Formato do arquivo: "MONLOG01" seguido de registros
+//   uint32 tamanho (cabeçalho + texto) | uint16 tipo | uint16 errno | int64 instante (ns, Unix) |
+//   uint64 bytes | texto UTF-8 sem terminador
+// em little-endian. Dentro de cada drenagem os registros saem em ordem de instante.
+
+enum class TipoEvento : uint16_t {
+    VERSAO_SALVA = 1, // texto: destino da versão; bytes: tamanho original
+    ERRO_LEITURA = 2, // texto: arquivo de origem; errno
+    ERRO_COPIA = 3,   // texto: destino da versão; errno
+    ERRO = 4,         // texto: mensagem
+    DESCARTADOS = 5,  // bytes: registros perdidos porque um anel encheu
+    VERSAO_MOVIDA = 6, // texto: destino, '\n', versão existente ligada a ele; bytes: tamanho original
+};
+
+struct Evento {
+    TipoEvento tipo = TipoEvento::ERRO;
+    int erro = 0;
+    int64_t instante_ns = 0;
+    uint64_t bytes = 0;
+    std::string texto;
+};
+
+void registrar_evento(TipoEvento tipo, std::string_view texto, uint64_t bytes = 0, int erro = 0);
+
+// uma linha legível, sem quebra no final
+std::string formatar_evento(const Evento &evento);
+
+class LogEventos {
+public:
+    // lança std::runtime_error se o arquivo não puder ser aberto; ao passar de
+    // `tamanho_maximo` o arquivo vira <arquivo>.1 e os antigos sobem até <arquivo>.<copias>
+    explicit LogEventos(const std::filesystem::path &arquivo, uint64_t tamanho_maximo = 64ull << 20,
+                        unsigned copias = 4);
+    // drena o que ainda estiver nos anéis antes de fechar
+    ~LogEventos();
+
+    LogEventos(const LogEventos &) = delete;
+    LogEventos &operator=(const LogEventos &) = delete;
+
+    // grava no arquivo tudo o que foi registrado até agora
+    void drenar();
+
+private:
+    std::filesystem::path arquivo;
+    uint64_t tamanho_maximo;
+    unsigned copias;
+    int fd = -1;
+    uint64_t tamanho = 0;
+
+    std::mutex mutex; // serializa drenagens (thread própria e drenar())
+    std::mutex mutex_espera;
+    std::condition_variable cv;
+    bool encerrar = false;
+    std::thread thread;
+
+    void abrir();
+    void rotacionar();
+};
+
+// Lê um arquivo de log. Pode acompanhar um arquivo que ainda está sendo escrito:
+// proximo() devolve false no fim dos dados completos e pode ser chamado de novo
+// depois que o arquivo crescer.
+class LeitorEventos {
+public:
+    // lança std::runtime_error se o arquivo não existir ou não for um log de eventos
+    explicit LeitorEventos(const std::filesystem::path &arquivo);
+    ~LeitorEventos();
+
+    LeitorEventos(const LeitorEventos &) = delete;
+    LeitorEventos &operator=(const LeitorEventos &) = delete;
+
+    bool proximo(Evento &evento);
+
+private:
+    int fd = -1;
+    uint64_t posicao;
+    std::string buffer;
+    size_t consumido = 0;
+};
+
+// percorre o log e as cópias rotacionadas, da mais antiga para a atual
+void ler_eventos(const std::filesystem::path &arquivo, const std::function<void(const Evento &)> &visitar);
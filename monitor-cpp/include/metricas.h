@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+// Métricas do monitor no formato texto do Prometheus.
+// Cada thread escreve só no próprio fragmento (alinhado em linha de cache, criado no
+// primeiro uso e nunca liberado), com load/store relaxados: não há trava, instrução
+// atômica com lock nem compartilhamento de linha no caminho de captura. A exportação
+// soma os fragmentos de todas as threads; a leitura pode ver um contador um pouco
+// atrasado, mas nunca um valor rasgado.
+
+enum class Contador : unsigned {
+    ARQUIVOS_VARRIDOS, // entradas examinadas por varreduras e eventos
+    VARREDURAS,
+    BYTES_HASH,        // lidos do disco para calcular hash
+    HASHES_EM_CACHE,   // hashes vindos do atributo estendido, sem leitura
+    BYTES_COPIADOS,    // gravados no store
+    VERSOES_SALVAS,
+    ERROS_LEITURA,
+    ERROS_COPIA,
+    FILA_TRANSBORDADA, // limite da fila atingido: a raiz é varrida de novo
+    DIRETORIOS_SONDADOS, // listagens de diretório da varredura adaptativa
+    TOTAL
+};
+
+enum class Histograma : unsigned {
+    LATENCIA_CAPTURA,  // da escrita do arquivo (ou da partida do monitor) até a versão no journal
+    DURACAO_VARREDURA,
+    TOTAL
+};
+
+void contar(Contador contador, uint64_t n = 1);
+void observar(Histograma histograma, int64_t ns);
+
+// contadores e histogramas de todas as threads, com # HELP e # TYPE
+std::string texto_metricas();
+
+// Publica as métricas periodicamente:
+//   "<porta>"   servidor HTTP em 127.0.0.1:<porta> (GET /metrics)
+//   "<arquivo>" reescrito atomicamente a cada `intervalo_ms` (coletor textfile do node_exporter)
+// `medidores` acrescenta ao texto as métricas instantâneas (gauges) do chamador e é
+// chamado da thread do exportador.
+class ExportadorMetricas {
+public:
+    // lança std::runtime_error se a porta não puder ser aberta
+    ExportadorMetricas(const std::string &destino, std::function<void(std::string &)> medidores,
+                       unsigned intervalo_ms = 5000);
+    ~ExportadorMetricas();
+
+    ExportadorMetricas(const ExportadorMetricas &) = delete;
+    ExportadorMetricas &operator=(const ExportadorMetricas &) = delete;
+
+    // "http://127.0.0.1:<porta>/metrics" ou o caminho do arquivo
+    std::string descricao() const;
+
+private:
+    std::string arquivo;
+    int servidor = -1;
+    uint16_t porta = 0;
+    int acordar[2] = {-1, -1}; // pipe que interrompe a espera da thread no encerramento
+    unsigned intervalo_ms;
+    std::function<void(std::string &)> medidores;
+    std::thread thread;
+
+    std::string gerar() const;
+    void servir();
+    void gravar_periodicamente();
+    void responder(int cliente) const;
+};
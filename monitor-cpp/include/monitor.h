@@ -0,0 +1,139 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ignore.h"
+#include "tabela_arquivos.h"
+
+class ExportadorMetricas;
+class FonteFanotify;
+class LogEventos;
+class MotorES;
+
+// Uma pasta monitorada e o store onde suas versões são gravadas.
+struct ConfigRaiz {
+    std::filesystem::path entrada;
+    std::filesystem::path saida;
+    unsigned prioridade = 1; // peso no escalonador: prioridade 2 recebe o dobro de E/S de prioridade 1
+};
+
+struct ConfigMonitor {
+    std::vector<ConfigRaiz> raizes;
+    unsigned threads = 0; // 0 = número de núcleos
+    std::chrono::milliseconds intervalo{2000};
+    bool fanotify = false; // eventos do sistema de arquivos em vez de varredura periódica
+    std::filesystem::path log; // log binário de eventos; vazio = <saida da primeira raiz>/.monitor/eventos.bin
+    std::string metricas;  // porta local ou arquivo para as métricas (ver ExportadorMetricas); vazio = desligadas
+    size_t fila_arquivos = 100000;      // arquivos pendentes por raiz (fila de captura ou eventos não examinados)
+    uint64_t fila_bytes = 64ull << 20;  // memória estimada desses pendentes
+    // varredura adaptativa, com este orçamento de chamadas/s; 0 = árvore inteira a cada intervalo
+    unsigned sondagem = 0;
+};
+
+// percorre a árvore de `dir` aplicando as regras de exclusão por componente e entrega
+// cada arquivo regular com seu id na tabela; diretórios ignorados nunca são abertos
+void varrer_diretorio(const std::filesystem::path &dir, TabelaArquivos &tabela, TabelaArquivos::Id id_dir,
+                      const FiltroIgnorar &filtro, const FiltroIgnorar::Estado &estado,
+                      const std::function<void(const std::filesystem::directory_entry &, TabelaArquivos::Id)> &visitar);
+
+// Lê o arquivo de configuração do modo multi-raiz:
+//   # comentário
+//   threads 8
+//   intervalo 2000                       (ms entre varreduras de uma raiz)
+//   eventos fanotify                     (ou "varredura", o padrão)
+//   log /var/log/monitor/eventos.bin     (log binário de eventos; ver log_eventos.h)
+//   metricas 9464                        (porta em 127.0.0.1, ou caminho de arquivo .prom)
+//   fila 100000 64                       (limite de arquivos pendentes por raiz [e MiB])
+//   sondagem 2000                        (varredura adaptativa por diretório, até 2000 chamadas/s)
+//   raiz <entrada> <saida> [prioridade]
+// Lança std::runtime_error indicando a linha em caso de erro.
+ConfigMonitor carregar_config(const std::filesystem::path &arquivo);
+
+// Monitora várias raízes em um único processo.
+// Cada raiz tem suas próprias regras de exclusão, tabela de arquivos, journal e filtro
+// de versões; a varredura só detecta mudanças (mtime/tamanho) e enfileira tarefas por
+// raiz. Um único conjunto de threads calcula hashes e copia as versões em lotes de
+// arquivos da mesma raiz (ver MotorES). A próxima tarefa sai por stride scheduling
+// ponderado pelos bytes lidos: cada raiz avança um relógio virtual em bytes /
+// prioridade e a de menor relógio é servida, então uma raiz com milhares de arquivos
+// alterados não atrasa as demais. Uma raiz só volta a ser varrida depois que todas as
+// suas tarefas terminaram e o grupo do journal foi confirmado.
+class MonitorRaizes {
+public:
+    explicit MonitorRaizes(const ConfigMonitor &config);
+    ~MonitorRaizes();
+
+    MonitorRaizes(const MonitorRaizes &) = delete;
+    MonitorRaizes &operator=(const MonitorRaizes &) = delete;
+
+    // inicia as threads e varre as raízes indefinidamente
+    void executar();
+
+private:
+    struct Tarefa;
+    struct Coleta;
+    struct Raiz;
+
+    ConfigMonitor config;
+    std::vector<std::unique_ptr<Raiz>> raizes;
+    std::vector<std::thread> trabalhadores;
+
+    // protege filas, contadores e relógios virtuais de todas as raízes
+    std::mutex mutex;
+    std::condition_variable cv_trabalho; // há tarefa na fila
+    std::condition_variable cv_livre;    // alguma raiz terminou suas tarefas
+    double tempo_virtual = 0;
+    bool encerrar = false;
+
+    int64_t inicio_ns; // partida: arquivos mais antigos contam a latência de captura a partir daqui
+    // contadores e histogramas de metricas.h, mais a profundidade da fila, o tamanho do
+    // store e a última captura de cada raiz; só com métricas configuradas
+    std::unique_ptr<ExportadorMetricas> exportador;
+    // cada versão salva e cada erro de arquivo, sem E/S no caminho de captura; o console
+    // recebe só um resumo por passada. Fechado depois que o destrutor junta os trabalhadores
+    std::unique_ptr<LogEventos> log;
+
+    void trabalhar();
+    Raiz *escolher();
+    void varrer(Raiz &raiz);
+
+    // Modo fanotify: cada raiz é varrida uma vez na partida; depois só os caminhos dos
+    // eventos são examinados (diretórios novos por inteiro), e a varredura completa só se
+    // repete se a fila do kernel transbordar. Um arquivo é examinado ao ser fechado
+    // depois de escrito; um que segue aberto recebendo escritas (FAN_MODIFY), uma vez por
+    // intervalo. Sem permissão para fanotify, executar() volta à varredura periódica.
+    void executar_eventos(FonteFanotify &fonte);
+
+    // Varredura adaptativa para onde não há eventos (NFS, FUSE): cada diretório é listado
+    // 250 ms depois de uma mudança, dobrando o intervalo a cada listagem sem novidade até
+    // 32 s, dentro de um orçamento global de chamadas por segundo; quando ele não cobre
+    // todos os vencidos, vão primeiro os mais atrasados em proporção ao próprio intervalo.
+    void executar_sondagem();
+    uint64_t sondar(Raiz &raiz, TabelaArquivos::Id id, Coleta &coleta, bool recursivo);
+    void processar_eventos(Raiz &raiz);
+    void examinar(Raiz &raiz, const std::filesystem::directory_entry &entry, uint32_t id, Coleta &coleta);
+
+    // Um arquivo novo com o dispositivo, o inode, o tamanho e o mtime de um já capturado,
+    // que não está mais no caminho antigo e não mudou desde a captura (ctime), foi levado
+    // junto com um diretório movido: a última versão do caminho antigo ganha um hard link
+    // com o nome novo no store, sem ler nem copiar o conteúdo.
+    void detectar_movidos(Raiz &raiz, Coleta &coleta);
+    void esquecer(Raiz &raiz, TabelaArquivos::Id id);
+
+    // A fila de cada raiz tem um limite em arquivos e em bytes estimados (os eventos
+    // fanotify pendentes também). Uma coleta que passa do limite enfileira só o que cabe
+    // e a raiz é varrida de novo assim que a fila esvazia; os arquivos de fora mantêm o
+    // registro antigo e reaparecem. Eventos acima do limite viram uma varredura completa.
+    void enfileirar(Raiz &raiz, Coleta &coleta);
+    void capturar(Raiz &raiz, const std::vector<Tarefa> &tarefas, MotorES &motor);
+    void concluir(Raiz &raiz);
+    void iniciar_metricas();
+    void medir(std::string &texto);
+};
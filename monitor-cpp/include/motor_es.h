@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+class SomasEmFluxo;
+
+// Um arquivo de um lote de E/S: lido uma vez do início ao fim, opcionalmente
+// copiado para `destino` e com o SHA-256 do conteúdo calculado durante a leitura.
+struct ArquivoLote {
+    std::filesystem::path origem;
+    std::filesystem::path destino; // vazio: apenas lê
+    unsigned modo = 0644;          // permissões do destino, se for criado
+    SomasEmFluxo *somas = nullptr; // recebe os bytes lidos, em ordem (integridade.h)
+
+    // preenchidos pelo motor
+    std::string hash{}; // SHA-256 hex, quando pedido
+    uint64_t bytes = 0;
+    int erro = 0; // errno da primeira falha; 0 = sucesso
+};
+
+// Motor de E/S em lote.
+// Com io_uring (syscalls diretas, sem liburing) cada arquivo do lote ocupa um slot com
+// buffer registrado no kernel; aberturas, leituras, escritas e fdatasync de todos os
+// slots são submetidas juntas e uma única thread mantém `profundidade` operações em voo.
+// Em kernels sem io_uring (ou com MONITOR_IO=bloqueante) o mesmo lote é processado com
+// read/write bloqueantes, um arquivo por vez.
+// Não é thread-safe: use um motor por thread.
+class MotorES {
+public:
+    explicit MotorES(unsigned profundidade = 32);
+    ~MotorES();
+
+    MotorES(const MotorES &) = delete;
+    MotorES &operator=(const MotorES &) = delete;
+
+    bool usando_uring() const { return anel != nullptr; }
+
+    // processa todos os arquivos; `calcular_hash` preenche ArquivoLote::hash e
+    // `sincronizar` faz fdatasync de cada destino antes de considerá-lo concluído
+    void executar(std::vector<ArquivoLote> &lote, bool calcular_hash, bool sincronizar);
+
+private:
+    struct Anel;
+
+    unsigned profundidade;
+    std::unique_ptr<Anel> anel;
+
+    void executar_uring(std::vector<ArquivoLote> &lote, bool calcular_hash, bool sincronizar);
+    void executar_bloqueante(std::vector<ArquivoLote> &lote, bool calcular_hash, bool sincronizar);
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+// Replicação do diretório de versões para outro nó via TCP.
+//
+// O emissor oferece lotes de capturas (OFERTA): cada registro do índice de cada
+// arquivo, na ordem do índice, com o nome da versão e os metadados da captura. Uma
+// versão capturada mais de uma vez aparece uma vez por captura. O receptor responde com
+// um bitmap do conteúdo que precisa (PEDIDO), pedindo cada versão só na primeira vez.
+// Versões cujo hash o receptor já possui sob outro nome são ligadas localmente e não
+// trafegam. O receptor registra as capturas no journal na ordem da oferta, pulando as
+// que o seu índice já tem, e assim o .idx da réplica sai igual ao do emissor. O emissor
+// mantém vários lotes em voo e envia o conteúdo pedido com sendfile, sem cópias em
+// espaço de usuário.
+//
+// O receptor escuta só no loopback, a menos que receba outro endereço; fora do
+// loopback exige um segredo compartilhado (MONITOR_SEGREDO_REPLICACAO, caminho de um
+// arquivo com ao menos 16 bytes, o mesmo nos dois nós). Com o segredo, o emissor prova
+// conhecê-lo respondendo ao desafio do receptor com HMAC-SHA256(segredo, desafio).
+// O receptor aceita conteúdo apenas para nomes que ele mesmo pediu e confere o hash do
+// nome antes de publicar a versão; as somas de integridade são calculadas localmente.
+//
+// Quadros (inteiros little-endian):
+//   'D' u8 exige desafio[32]                                   saudação do receptor
+//   'R' hmac[32]                                               resposta (se exige)
+//   'O' u32 n  { u16 len, caminho, i64 captura, u64 tamanho,
+//                i64 mtime_origem, u32 modo }*n                oferta
+//   'Q' u32 n  bitmap[(n+7)/8]                                 pedido
+//   'A' u16 len caminho u64 tamanho dados                      conteúdo
+//   'F'                                                        fim
+
+struct ResultadoReplicacao {
+    uint64_t oferecidas = 0; // capturas (registros do índice)
+    uint64_t enviadas = 0;
+    uint64_t bytes = 0;
+};
+
+// envia ao receptor em host:porta todas as versões que ele ainda não tem
+ResultadoReplicacao replicar_para(const std::filesystem::path &backup_dir, const std::string &host, uint16_t porta);
+
+// aceita conexões de replicação em endereco:porta e grava as versões recebidas em
+// backup_dir (não retorna)
+void receber_replicacao(const std::filesystem::path &backup_dir, uint16_t porta,
+                        const std::string &endereco = "127.0.0.1");
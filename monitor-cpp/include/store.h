@@ -0,0 +1,37 @@
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <string>
+
+class FiltroBloom;
+
+// Utilitários para o diretório de versões (backup_dir).
+// Cada versão fica em <caminho relativo do arquivo>_<sha256 hex> (nas cifradas, um HMAC
+// dele; ver hash_nome_cifrado); a pasta .monitor guarda os metadados do próprio monitor
+// e não contém versões.
+// O formato completo, compartilhado com o monitor-golang, está em FORMATO_STORE.md.
+
+// versão do formato gravada em .monitor/formato ("monitor-store <versão>")
+constexpr int VERSAO_FORMATO_STORE = 1;
+
+// lança std::runtime_error se o store declarar um formato mais novo que este programa
+// (ou um marcador ilegível); stores sem marcador são da versão 1
+void verificar_formato_store(const std::filesystem::path &backup_dir);
+
+// verifica o formato e grava o marcador se ainda não existir; chamado por quem escreve
+void preparar_store(const std::filesystem::path &backup_dir);
+
+// percorre todas as versões, entregando o caminho relativo ao backup_dir
+void percorrer_versoes(const std::filesystem::path &backup_dir,
+                       const std::function<void(const std::string &relativo)> &visitar);
+
+// separa "pasta/arquivo.txt_<hash>" em "pasta/arquivo.txt" e "<hash>"
+bool separar_versao(const std::string &relativo, std::string &nome, std::string &hash);
+
+// localiza a versão de `nome_base` cujo hash começa com `hash_parcial`; vazio se não houver
+std::filesystem::path encontrar_versao(const std::filesystem::path &backup_dir, const std::string &nome_base,
+                                       const std::string &hash_parcial);
+
+// abre o filtro de Bloom das versões (.monitor/versoes.bloom), reconstruindo-o a partir
+// do store quando não existe, está corrompido ou passou da capacidade
+void abrir_filtro_versoes(FiltroBloom &filtro, const std::filesystem::path &backup_dir);
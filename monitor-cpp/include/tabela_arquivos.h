@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Tabela compacta dos arquivos monitorados.
+// Cada caminho é internado como (id do diretório pai, nome do componente): o prefixo
+// é compartilhado com o diretório pai e o nome fica em uma arena contígua. Os ids
+// são de 32 bits, a busca usa endereçamento aberto e os metadados (mtime, tamanho e
+// último hash) ficam em vetores paralelos indexados pelo id, sem alocação por arquivo.
+// A identidade (dispositivo, inode, instante da captura), usada só na detecção de
+// arquivos movidos, existe apenas para arquivos capturados: fica em uma tabela à parte,
+// densa, com um índice por id e outro por inode, sem custo para os demais nós.
+// Medido com 1 milhão de arquivos em 1000 diretórios (nomes de ~16 caracteres), com a
+// folga de capacidade dos vetores: 72 bytes por arquivo nunca capturado (nó 12, registro
+// 32, nome na arena e slot da busca) e mais 42 por arquivo capturado (entrada de 24 e
+// os dois índices), 114 com todos capturados. A meta de 64 não é atingida: o registro
+// sozinho já ocupa metade dela.
+class TabelaArquivos {
+public:
+    using Id = uint32_t;
+    static constexpr Id RAIZ = 0;
+    static constexpr Id NENHUM = UINT32_MAX;
+    static constexpr size_t TAMANHO_HASH = 16; // prefixo do SHA-256 usado para comparação
+
+    struct Registro {
+        int64_t mtime = INT64_MIN; // INT64_MIN: nunca capturado
+        uint64_t tamanho = 0;
+        uint8_t hash[TAMANHO_HASH] = {};
+    };
+
+    // arquivo na última captura: reconhece o mesmo arquivo se ele for movido
+    struct Identidade {
+        uint64_t inode = 0;       // 0: desconhecida
+        int64_t capturado_ns = 0; // ctime posterior: o inode mudou desde a captura
+        uint32_t dispositivo = 0; // ver dispositivo_compacto
+    };
+
+    TabelaArquivos();
+
+    // devolve o id do componente `nome` dentro de `pai`, criando se necessário
+    Id internar(Id pai, std::string_view nome);
+    Id buscar(Id pai, std::string_view nome) const;
+
+    Registro &registro(Id id) { return registros[id]; }
+    const Registro &registro(Id id) const { return registros[id]; }
+
+    // identidade de `id` na última captura; inode 0 se não houver
+    Identidade identidade(Id id) const;
+    // substitui a identidade de `id` (inode 0 a remove); o inode passa a indicar `id`
+    void definir_identidade(Id id, const Identidade &identidade);
+    // arquivo capturado por último com `inode`; NENHUM se não houver
+    Id capturado_com_inode(uint64_t inode) const;
+    size_t identificados() const { return identidades.size(); }
+    template <typename F> void para_cada_identificado(F &&f) const {
+        for (const auto &e : identidades) f(e.id);
+    }
+
+    // st_dev em 32 bits (no Linux ele já cabe neles)
+    static uint32_t dispositivo_compacto(uint64_t dispositivo) {
+        return static_cast<uint32_t>(dispositivo ^ (dispositivo >> 32));
+    }
+
+    // caminho relativo à raiz, com '/' como separador
+    std::string caminho(Id id) const;
+    std::string_view nome(Id id) const;
+    Id pai(Id id) const { return nos[id].pai; }
+
+    size_t tamanho() const { return nos.size(); }
+    size_t bytes_usados() const;
+
+    // converte o hash hexadecimal para o prefixo binário armazenado no registro
+    static void hash_de_hex(std::string_view hex, uint8_t saida[TAMANHO_HASH]);
+
+private:
+    struct No {
+        Id pai;
+        uint32_t deslocamento; // posição do nome na arena
+        uint16_t comprimento;
+    };
+
+    // identidade com o id dono, sem o preenchimento que a struct pública teria
+    struct EntradaIdentidade {
+        uint64_t inode;
+        int64_t capturado_ns;
+        uint32_t dispositivo;
+        Id id;
+    };
+
+    std::vector<No> nos;
+    std::vector<Registro> registros;
+    std::vector<char> arena;
+    std::vector<Id> slots; // id + 1; 0 = vazio
+    size_t mascara = 0;
+
+    std::vector<EntradaIdentidade> identidades; // só arquivos capturados, em qualquer ordem
+    std::vector<uint32_t> slots_por_id;         // posição em `identidades` + 1; 0 = vazio
+    std::vector<uint32_t> slots_por_inode;      // idem, a entrada mais recente de cada inode
+    size_t mascara_identidades = 0;
+
+    static uint64_t espalhar(Id pai, std::string_view nome);
+    void redimensionar(size_t capacidade);
+
+    size_t slot_do_id(Id id) const;
+    size_t slot_do_inode(uint64_t inode) const;
+    void redimensionar_identidades(size_t capacidade);
+    void remover_slot(std::vector<uint32_t> &slots_identidade, size_t i, bool por_inode);
+    void remover_identidade(uint32_t posicao);
+};
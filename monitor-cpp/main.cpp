@@ -1,79 +1,103 @@
 #include <iostream>
 #include <filesystem>
-#include <unordered_map>
-#include <chrono>
-#include <thread>
+#include <algorithm>
+#include <vector>
 #include <fstream>
-#include <sstream>
-#include <iomanip>
-#include <openssl/sha.h>
-
-namespace fs = std::filesystem;
-
-// calcular hash SHA-256
-std::string calcular_hash(const fs::path &arquivo) {
-    std::ifstream in(arquivo, std::ios::binary);
-    if (!in) return "";
+#include <chrono>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
 
-    std::ostringstream oss;
-    SHA256_CTX sha256;
-    SHA256_Init(&sha256);
+#include "busca.h"
+#include "cache_versoes.h"
+#include "diff.h"
+#include "exportar.h"
+#include "indice.h"
+#include "integridade.h"
+#include "leitor_versao.h"
+#include "log_eventos.h"
+#include "monitor.h"
+#include "motor_es.h"
+#include "replicacao.h"
+#include "store.h"
 
-    const size_t buffer_size = 4096;
-    char buffer[buffer_size];
+namespace fs = std::filesystem;
 
-    while (in.read(buffer, buffer_size) || in.gcount() > 0) {
-        SHA256_Update(&sha256, buffer, in.gcount());
+// restaurar arquivo por hash
+void restaurar_por_hash(const fs::path &backup_dir, const fs::path &input_dir,
+                        const std::string &nome_base, const std::string &hash_parcial) {
+    fs::path versao = encontrar_versao(backup_dir, nome_base, hash_parcial);
+    if (versao.empty()) {
+        std::cerr << "❌ Versão não encontrada para hash: " << hash_parcial << std::endl;
+        return;
     }
+    fs::path destino = input_dir / nome_base;
+    fs::create_directories(destino.parent_path());
 
-    unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256_Final(hash, &sha256);
+    // permissões da origem pelo índice; sem elas, as da versão (as cifradas são sempre 0600)
+    unsigned modo = static_cast<unsigned>(fs::status(versao).permissions() & fs::perms::mask);
+    std::string nome, hash;
+    IndiceVersoes::Entrada entrada;
+    if (separar_versao(versao.lexically_relative(backup_dir).generic_string(), nome, hash) &&
+        IndiceVersoes(backup_dir).buscar(nome, hash, entrada) && entrada.meta.modo != 0)
+        modo = entrada.meta.modo & 07777;
 
-    for (int i = 0; i < SHA256_DIGEST_LENGTH; ++i)
-        oss << std::hex << std::setw(2) << std::setfill('0') << (int)hash[i];
-
-    return oss.str();
+    // abre a versão mesmo com o cache: sem a chave, uma versão cifrada continua recusada
+    LeitorVersao leitor(versao);
+    fs::path materializada = versao_materializada(versao);
+    if (!materializada.empty() || !leitor.cifrada()) {
+        std::vector<ArquivoLote> lote(1);
+        lote[0].origem = materializada.empty() ? versao : materializada;
+        lote[0].destino = destino;
+        lote[0].modo = modo;
+        MotorES(1).executar(lote, false, true);
+        if (lote[0].erro != 0) throw std::runtime_error(destino.string() + ": " + std::strerror(lote[0].erro));
+    } else {
+        std::ofstream out(destino, std::ios::binary | std::ios::trunc);
+        std::vector<char> buffer(1 << 16);
+        while (size_t n = leitor.ler(buffer.data(), buffer.size())) out.write(buffer.data(), n);
+    }
+    ::chmod(destino.c_str(), modo); // o destino pode já existir com outras permissões
+    std::cout << "✅ Restaurado " << nome_base << " a partir do hash " << hash_parcial << std::endl;
 }
 
-// restaurar arquivo por hash
-void restaurar_por_hash(const fs::path &backup_dir, const fs::path &input_dir,
-                        const std::string &nome_base, const std::string &hash_parcial) {
-    for (auto &entry : fs::directory_iterator(backup_dir)) {
-        if (entry.is_regular_file()) {
-            std::string nome = entry.path().filename().string();
-            if (nome.find(nome_base + "_") == 0 &&
-                nome.substr(nome_base.size() + 1).find(hash_parcial) == 0) {
-                fs::path destino = input_dir / nome_base;
-                fs::copy_file(entry.path(), destino, fs::copy_options::overwrite_existing);
-                std::cout << "✅ Restaurado " << nome_base << " a partir do hash " << hash_parcial << std::endl;
-                return;
-            }
-        }
+// comparar duas versões de um arquivo
+int comparar_versoes(const fs::path &backup_dir, const std::string &nome_base,
+                     const std::string &hash_a, const std::string &hash_b) {
+    fs::path versao_a = encontrar_versao(backup_dir, nome_base, hash_a);
+    fs::path versao_b = encontrar_versao(backup_dir, nome_base, hash_b);
+    if (versao_a.empty() || versao_b.empty()) {
+        std::cerr << "❌ Versão não encontrada para hash: " << (versao_a.empty() ? hash_a : hash_b) << std::endl;
+        return 1;
     }
-    std::cerr << "❌ Versão não encontrada para hash: " << hash_parcial << std::endl;
+
+    std::cout << "--- " << versao_a.filename().string() << "\n";
+    std::cout << "+++ " << versao_b.filename().string() << "\n";
+    bool igual = diff_versoes(versao_a, versao_b, std::cout);
+    if (igual) std::cout << "Versões idênticas\n";
+    std::cout.flush();
+    return 0;
 }
 
 // listar hashes disponíveis
-void listar_hashes(const fs::path &backup_dir, const std::string &nome_base) {
-    std::vector<std::string> hashes;
-
-    for (auto &entry : fs::directory_iterator(backup_dir)) {
-        if (entry.is_regular_file()) {
-            std::string nome = entry.path().filename().string();
-            if (nome.find(nome_base + "_") == 0) {
-                std::string hash = nome.substr(nome_base.size() + 1);
-                hashes.push_back(hash);
-            }
-        }
-    }
+void listar_hashes(const fs::path &backup_dir, const std::string &nome_base, size_t pagina) {
+    const size_t POR_PAGINA = 50;
+    IndiceVersoes indice(backup_dir);
+    size_t total = indice.total(nome_base);
 
-    if (hashes.empty()) {
+    if (total == 0) {
         std::cout << "Nenhuma versão encontrada para " << nome_base << std::endl;
-    } else {
-        std::cout << "Hashes disponíveis para " << nome_base << ":\n";
-        for (auto &h : hashes) {
-            std::cout << " - " << h << "\n";
-        }
+        return;
+    }
+
+    // sem página explícita mostra a última (versões mais recentes)
+    size_t paginas = (total + POR_PAGINA - 1) / POR_PAGINA;
+    if (pagina == 0 || pagina > paginas) pagina = paginas;
+
+    std::cout << "Versões de " << nome_base << " (" << total << ", página " << pagina << " de " << paginas << "):\n";
+    for (auto &e : indice.ler(nome_base, (pagina - 1) * POR_PAGINA, POR_PAGINA)) {
+        std::cout << " - " << formatar_instante(e.meta.captura_ns) << "  " << e.hash << "  " << e.meta.tamanho
+                  << " bytes\n";
     }
 }
 
@@ -81,13 +105,54 @@ void listar_hashes(const fs::path &backup_dir, const std::string &nome_base) {
 void mostrar_help() {
     std::cout << "Uso: monitor_app [OPÇÃO] [ARGUMENTOS]\n\n";
     std::cout << "Sem argumentos                               : Inicia o monitoramento da pasta de input\n";
-    std::cout << "--list <arquivo>                             : Lista todas as versões (hashes) disponíveis para o arquivo\n";
+    std::cout << "--config <arquivo>                           : Monitora todas as raízes listadas no arquivo com um único processo\n";
+    std::cout << "--list <arquivo> [pagina]                    : Lista as versões do arquivo em ordem cronológica (50 por página)\n";
     std::cout << "--revert <arquivo> <hash>                    : Restaura a versão do arquivo correspondente ao hash (parcial ou completo)\n";
+    std::cout << "--diff <arquivo> <hashA> <hashB>             : Mostra as diferenças entre duas versões do arquivo\n";
+    std::cout << "--export <instante>                          : Escreve na saída padrão um tar com a versão de cada arquivo naquele instante\n";
+    std::cout << "--restore <instante> [diretorio]             : Restaura a árvore inteira daquele instante (na pasta monitorada, por padrão)\n";
+    std::cout << "--snapshot <instante> <diretorio>            : Cria em <diretorio> a árvore daquele instante com reflinks ou hard links, sem copiar dados\n";
+    std::cout << "--verify                                     : Confere todas as versões com suas somas e repara o que a paridade permitir\n";
+    std::cout << "--log [arquivo]                              : Mostra o log de eventos (versões salvas e erros de cada arquivo)\n";
+    std::cout << "--search <texto>                             : Procura o texto em todas as versões armazenadas\n";
+    std::cout << "--search-regex <expressao>                   : Procura a expressão regular em todas as versões\n";
+    std::cout << "--replicate <host> <porta>                   : Envia ao receptor as versões e capturas que ele ainda não possui\n";
+    std::cout << "--receive <porta> <diretorio> [endereco]     : Recebe versões replicadas e grava em <diretorio> (escuta em 127.0.0.1, por padrão)\n";
     std::cout << "--help                                       : Ajuda\n\n";
+    std::cout << "Arquivos e pastas listados em <input>/.monitorignore (sintaxe do .gitignore) não são monitorados;\n";
+    std::cout << "um .monitorignore em uma subpasta vale para o que está abaixo dela (lidos ao iniciar).\n";
+    std::cout << "Arquivo de --config: linhas \"raiz <entrada> <saida> [prioridade]\", \"threads <n>\", \"intervalo <ms>\"\n";
+    std::cout << "e \"eventos fanotify\" (eventos do sistema de arquivos inteiro em vez de varredura; requer CAP_SYS_ADMIN).\n";
+    std::cout << "\"fila <arquivos> [MiB]\" limita os arquivos pendentes de cada raiz (100000, 64 MiB); acima disso a raiz é revarrida.\n";
+    std::cout << "\"sondagem <chamadas/s>\" (ou MONITOR_SONDAGEM) troca a varredura completa por uma por diretório, para NFS e FUSE:\n";
+    std::cout << "diretórios com mudanças são listados a cada 250 ms, os parados até a cada 32 s, dentro do orçamento de chamadas.\n";
+    std::cout << "Métricas Prometheus com \"metricas <porta>\" (HTTP em 127.0.0.1) ou \"metricas <arquivo.prom>\" no arquivo\n";
+    std::cout << "de --config, ou MONITOR_METRICAS=<porta|arquivo> no ambiente.\n";
+    std::cout << "Versões salvas e erros de cada arquivo vão para o log binário <output>/.monitor/eventos.bin (\"log <arquivo>\"\n";
+    std::cout << "no arquivo de --config); o console recebe um resumo por varredura.\n";
+    std::cout << "Com MONITOR_CHAVE=<arquivo de chave> (32 bytes ou 64 hex) as versões são cifradas com AES-256-GCM\n";
+    std::cout << "e decifradas automaticamente por --revert, --diff e --search.\n";
+    std::cout << "A E/S de captura e restauração usa io_uring quando o kernel oferece; MONITOR_IO=bloqueante força read/write.\n";
+    std::cout << "O hash de cada arquivo fica em cache no atributo user.monitor.sha256 (MONITOR_XATTR=0 desliga).\n";
+    std::cout << "Com MONITOR_CACHE_VERSOES=<MiB>, --revert guarda as versões restauradas em um cache em tmpfs (/dev/shm\n";
+    std::cout << "ou $XDG_RUNTIME_DIR) por até uma hora sem uso; versões cifradas só com MONITOR_CACHE_VERSOES_CIFRADAS=1.\n";
+    std::cout << "Cada versão ganha somas CRC32C por bloco de 64 KiB, conferidas nas leituras; com MONITOR_PARIDADE=<n>\n";
+    std::cout << "grava também um bloco de paridade a cada n (16 custa 1/16 do tamanho). Um bloco corrompido por grupo\n";
+    std::cout << "é reconstruído em memória na leitura, e só o --verify o regrava no store.\n";
+    std::cout << "--receive fora do loopback exige MONITOR_SEGREDO_REPLICACAO=<arquivo> (o mesmo segredo nos dois nós), com o\n";
+    std::cout << "qual o emissor se autentica; só versões pedidas e com o hash conferido são gravadas.\n\n";
     std::cout << "Exemplos:\n";
     std::cout << "  ./monitor_app                              : inicia monitoramento\n";
+    std::cout << "  ./monitor_app --config raizes.conf         : monitora várias pastas\n";
     std::cout << "  ./monitor_app --list arquivo.txt           : lista versões do arquivo\n";
     std::cout << "  ./monitor_app --revert arquivo.txt 3a7b    : restaura versão do arquivo\n";
+    std::cout << "  ./monitor_app --diff arquivo.txt 3a7b 9f2c : compara duas versões do arquivo\n";
+    std::cout << "  ./monitor_app --search timeout=30          : encontra as versões que continham o texto\n";
+    std::cout << "  ./monitor_app --export 2024-05-01 > a.tar  : exporta o estado do início daquele dia\n";
+    std::cout << "  ./monitor_app --restore 2024-05-01         : volta a pasta inteira ao estado daquele momento\n";
+    std::cout << "  ./monitor_app --verify                     : confere as versões e repara blocos corrompidos\n";
+    std::cout << "  ./monitor_app --snapshot 2024-05-01 /srv/snap/0501 : navega o estado daquele dia com ferramentas comuns\n";
+    std::cout << "  ./monitor_app --replicate 10.0.0.2 7070    : replica o backup para outro nó\n";
 }
 
 int main(int argc, char *argv[]) {
@@ -108,18 +173,208 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
+    // os modos de consulta leem o store padrão; quem grava (monitoramento e --receive) verifica ao abrir
+    std::string modo = argc > 1 ? argv[1] : "";
+    if (!modo.empty() && modo != "--config" && modo != "--receive") {
+        try {
+            verificar_formato_store(backup_dir);
+        } catch (const std::exception &e) {
+            std::cerr << "❌ " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
     // modo revert
     if (argc == 4 && std::string(argv[1]) == "--revert") {
         std::string arquivo = argv[2];
         std::string hash = argv[3];
-        restaurar_por_hash(backup_dir, dir, arquivo, hash);
+        try {
+            restaurar_por_hash(backup_dir, dir, arquivo, hash);
+        } catch (const std::exception &e) {
+            std::cerr << "❌ Erro restaurando versão: " << e.what() << std::endl;
+            return 1;
+        }
         return 0;
     }
 
     // modo list
-    if (argc == 3 && std::string(argv[1]) == "--list") {
+    if ((argc == 3 || argc == 4) && std::string(argv[1]) == "--list") {
         std::string arquivo = argv[2];
-        listar_hashes(backup_dir, arquivo);
+        try {
+            listar_hashes(backup_dir, arquivo, argc == 4 ? std::stoul(argv[3]) : 0);
+        } catch (const std::exception &e) {
+            std::cerr << "❌ Erro listando versões: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // modo diff
+    if (argc == 5 && std::string(argv[1]) == "--diff") {
+        try {
+            return comparar_versoes(backup_dir, argv[2], argv[3], argv[4]);
+        } catch (const std::exception &e) {
+            std::cerr << "❌ Erro comparando versões: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    // modo busca
+    if (argc == 3 && (std::string(argv[1]) == "--search" || std::string(argv[1]) == "--search-regex")) {
+        OpcoesBusca opcoes;
+        opcoes.padrao = argv[2];
+        opcoes.regex = std::string(argv[1]) == "--search-regex";
+        try {
+            size_t total = buscar_versoes(backup_dir, opcoes, std::cout);
+            if (total == 0) std::cout << "Nenhuma ocorrência encontrada para " << opcoes.padrao << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << "❌ Erro na busca: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // modo log de eventos
+    if ((argc == 2 || argc == 3) && std::string(argv[1]) == "--log") {
+        fs::path arquivo = argc == 3 ? fs::path(argv[2]) : backup_dir / ".monitor" / "eventos.bin";
+        try {
+            ler_eventos(arquivo, [](const Evento &e) { std::cout << formatar_evento(e) << '\n'; });
+        } catch (const std::exception &e) {
+            std::cerr << "❌ Erro lendo o log de eventos: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // modo exportação
+    if (argc == 3 && std::string(argv[1]) == "--export") {
+        int64_t instante = 0;
+        if (!interpretar_instante(argv[2], instante)) {
+            std::cerr << "❌ Instante inválido: " << argv[2] << " (use \"AAAA-MM-DD HH:MM:SS\")" << std::endl;
+            return 1;
+        }
+        if (::isatty(STDOUT_FILENO)) {
+            std::cerr << "❌ O tar é escrito na saída padrão: redirecione para um arquivo ou pipe" << std::endl;
+            return 1;
+        }
+        try {
+            size_t total = exportar_tar(backup_dir, instante, STDOUT_FILENO);
+            std::cerr << "📦 " << total << " arquivos exportados como em " << formatar_instante(instante) << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << "❌ Erro na exportação: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // modo restauração da árvore
+    if ((argc == 3 || argc == 4) && std::string(argv[1]) == "--restore") {
+        int64_t instante = 0;
+        if (!interpretar_instante(argv[2], instante)) {
+            std::cerr << "❌ Instante inválido: " << argv[2] << " (use \"AAAA-MM-DD HH:MM:SS\")" << std::endl;
+            return 1;
+        }
+        fs::path destino = argc == 4 ? fs::path(argv[3]) : dir;
+        auto rel = fs::weakly_canonical(destino).lexically_relative(fs::weakly_canonical(backup_dir));
+        if (!rel.empty() && *rel.begin() != "..") {
+            std::cerr << "❌ O destino não pode ficar dentro do store" << std::endl;
+            return 1;
+        }
+        try {
+            auto inicio = std::chrono::steady_clock::now();
+            ResultadoRestauracao r = restaurar_arvore(backup_dir, instante, destino);
+            double segundos = std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+            std::cout << "✅ " << r.arquivos << " arquivos restaurados em " << destino << " como em "
+                      << formatar_instante(instante) << " (" << r.bytes / 1048576 << " MiB em " << segundos
+                      << " s, ordem " << (r.fiemap ? "física (FIEMAP)" : "de inode") << ")" << std::endl;
+            if (r.erros) {
+                std::cerr << "⚠️ " << r.erros << " arquivos não puderam ser restaurados" << std::endl;
+                return 1;
+            }
+        } catch (const std::exception &e) {
+            std::cerr << "❌ Erro na restauração: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // modo snapshot
+    if (argc == 4 && std::string(argv[1]) == "--snapshot") {
+        int64_t instante = 0;
+        if (!interpretar_instante(argv[2], instante)) {
+            std::cerr << "❌ Instante inválido: " << argv[2] << " (use \"AAAA-MM-DD HH:MM:SS\")" << std::endl;
+            return 1;
+        }
+        // dentro da pasta monitorada seria capturado; dentro do store, confundido com versões
+        fs::path destino = fs::weakly_canonical(argv[3]);
+        for (const fs::path &proibida : {fs::weakly_canonical(dir), fs::weakly_canonical(backup_dir)}) {
+            auto rel = destino.lexically_relative(proibida);
+            if (!rel.empty() && *rel.begin() != "..") {
+                std::cerr << "❌ O snapshot não pode ficar dentro de " << proibida << std::endl;
+                return 1;
+            }
+        }
+        try {
+            ResultadoSnapshot r = criar_snapshot(backup_dir, instante, destino);
+            std::cout << "📸 Snapshot de " << formatar_instante(instante) << " em " << destino << ": " << r.clonados
+                      << " reflinks, " << r.ligados << " hard links, " << r.copiados << " cópias" << std::endl;
+            if (r.ligados)
+                std::cout << "⚠️ Hard links compartilham o conteúdo com o store: não edite esses arquivos no snapshot"
+                          << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << "❌ Erro criando o snapshot: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // modo verificação
+    if (argc == 2 && std::string(argv[1]) == "--verify") {
+        try {
+            ResultadoConferencia r = conferir_store(backup_dir);
+            std::cout << "🔎 " << r.conferidas << " versões conferidas, " << r.sem_somas << " sem somas, "
+                      << r.reparadas << " reparadas, " << r.corrompidas << " corrompidas" << std::endl;
+            if (r.corrompidas) return 1;
+        } catch (const std::exception &e) {
+            std::cerr << "❌ Erro na verificação: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // modo multi-raiz
+    if (argc == 3 && std::string(argv[1]) == "--config") {
+        try {
+            MonitorRaizes(carregar_config(argv[2])).executar();
+        } catch (const std::exception &e) {
+            std::cerr << "❌ Erro no monitoramento: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // modo replicação (emissor)
+    if (argc == 4 && std::string(argv[1]) == "--replicate") {
+        try {
+            auto r = replicar_para(backup_dir, argv[2], static_cast<uint16_t>(std::stoi(argv[3])));
+            std::cout << "📤 Replicação concluída: " << r.oferecidas << " capturas oferecidas, " << r.enviadas
+                      << " versões enviadas (" << r.bytes << " bytes)" << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << "❌ Erro na replicação: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // modo replicação (receptor)
+    if ((argc == 4 || argc == 5) && std::string(argv[1]) == "--receive") {
+        try {
+            fs::create_directories(argv[3]);
+            receber_replicacao(argv[3], static_cast<uint16_t>(std::stoi(argv[2])), argc == 5 ? argv[4] : "127.0.0.1");
+        } catch (const std::exception &e) {
+            std::cerr << "❌ Erro na replicação: " << e.what() << std::endl;
+            return 1;
+        }
         return 0;
     }
 
@@ -131,32 +386,14 @@ int main(int argc, char *argv[]) {
     }
 
     // monitoramento
-    std::unordered_map<std::string, fs::file_time_type> arquivos_anteriores;
-    std::cout << "📡 Monitorando " << dir << " e salvando versões em " << backup_dir << std::endl;
-
-    while (true) {
-        for (auto &entry : fs::directory_iterator(dir)) {
-            if (entry.is_regular_file()) {
-                std::string nome = entry.path().filename().string();
-                auto mod_time = entry.last_write_time();
-
-                if (!arquivos_anteriores.count(nome) || arquivos_anteriores[nome] != mod_time) {
-                    std::string hash = calcular_hash(entry.path());
-                    fs::path destino = backup_dir / (nome + "_" + hash);
-
-                    try {
-                        fs::copy_file(entry.path(), destino, fs::copy_options::overwrite_existing);
-                        std::cout << "💾 Nova versão salva: " << destino << std::endl;
-                        arquivos_anteriores[nome] = mod_time;
-                    } catch (const std::exception &e) {
-                        std::cerr << "Erro salvando versão: " << e.what() << std::endl;
-                    }
-                }
-            }
-        }
-        std::this_thread::sleep_for(std::chrono::seconds(2));
+    try {
+        ConfigMonitor config;
+        config.raizes.push_back({dir, backup_dir, 1});
+        MonitorRaizes(config).executar();
+    } catch (const std::exception &e) {
+        std::cerr << "❌ Erro no monitoramento: " << e.what() << std::endl;
+        return 1;
     }
-
     return 0;
 }
 
@@ -0,0 +1,123 @@
+#include "bloom.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char MAGICA[4] = {'M', 'B', 'F', '1'};
+constexpr uint64_t BITS_POR_CHAVE = 16;
+constexpr int SONDAS = 8;
+
+uint64_t misturar(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+uint64_t espalhar(std::string_view chave) {
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : chave) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return misturar(h);
+}
+
+} // namespace
+
+FiltroBloom::~FiltroBloom() { fechar(); }
+
+void FiltroBloom::fechar() {
+    if (cabecalho) ::munmap(cabecalho, tamanho_mapa);
+    cabecalho = nullptr;
+    bits = nullptr;
+    tamanho_mapa = 0;
+}
+
+bool FiltroBloom::mapear(int fd, size_t tamanho) {
+    void *p = ::mmap(nullptr, tamanho, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return false;
+    cabecalho = static_cast<Cabecalho *>(p);
+    bits = reinterpret_cast<uint64_t *>(static_cast<char *>(p) + sizeof(Cabecalho));
+    tamanho_mapa = tamanho;
+    return true;
+}
+
+bool FiltroBloom::abrir(const std::filesystem::path &arquivo) {
+    fechar();
+    int fd = ::open(arquivo.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) return false;
+
+    struct stat st {};
+    Cabecalho c{};
+    bool ok = ::fstat(fd, &st) == 0 && ::pread(fd, &c, sizeof(c), 0) == sizeof(c) &&
+              std::memcmp(c.magica, MAGICA, 4) == 0 && c.versao == 1 && c.blocos > 0 &&
+              static_cast<uint64_t>(st.st_size) == sizeof(Cabecalho) + c.blocos * BYTES_BLOCO &&
+              mapear(fd, st.st_size);
+    ::close(fd);
+    return ok;
+}
+
+void FiltroBloom::criar(const std::filesystem::path &arquivo, uint64_t capacidade) {
+    fechar();
+    uint64_t blocos = (capacidade * BITS_POR_CHAVE + BYTES_BLOCO * 8 - 1) / (BYTES_BLOCO * 8);
+    if (blocos == 0) blocos = 1;
+    size_t tamanho = sizeof(Cabecalho) + blocos * BYTES_BLOCO;
+
+    // grava em arquivo temporário e renomeia: um leitor nunca vê um filtro pela metade
+    std::filesystem::path temporario = arquivo;
+    temporario += ".novo";
+    int fd = ::open(temporario.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) throw std::runtime_error("não foi possível criar " + temporario.string());
+
+    Cabecalho c{};
+    std::memcpy(c.magica, MAGICA, 4);
+    c.versao = 1;
+    c.blocos = blocos;
+    c.capacidade = capacidade;
+    bool ok = ::ftruncate(fd, tamanho) == 0 && ::pwrite(fd, &c, sizeof(c), 0) == sizeof(c) && mapear(fd, tamanho);
+    ::close(fd);
+    if (!ok) throw std::runtime_error("não foi possível inicializar " + temporario.string());
+    std::filesystem::rename(temporario, arquivo);
+}
+
+void FiltroBloom::adicionar(std::string_view chave) {
+    if (!cabecalho) return;
+    uint64_t h = espalhar(chave);
+    uint64_t *bloco = bits + (h % cabecalho->blocos) * (BYTES_BLOCO / 8);
+    uint64_t sondas = misturar(h + 0x9E3779B97F4A7C15ULL);
+    for (int i = 0; i < SONDAS; ++i, sondas >>= 9) {
+        unsigned bit = sondas & 511;
+        __atomic_fetch_or(&bloco[bit / 64], 1ULL << (bit % 64), __ATOMIC_RELAXED);
+        if (i == 6) sondas = misturar(sondas ^ h); // 7 * 9 bits esgotam os 64 bits
+    }
+    __atomic_fetch_add(&cabecalho->chaves, 1, __ATOMIC_RELAXED);
+}
+
+bool FiltroBloom::talvez_contem(std::string_view chave) const {
+    if (!cabecalho) return true;
+    uint64_t h = espalhar(chave);
+    const uint64_t *bloco = bits + (h % cabecalho->blocos) * (BYTES_BLOCO / 8);
+    uint64_t sondas = misturar(h + 0x9E3779B97F4A7C15ULL);
+    for (int i = 0; i < SONDAS; ++i, sondas >>= 9) {
+        unsigned bit = sondas & 511;
+        if (!(__atomic_load_n(&bloco[bit / 64], __ATOMIC_RELAXED) & (1ULL << (bit % 64)))) return false;
+        if (i == 6) sondas = misturar(sondas ^ h);
+    }
+    return true;
+}
+
+uint64_t FiltroBloom::chaves() const {
+    return cabecalho ? __atomic_load_n(&cabecalho->chaves, __ATOMIC_RELAXED) : 0;
+}
+
+uint64_t FiltroBloom::capacidade() const {
+    return cabecalho ? cabecalho->capacidade : 0;
+}
@@ -0,0 +1,251 @@
+#include "busca.h"
+#include "indice.h"
+#include "leitor_versao.h"
+#include "store.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <regex>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t TAMANHO_BUFFER = 1 << 20;
+constexpr size_t MAX_TEXTO_LINHA = 240;
+
+// busca de substring: compara primeiro e último byte do padrão em 16 posições por vez
+// e só confirma com memcmp onde os dois batem
+size_t procurar(const char *s, size_t n, std::string_view p) {
+    const size_t m = p.size();
+    if (m == 0) return 0;
+    if (m > n) return std::string_view::npos;
+    if (m == 1) {
+        const void *r = std::memchr(s, p[0], n);
+        return r ? static_cast<const char *>(r) - s : std::string_view::npos;
+    }
+
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i primeiro = _mm_set1_epi8(p[0]);
+    const __m128i ultimo = _mm_set1_epi8(p[m - 1]);
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        __m128i bloco_p = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+        __m128i bloco_u = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i + m - 1));
+        unsigned mascara = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(bloco_p, primeiro), _mm_cmpeq_epi8(bloco_u, ultimo))));
+        while (mascara) {
+            unsigned bit = __builtin_ctz(mascara);
+            if (std::memcmp(s + i + bit + 1, p.data() + 1, m - 2) == 0) return i + bit;
+            mascara &= mascara - 1;
+        }
+    }
+#endif
+    const void *r = ::memmem(s + i, n - i, p.data(), m);
+    return r ? static_cast<const char *>(r) - s : std::string_view::npos;
+}
+
+struct Ocorrencia {
+    uint64_t linha;
+    std::string texto;
+};
+
+using Emissor = std::function<void(const std::vector<Ocorrencia> &)>;
+
+struct Tarefa {
+    std::string hash;
+    std::vector<std::string> versoes; // todas as versões com este conteúdo
+};
+
+class Buscador {
+public:
+    explicit Buscador(const OpcoesBusca &opcoes) : opcoes(opcoes) {
+        if (opcoes.regex) expressao = std::regex(opcoes.padrao, std::regex::ECMAScript | std::regex::optimize);
+    }
+
+    // entrega a `emitir` as ocorrências de cada trecho lido, sem acumular o arquivo todo
+    void varrer(const fs::path &arquivo, const Emissor &emitir) const {
+        LeitorVersao leitor(arquivo);
+        std::vector<char> buf(TAMANHO_BUFFER);
+        std::vector<Ocorrencia> saida;
+        size_t guardados = 0;
+        uint64_t linha_base = 1;
+        bool fim = false;
+
+        auto entregar = [&]() {
+            if (saida.empty()) return;
+            emitir(saida);
+            saida.clear();
+        };
+
+        while (!fim) {
+            size_t lidos = leitor.ler(buf.data() + guardados, buf.size() - guardados);
+            fim = lidos == 0;
+            size_t total = guardados + lidos;
+
+            // processa só linhas completas; a última parcial segue para a próxima leitura
+            size_t corte = total;
+            if (!fim) {
+                const char *nl = static_cast<const char *>(::memrchr(buf.data(), '\n', total));
+                if (!nl && total < buf.size()) {
+                    guardados = total;
+                    continue;
+                }
+                if (!nl) {
+                    // linha maior que o buffer: procura no que já chegou e guarda só os bytes
+                    // que podem começar uma ocorrência atravessando o corte (uma regex vê a
+                    // linha em pedaços do tamanho do buffer)
+                    processar(buf.data(), total, linha_base, saida);
+                    entregar();
+                    size_t manter = opcoes.regex || opcoes.padrao.empty()
+                        ? 0 : std::min(opcoes.padrao.size() - 1, buf.size() / 2);
+                    std::memmove(buf.data(), buf.data() + total - manter, manter);
+                    guardados = manter;
+                    continue;
+                }
+                corte = nl - buf.data() + 1;
+            }
+
+            linha_base += processar(buf.data(), corte, linha_base, saida);
+            entregar();
+            std::memmove(buf.data(), buf.data() + corte, total - corte);
+            guardados = total - corte;
+        }
+    }
+
+private:
+    const OpcoesBusca &opcoes;
+    std::regex expressao;
+
+    // procura em uma região de linhas completas; retorna quantas linhas ela tem
+    uint64_t processar(const char *inicio, size_t n, uint64_t linha_base, std::vector<Ocorrencia> &saida) const {
+        const char *fim = inicio + n;
+        const char *contado = inicio;
+        uint64_t linha = linha_base;
+        const char *pos = inicio;
+
+        while (pos < fim) {
+            const char *ini_linha, *fim_linha;
+            if (opcoes.regex) {
+                ini_linha = pos;
+                fim_linha = static_cast<const char *>(std::memchr(pos, '\n', fim - pos));
+                if (!fim_linha) fim_linha = fim;
+                pos = fim_linha + 1;
+                if (!std::regex_search(ini_linha, fim_linha, expressao)) continue;
+            } else {
+                size_t achado = procurar(pos, fim - pos, opcoes.padrao);
+                if (achado == std::string_view::npos) break;
+                const char *acerto = pos + achado;
+                const char *anterior = acerto > inicio
+                    ? static_cast<const char *>(::memrchr(inicio, '\n', acerto - inicio))
+                    : nullptr;
+                ini_linha = anterior ? anterior + 1 : inicio;
+                fim_linha = static_cast<const char *>(std::memchr(acerto, '\n', fim - acerto));
+                if (!fim_linha) fim_linha = fim;
+                pos = fim_linha + 1; // uma ocorrência por linha
+            }
+
+            linha += std::count(contado, ini_linha, '\n');
+            contado = ini_linha;
+            size_t tamanho = std::min<size_t>(fim_linha - ini_linha, MAX_TEXTO_LINHA);
+            saida.push_back({linha, std::string(ini_linha, tamanho)});
+        }
+        return std::count(inicio, fim, '\n');
+    }
+};
+
+// data de uma versão sem registro no índice: o mtime do arquivo no store
+std::string formatar_data(const fs::path &arquivo) {
+    std::error_code ec;
+    auto quando = fs::last_write_time(arquivo, ec);
+    if (ec) return "?";
+    auto sistema = std::chrono::file_clock::to_sys(quando);
+    return formatar_instante(std::chrono::duration_cast<std::chrono::nanoseconds>(sistema.time_since_epoch()).count());
+}
+
+} // namespace
+
+size_t buscar_versoes(const fs::path &backup_dir, const OpcoesBusca &opcoes, std::ostream &saida) {
+    // agrupa por hash: conteúdo repetido é lido uma vez só
+    std::map<std::string, size_t> por_hash;
+    std::vector<Tarefa> tarefas;
+    percorrer_versoes(backup_dir, [&](const std::string &relativo) {
+        std::string nome, hash;
+        if (!separar_versao(relativo, nome, hash)) return;
+        auto [it, novo] = por_hash.emplace(hash, tarefas.size());
+        if (novo) tarefas.push_back({hash, {}});
+        tarefas[it->second].versoes.push_back(relativo);
+    });
+
+    // as ocorrências saem assim que cada trecho é lido; a data de cada versão é a da
+    // primeira captura daquele conteúdo no índice, lido só para arquivos com ocorrências
+    IndiceVersoes indice(backup_dir);
+    std::map<std::string, std::map<std::string, int64_t>> capturas; // arquivo -> hash -> captura
+    auto data_da_versao = [&](const std::string &nome, const std::string &hash, const std::string &relativo) {
+        auto [it, novo] = capturas.try_emplace(nome);
+        if (novo) {
+            try {
+                size_t total = indice.total(nome);
+                for (size_t inicio = 0; inicio < total; inicio += 4096) {
+                    for (auto &e : indice.ler(nome, inicio, 4096)) it->second.emplace(e.hash, e.meta.captura_ns);
+                }
+            } catch (const std::exception &) {
+                // índice ilegível: vale o mtime do store
+            }
+        }
+        auto captura = it->second.find(hash);
+        return captura != it->second.end() ? formatar_instante(captura->second) : formatar_data(backup_dir / relativo);
+    };
+
+    Buscador buscador(opcoes);
+    unsigned n_threads = opcoes.threads ? opcoes.threads : std::max(1u, std::thread::hardware_concurrency());
+    n_threads = std::min<unsigned>(n_threads, std::max<size_t>(1, tarefas.size()));
+
+    std::atomic<size_t> proxima{0};
+    std::mutex saida_mutex;
+    size_t impressas = 0;
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&]() {
+            for (size_t i = proxima++; i < tarefas.size(); i = proxima++) {
+                const Tarefa &tarefa = tarefas[i];
+                std::vector<std::string> datas; // uma por versão, preenchidas na primeira ocorrência
+                auto emitir = [&](const std::vector<Ocorrencia> &ocorrencias) {
+                    std::lock_guard<std::mutex> lock(saida_mutex);
+                    for (size_t v = 0; v < tarefa.versoes.size(); ++v) {
+                        std::string nome, hash;
+                        separar_versao(tarefa.versoes[v], nome, hash);
+                        if (datas.size() <= v) datas.push_back(data_da_versao(nome, hash, tarefa.versoes[v]));
+                        for (auto &o : ocorrencias) {
+                            saida << nome << " " << hash.substr(0, 12) << " " << datas[v] << " " << o.linha << ": "
+                                  << o.texto << "\n";
+                        }
+                        impressas += ocorrencias.size();
+                    }
+                    saida.flush();
+                };
+                try {
+                    buscador.varrer(backup_dir / tarefa.versoes.front(), emitir);
+                } catch (const std::exception &e) {
+                    std::lock_guard<std::mutex> lock(saida_mutex);
+                    std::cerr << "Erro lendo " << tarefa.versoes.front() << ": " << e.what() << std::endl;
+                }
+            }
+        });
+    }
+    for (auto &t : threads) t.join();
+    return impressas;
+}
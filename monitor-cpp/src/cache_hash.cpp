@@ -0,0 +1,87 @@
+#include "cache_hash.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+
+namespace {
+
+constexpr char ATRIBUTO[] = "user.monitor.sha256";
+
+// arquivos modificados há menos que isso não entram no cache
+constexpr int64_t JANELA_RECENTE_NS = 1000000000;
+
+// tolerância entre o relógio do processo e o relógio grosso usado pelo kernel no ctime
+constexpr int64_t TOLERANCIA_CTIME_NS = 1000000000;
+
+int64_t para_ns(const timespec &t) {
+    return static_cast<int64_t>(t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+int64_t agora_ns() {
+    timespec t{};
+    ::clock_gettime(CLOCK_REALTIME, &t);
+    return para_ns(t);
+}
+
+bool cache_ligado() {
+    static const bool ligado = [] {
+        const char *v = std::getenv("MONITOR_XATTR");
+        return !(v && std::strcmp(v, "0") == 0);
+    }();
+    return ligado;
+}
+
+} // namespace
+
+bool identificar_arquivo(const std::filesystem::path &arquivo, IdentidadeArquivo &saida) {
+    struct stat st {};
+    if (::stat(arquivo.c_str(), &st) != 0) return false;
+    saida.dispositivo = st.st_dev;
+    saida.inode = st.st_ino;
+    saida.tamanho = static_cast<uint64_t>(st.st_size);
+    saida.mtime_ns = para_ns(st.st_mtim);
+    saida.ctime_ns = para_ns(st.st_ctim);
+    return true;
+}
+
+bool hash_em_cache(const std::filesystem::path &arquivo, const IdentidadeArquivo &atual, std::string &hash) {
+    if (!cache_ligado()) return false;
+    char valor[160];
+    ssize_t n = ::getxattr(arquivo.c_str(), ATRIBUTO, valor, sizeof(valor) - 1);
+    if (n <= 0) return false;
+    valor[n] = '\0';
+
+    unsigned versao = 0;
+    char hex[65] = {};
+    uint64_t inode = 0, tamanho = 0;
+    int64_t mtime = 0, gravado = 0;
+    if (std::sscanf(valor, "%u %64s %" SCNu64 " %" SCNu64 " %" SCNd64 " %" SCNd64, &versao, hex, &inode, &tamanho,
+                    &mtime, &gravado) != 6 ||
+        versao != 1 || std::strlen(hex) != 64)
+        return false;
+
+    if (inode != atual.inode || tamanho != atual.tamanho || mtime != atual.mtime_ns) return false;
+    if (atual.ctime_ns > gravado + TOLERANCIA_CTIME_NS) return false;
+    hash = hex;
+    return true;
+}
+
+void guardar_hash(const std::filesystem::path &arquivo, const IdentidadeArquivo &lida, const std::string &hash) {
+    if (!cache_ligado() || hash.size() != 64) return;
+    IdentidadeArquivo agora;
+    if (!identificar_arquivo(arquivo, agora) || agora.inode != lida.inode || agora.tamanho != lida.tamanho ||
+        agora.mtime_ns != lida.mtime_ns)
+        return;
+    int64_t instante = agora_ns();
+    if (instante - agora.mtime_ns < JANELA_RECENTE_NS) return;
+
+    char valor[160];
+    int n = std::snprintf(valor, sizeof(valor), "1 %s %" PRIu64 " %" PRIu64 " %" PRId64 " %" PRId64, hash.c_str(),
+                          agora.inode, agora.tamanho, agora.mtime_ns, instante);
+    ::setxattr(arquivo.c_str(), ATRIBUTO, valor, static_cast<size_t>(n), 0);
+}
@@ -0,0 +1,199 @@
+#include "cache_versoes.h"
+#include "cripto.h"
+#include "leitor_versao.h"
+#include "store.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <openssl/evp.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// temporários mais velhos que isso são restos de um processo interrompido
+constexpr int64_t TEMPORARIO_ABANDONADO_NS = 60LL * 1000000000;
+// entradas sem uso há mais tempo que isso saem mesmo com o orçamento sobrando
+constexpr int64_t VALIDADE_ENTRADA_NS = 3600LL * 1000000000;
+
+struct Configuracao {
+    fs::path dir; // vazio: desligado
+    uint64_t limite_bytes = 0;
+    bool cifradas = false; // aceita o conteúdo decifrado de versões cifradas
+};
+
+int64_t para_ns(const timespec &t) {
+    return static_cast<int64_t>(t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+// cria o diretório se preciso e só o aceita se for nosso e fechado para os outros
+bool diretorio_privado(const fs::path &dir) {
+    if (::mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST) return false;
+    struct stat st {};
+    if (::lstat(dir.c_str(), &st) != 0) return false;
+    return S_ISDIR(st.st_mode) && st.st_uid == ::geteuid() && (st.st_mode & 077) == 0;
+}
+
+const Configuracao &configuracao() {
+    static const Configuracao c = [] {
+        Configuracao c;
+        uint64_t mib = 0;
+        if (const char *v = std::getenv("MONITOR_CACHE_VERSOES")) mib = std::strtoull(v, nullptr, 10);
+        if (mib == 0) return c;
+
+        fs::path dir;
+        if (const char *xdg = std::getenv("XDG_RUNTIME_DIR"); xdg && *xdg && fs::is_directory(xdg))
+            dir = fs::path(xdg) / "monitor-versoes";
+        else if (fs::is_directory("/dev/shm"))
+            dir = fs::path("/dev/shm") / ("monitor-versoes-" + std::to_string(::geteuid()));
+        if (dir.empty() || !diretorio_privado(dir)) return c;
+
+        c.dir = dir;
+        c.limite_bytes = mib << 20;
+        const char *cifradas = std::getenv("MONITOR_CACHE_VERSOES_CIFRADAS");
+        c.cifradas = cifradas && std::string(cifradas) == "1";
+        return c;
+    }();
+    return c;
+}
+
+bool hash_valido(const std::string &hash) {
+    return hash.size() == 64 && std::all_of(hash.begin(), hash.end(), [](char ch) {
+               return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f');
+           });
+}
+
+// remove as entradas vencidas e as usadas há mais tempo até sobrar espaço para `novos` bytes
+void liberar_espaco(const Configuracao &c, uint64_t novos) {
+    struct Entrada {
+        int64_t uso_ns;
+        uint64_t bytes;
+        fs::path caminho;
+    };
+    std::vector<Entrada> entradas;
+    uint64_t total = 0;
+    timespec agora{};
+    ::clock_gettime(CLOCK_REALTIME, &agora);
+
+    std::error_code ec;
+    for (auto &e : fs::directory_iterator(c.dir, ec)) {
+        struct stat st {};
+        if (::lstat(e.path().c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        std::string nome = e.path().filename().string();
+        if (!hash_valido(nome)) {
+            if (para_ns(agora) - para_ns(st.st_mtim) > TEMPORARIO_ABANDONADO_NS) ::unlink(e.path().c_str());
+            continue;
+        }
+        if (para_ns(agora) - para_ns(st.st_mtim) > VALIDADE_ENTRADA_NS) {
+            ::unlink(e.path().c_str());
+            continue;
+        }
+        entradas.push_back({para_ns(st.st_mtim), static_cast<uint64_t>(st.st_size), e.path()});
+        total += static_cast<uint64_t>(st.st_size);
+    }
+    if (total + novos <= c.limite_bytes) return;
+
+    std::sort(entradas.begin(), entradas.end(), [](const Entrada &a, const Entrada &b) { return a.uso_ns < b.uso_ns; });
+    for (auto &e : entradas) {
+        if (total + novos <= c.limite_bytes) break;
+        // outro processo pode ter removido antes; quem já abriu a entrada continua lendo
+        ::unlink(e.caminho.c_str());
+        total -= e.bytes;
+    }
+}
+
+// copia o conteúdo original para `temporario` conferindo o SHA-256; false se algo falhar
+// ou se a versão for cifrada e o cache não as aceitar
+bool copiar_conferindo(const Configuracao &c, const fs::path &versao, const fs::path &temporario,
+                       const std::string &hash) {
+    int fd = ::open(temporario.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) return false;
+    EVP_MD_CTX *sha = EVP_MD_CTX_new();
+    bool ok = sha && EVP_DigestInit_ex(sha, EVP_sha256(), nullptr) == 1;
+    bool cifrada = false;
+    try {
+        LeitorVersao leitor(versao);
+        cifrada = leitor.cifrada();
+        if (cifrada && !c.cifradas) ok = false; // só por segurança: versao_materializada já recusou
+        std::vector<char> buffer(1 << 16);
+        while (ok) {
+            size_t n = leitor.ler(buffer.data(), buffer.size());
+            if (n == 0) break;
+            EVP_DigestUpdate(sha, buffer.data(), n);
+            for (size_t feito = 0; ok && feito < n;) {
+                ssize_t w = ::write(fd, buffer.data() + feito, n - feito);
+                if (w < 0 && errno == EINTR) continue;
+                if (w < 0) ok = false; // tmpfs cheio
+                else feito += static_cast<size_t>(w);
+            }
+        }
+    } catch (const std::exception &) {
+        ok = false;
+    }
+    ::close(fd);
+
+    if (ok) {
+        unsigned char bruto[32];
+        unsigned int tamanho = 0;
+        static const char digitos[] = "0123456789abcdef";
+        std::string calculado;
+        ok = EVP_DigestFinal_ex(sha, bruto, &tamanho) == 1;
+        for (unsigned int i = 0; ok && i < tamanho; ++i) {
+            calculado += digitos[bruto[i] >> 4];
+            calculado += digitos[bruto[i] & 0xF];
+        }
+        // versão corrompida não entra no cache; as cifradas são nomeadas pelo HMAC do hash
+        const ChaveCripto *chave = chave_configurada();
+        ok = ok && (calculado == hash || (cifrada && chave && hash_nome_cifrado(calculado, *chave) == hash));
+    }
+    EVP_MD_CTX_free(sha);
+    return ok;
+}
+
+} // namespace
+
+fs::path versao_materializada(const fs::path &versao) {
+    const Configuracao &c = configuracao();
+    if (c.dir.empty()) return {};
+    static const bool limpo = (liberar_espaco(c, 0), true); // vencidas de execuções anteriores
+    (void)limpo;
+
+    std::string nome, hash;
+    if (!separar_versao(versao.filename().string(), nome, hash)) return {};
+    fs::path entrada = c.dir / hash;
+
+    // sem MONITOR_CACHE_VERSOES_CIFRADAS nem uma entrada antiga de versão cifrada é usada
+    if (!c.cifradas) {
+        unsigned char cabecalho[8];
+        int fd = ::open(versao.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return {};
+        ssize_t lidos = ::pread(fd, cabecalho, sizeof(cabecalho), 0);
+        ::close(fd);
+        if (cabecalho_cifrado(cabecalho, lidos > 0 ? lidos : 0)) return {};
+    }
+
+    // acerto: o mtime passa a ser o instante deste uso
+    if (::utimensat(AT_FDCWD, entrada.c_str(), nullptr, AT_SYMLINK_NOFOLLOW) == 0) {
+        struct stat st {};
+        if (::lstat(entrada.c_str(), &st) == 0 && S_ISREG(st.st_mode)) return entrada;
+    }
+
+    // o tamanho no store é um limite superior do conteúdo (a forma cifrada é maior)
+    struct stat st {};
+    if (::stat(versao.c_str(), &st) != 0 || static_cast<uint64_t>(st.st_size) > c.limite_bytes) return {};
+    liberar_espaco(c, static_cast<uint64_t>(st.st_size));
+
+    fs::path temporario = c.dir / (hash + ".novo." + std::to_string(::getpid()));
+    if (!copiar_conferindo(c, versao, temporario, hash) || ::rename(temporario.c_str(), entrada.c_str()) != 0) {
+        ::unlink(temporario.c_str());
+        return {};
+    }
+    return entrada;
+}
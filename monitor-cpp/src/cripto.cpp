@@ -0,0 +1,290 @@
+#include "cripto.h"
+#include "integridade.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char MAGICA[8] = {'M', 'O', 'N', 'E', 'N', 'C', '0', '1'};
+
+struct Contexto {
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    ~Contexto() { EVP_CIPHER_CTX_free(ctx); }
+};
+
+void nonce_do_segmento(const unsigned char base[12], uint64_t segmento, unsigned char saida[12]) {
+    std::memcpy(saida, base, 12);
+    for (int i = 0; i < 8; ++i) saida[4 + i] ^= static_cast<unsigned char>(segmento >> (8 * i));
+}
+
+void aad_do_segmento(uint64_t segmento, bool ultimo, unsigned char saida[9]) {
+    for (int i = 0; i < 8; ++i) saida[i] = static_cast<unsigned char>(segmento >> (8 * i));
+    saida[8] = ultimo ? 1 : 0;
+}
+
+size_t ler_cheio(int fd, unsigned char *destino, size_t n) {
+    size_t total = 0;
+    while (total < n) {
+        ssize_t r = ::read(fd, destino + total, n - total);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) throw std::runtime_error(std::string("erro lendo: ") + std::strerror(errno));
+        if (r == 0) break;
+        total += r;
+    }
+    return total;
+}
+
+void escrever_tudo(int fd, const unsigned char *dados, size_t n) {
+    while (n > 0) {
+        ssize_t r = ::write(fd, dados, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) throw std::runtime_error(std::string("erro gravando: ") + std::strerror(errno));
+        dados += r;
+        n -= r;
+    }
+}
+
+std::string para_hex(const unsigned char *dados, unsigned n) {
+    static const char digitos[] = "0123456789abcdef";
+    std::string hex;
+    for (unsigned i = 0; i < n; ++i) {
+        hex += digitos[dados[i] >> 4];
+        hex += digitos[dados[i] & 0xF];
+    }
+    return hex;
+}
+
+bool carregar_chave(const std::string &arquivo, ChaveCripto &chave) {
+    std::ifstream in(arquivo, std::ios::binary);
+    if (!in) return false;
+    std::string conteudo((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (conteudo.size() == chave.size()) {
+        std::memcpy(chave.data(), conteudo.data(), chave.size());
+        return true;
+    }
+    while (!conteudo.empty() && (conteudo.back() == '\n' || conteudo.back() == '\r' || conteudo.back() == ' '))
+        conteudo.pop_back();
+    if (conteudo.size() != 64) return false;
+    for (size_t i = 0; i < 32; ++i) {
+        chave[i] = static_cast<unsigned char>(std::stoi(conteudo.substr(2 * i, 2), nullptr, 16));
+    }
+    return true;
+}
+
+} // namespace
+
+const ChaveCripto *chave_configurada() {
+    static ChaveCripto chave;
+    static const bool ativa = [] {
+        const char *arquivo = std::getenv("MONITOR_CHAVE");
+        if (!arquivo || !*arquivo) return false;
+        if (!carregar_chave(arquivo, chave))
+            throw std::runtime_error(std::string("chave inválida em ") + arquivo + " (esperado 32 bytes ou 64 hex)");
+        return true;
+    }();
+    return ativa ? &chave : nullptr;
+}
+
+bool cabecalho_cifrado(const unsigned char *dados, size_t n) {
+    return n >= sizeof(MAGICA) && std::memcmp(dados, MAGICA, sizeof(MAGICA)) == 0;
+}
+
+uint64_t tamanho_decifrado(uint64_t tamanho_cifrado) {
+    if (tamanho_cifrado < TAMANHO_CABECALHO_CRIPTO + TAMANHO_TAG_CRIPTO) return 0;
+    // todo segmento, inclusive o último (mesmo vazio), carrega uma tag
+    uint64_t corpo = tamanho_cifrado - TAMANHO_CABECALHO_CRIPTO;
+    uint64_t bloco = TAMANHO_SEGMENTO_CRIPTO + TAMANHO_TAG_CRIPTO;
+    uint64_t segmentos = (corpo + bloco - 1) / bloco;
+    return corpo - segmentos * TAMANHO_TAG_CRIPTO;
+}
+
+uint64_t tamanho_cifrado(uint64_t tamanho_claro) {
+    uint64_t segmentos = std::max<uint64_t>(1, (tamanho_claro + TAMANHO_SEGMENTO_CRIPTO - 1) / TAMANHO_SEGMENTO_CRIPTO);
+    return TAMANHO_CABECALHO_CRIPTO + tamanho_claro + segmentos * TAMANHO_TAG_CRIPTO;
+}
+
+std::string capturar_cifrado(const fs::path &origem, const fs::path &destino, const ChaveCripto &chave,
+                             uint64_t &tamanho, SomasEmFluxo *somas) {
+    int in = ::open(origem.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) throw std::runtime_error("não foi possível abrir " + origem.string());
+    int out = ::open(destino.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (out < 0) {
+        ::close(in);
+        throw std::runtime_error("não foi possível criar " + destino.string());
+    }
+    ::posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    Contexto cifra;
+    EVP_MD_CTX *sha = EVP_MD_CTX_new();
+    unsigned char cabecalho[TAMANHO_CABECALHO_CRIPTO] = {};
+    std::memcpy(cabecalho, MAGICA, sizeof(MAGICA));
+    unsigned char *nonce_base = cabecalho + sizeof(MAGICA);
+
+    // dois buffers: só se sabe que um segmento é o último quando a leitura seguinte volta vazia
+    std::vector<unsigned char> atual(TAMANHO_SEGMENTO_CRIPTO), seguinte(TAMANHO_SEGMENTO_CRIPTO);
+    std::vector<unsigned char> saida(TAMANHO_SEGMENTO_CRIPTO + TAMANHO_TAG_CRIPTO);
+    tamanho = 0;
+
+    try {
+        if (!sha || EVP_DigestInit_ex(sha, EVP_sha256(), nullptr) != 1 || RAND_bytes(nonce_base, 12) != 1 ||
+            EVP_EncryptInit_ex(cifra.ctx, EVP_aes_256_gcm(), nullptr, nullptr, nullptr) != 1)
+            throw std::runtime_error("falha inicializando OpenSSL");
+        escrever_tudo(out, cabecalho, sizeof(cabecalho));
+        if (somas) somas->atualizar(cabecalho, sizeof(cabecalho));
+
+        size_t n_atual = ler_cheio(in, atual.data(), atual.size());
+        for (uint64_t segmento = 0;; ++segmento) {
+            size_t n_seguinte = n_atual == atual.size() ? ler_cheio(in, seguinte.data(), seguinte.size()) : 0;
+            bool ultimo = n_seguinte == 0;
+
+            // hash e cifra consomem o mesmo buffer, ainda quente no cache
+            EVP_DigestUpdate(sha, atual.data(), n_atual);
+            tamanho += n_atual;
+
+            unsigned char nonce[12], aad[9];
+            nonce_do_segmento(nonce_base, segmento, nonce);
+            aad_do_segmento(segmento, ultimo, aad);
+            int len = 0, len_final = 0;
+            if (EVP_EncryptInit_ex(cifra.ctx, nullptr, nullptr, chave.data(), nonce) != 1 ||
+                EVP_EncryptUpdate(cifra.ctx, nullptr, &len, aad, sizeof(aad)) != 1 ||
+                EVP_EncryptUpdate(cifra.ctx, saida.data(), &len, atual.data(), static_cast<int>(n_atual)) != 1 ||
+                EVP_EncryptFinal_ex(cifra.ctx, saida.data() + len, &len_final) != 1 ||
+                EVP_CIPHER_CTX_ctrl(cifra.ctx, EVP_CTRL_GCM_GET_TAG, TAMANHO_TAG_CRIPTO,
+                                    saida.data() + len + len_final) != 1)
+                throw std::runtime_error("falha cifrando " + origem.string());
+            escrever_tudo(out, saida.data(), len + len_final + TAMANHO_TAG_CRIPTO);
+            if (somas) somas->atualizar(saida.data(), len + len_final + TAMANHO_TAG_CRIPTO);
+
+            if (ultimo) break;
+            std::swap(atual, seguinte);
+            n_atual = n_seguinte;
+        }
+    } catch (...) {
+        EVP_MD_CTX_free(sha);
+        ::close(in);
+        ::close(out);
+        throw;
+    }
+
+    unsigned char hash[32];
+    unsigned int len_hash = 0;
+    EVP_DigestFinal_ex(sha, hash, &len_hash);
+    EVP_MD_CTX_free(sha);
+    ::close(in);
+    ::close(out);
+
+    return para_hex(hash, len_hash);
+}
+
+std::string hash_nome_cifrado(const std::string &sha256_hex, const ChaveCripto &chave) {
+    static const char ROTULO[] = "monitor-cpp: nome de versao cifrada v1";
+    unsigned char derivada[32], digest[32], nome[32];
+    unsigned int n = 0;
+    auto valor = [](char c) { return static_cast<unsigned char>(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10); };
+    for (size_t i = 0; i < 32; ++i) {
+        digest[i] = 2 * i + 1 < sha256_hex.size()
+                        ? static_cast<unsigned char>(valor(sha256_hex[2 * i]) << 4 | valor(sha256_hex[2 * i + 1]))
+                        : 0;
+    }
+    if (!HMAC(EVP_sha256(), chave.data(), static_cast<int>(chave.size()),
+              reinterpret_cast<const unsigned char *>(ROTULO), sizeof(ROTULO) - 1, derivada, &n) ||
+        !HMAC(EVP_sha256(), derivada, sizeof(derivada), digest, sizeof(digest), nome, &n))
+        throw std::runtime_error("erro calculando o nome da versão cifrada");
+    OPENSSL_cleanse(derivada, sizeof(derivada));
+    return para_hex(nome, n);
+}
+
+DecifradorVersao::DecifradorVersao(int fd, const ChaveCripto &chave)
+    : DecifradorVersao([fd](unsigned char *destino, size_t n) { return ::ler_cheio(fd, destino, n); }, chave) {}
+
+DecifradorVersao::DecifradorVersao(Fonte fonte, const ChaveCripto &chave)
+    : fonte(std::move(fonte)), ctx(EVP_CIPHER_CTX_new()), chave(chave),
+      cifrado(TAMANHO_SEGMENTO_CRIPTO + TAMANHO_TAG_CRIPTO), claro(TAMANHO_SEGMENTO_CRIPTO) {
+    unsigned char cabecalho[TAMANHO_CABECALHO_CRIPTO];
+    if (!ctx || ler_cheio(cabecalho, sizeof(cabecalho)) != sizeof(cabecalho) ||
+        !cabecalho_cifrado(cabecalho, sizeof(cabecalho))) {
+        EVP_CIPHER_CTX_free(static_cast<EVP_CIPHER_CTX *>(ctx));
+        throw std::runtime_error("cabeçalho de versão cifrada inválido");
+    }
+    std::memcpy(nonce_base, cabecalho + sizeof(MAGICA), 12);
+    EVP_DecryptInit_ex(static_cast<EVP_CIPHER_CTX *>(ctx), EVP_aes_256_gcm(), nullptr, nullptr, nullptr);
+    claro.resize(0);
+}
+
+DecifradorVersao::~DecifradorVersao() {
+    EVP_CIPHER_CTX_free(static_cast<EVP_CIPHER_CTX *>(ctx));
+}
+
+bool DecifradorVersao::proximo_segmento() {
+    if (ultimo_lido) return false;
+
+    cifrado.resize(TAMANHO_SEGMENTO_CRIPTO + TAMANHO_TAG_CRIPTO);
+    size_t n = ler_cheio(cifrado.data(), cifrado.size());
+    if (n < TAMANHO_TAG_CRIPTO) throw std::runtime_error("versão cifrada truncada");
+
+    // o último segmento é o que não está cheio ou o que é seguido pelo fim do arquivo
+    bool ultimo = n < cifrado.size();
+    if (!ultimo) {
+        unsigned char proximo;
+        ultimo = fonte(&proximo, 1) == 0;
+        if (!ultimo) espiado = proximo;
+    }
+
+    auto *c = static_cast<EVP_CIPHER_CTX *>(ctx);
+    size_t n_dados = n - TAMANHO_TAG_CRIPTO;
+    unsigned char nonce[12], aad[9];
+    nonce_do_segmento(nonce_base, segmento, nonce);
+    aad_do_segmento(segmento, ultimo, aad);
+    claro.resize(n_dados);
+    int len = 0, len_final = 0;
+    if (EVP_DecryptInit_ex(c, nullptr, nullptr, chave.data(), nonce) != 1 ||
+        EVP_DecryptUpdate(c, nullptr, &len, aad, sizeof(aad)) != 1 ||
+        EVP_DecryptUpdate(c, claro.data(), &len, cifrado.data(), static_cast<int>(n_dados)) != 1 ||
+        EVP_CIPHER_CTX_ctrl(c, EVP_CTRL_GCM_SET_TAG, TAMANHO_TAG_CRIPTO, cifrado.data() + n_dados) != 1 ||
+        EVP_DecryptFinal_ex(c, claro.data() + len, &len_final) != 1)
+        throw std::runtime_error("falha de autenticação na versão cifrada (chave errada ou dados corrompidos)");
+
+    pos_claro = 0;
+    ++segmento;
+    ultimo_lido = ultimo;
+    return true;
+}
+
+size_t DecifradorVersao::ler_cheio(unsigned char *destino, size_t n) {
+    size_t total = 0;
+    if (n > 0 && espiado >= 0) {
+        destino[total++] = static_cast<unsigned char>(espiado);
+        espiado = -1;
+    }
+    while (total < n) {
+        size_t r = fonte(destino + total, n - total);
+        if (r == 0) break;
+        total += r;
+    }
+    return total;
+}
+
+size_t DecifradorVersao::ler(char *destino, size_t n) {
+    while (pos_claro == claro.size()) {
+        if (!proximo_segmento()) return 0;
+    }
+    size_t parte = std::min(n, claro.size() - pos_claro);
+    std::memcpy(destino, claro.data() + pos_claro, parte);
+    pos_claro += parte;
+    return parte;
+}
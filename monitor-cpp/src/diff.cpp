@@ -0,0 +1,318 @@
+#include "diff.h"
+#include "leitor_versao.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t TAMANHO_BUFFER = 1 << 20;
+constexpr size_t JANELA_LINHAS = 4096;
+constexpr size_t JANELA_BYTES = 16 << 20;
+constexpr size_t MAX_LINHA = 64 * 1024; // linhas maiores são quebradas em pedaços deste tamanho
+constexpr int MAX_EDICOES = 2048;
+constexpr size_t BLOCO_BINARIO = 4096;
+
+// buffer de leitura sobre uma versão, com consumo parcial e leitura por linha
+class Fluxo {
+public:
+    explicit Fluxo(const fs::path &arquivo) : leitor(arquivo), buf(TAMANHO_BUFFER) {}
+
+    std::string_view disponivel() const { return std::string_view(buf.data() + ini, fim - ini); }
+    void consumir(size_t n) { ini += n; }
+    bool terminou() const { return eof && ini == fim; }
+    bool eof = false;
+
+    // acrescenta mais dados ao que já está disponível; false no fim do arquivo. O buffer
+    // não cresce: quem pede mais dados nunca precisa de mais que MAX_LINHA de uma vez
+    bool encher() {
+        if (eof) return false;
+        if (ini == fim) ini = fim = 0;
+        if (fim == buf.size()) {
+            if (ini == 0) return true;
+            std::memmove(buf.data(), buf.data() + ini, fim - ini);
+            fim -= ini;
+            ini = 0;
+        }
+        size_t r = leitor.ler(buf.data() + fim, buf.size() - fim);
+        if (r == 0) {
+            eof = true;
+            return false;
+        }
+        fim += r;
+        return true;
+    }
+
+    // próxima linha, sem o '\n'; uma linha com mais de MAX_LINHA bytes sai em pedaços
+    bool linha(std::string &saida) {
+        size_t procurado = ini;
+        while (true) {
+            size_t limite = std::min(fim, ini + MAX_LINHA + 1);
+            const char *nl = static_cast<const char *>(std::memchr(buf.data() + procurado, '\n', limite - procurado));
+            if (nl) {
+                size_t pos = nl - buf.data();
+                saida.assign(buf.data() + ini, pos - ini);
+                ini = pos + 1;
+                return true;
+            }
+            if (fim - ini > MAX_LINHA) {
+                saida.assign(buf.data() + ini, MAX_LINHA);
+                ini += MAX_LINHA;
+                return true;
+            }
+            procurado = fim - ini; // posição relativa, válida após compactar
+            if (!encher()) {
+                if (ini == fim) return false;
+                saida.assign(buf.data() + ini, fim - ini);
+                ini = fim;
+                return true;
+            }
+            procurado += ini;
+        }
+    }
+
+private:
+    LeitorVersao leitor;
+    std::vector<char> buf;
+    size_t ini = 0, fim = 0;
+};
+
+// linhas (contando os pedaços de MAX_LINHA, como Fluxo::linha) em um trecho que começa
+// no início de uma linha e termina num '\n'
+uint64_t contar_linhas(std::string_view trecho) {
+    uint64_t linhas = 0;
+    while (!trecho.empty()) {
+        size_t tamanho = trecho.find('\n');
+        linhas += std::max<size_t>(1, (tamanho + MAX_LINHA - 1) / MAX_LINHA);
+        trecho.remove_prefix(tamanho + 1);
+    }
+    return linhas;
+}
+
+// descarta o prefixo comum das duas versões sem quebrá-lo em linhas, parando no início
+// da primeira linha que difere; retorna true se o restante das duas for idêntico
+bool pular_iguais(Fluxo &a, Fluxo &b, uint64_t &linhas) {
+    while (true) {
+        std::string_view sa = a.disponivel(), sb = b.disponivel();
+        size_t n = std::min(sa.size(), sb.size());
+        size_t m = std::mismatch(sa.begin(), sa.begin() + n, sb.begin()).first - sa.begin();
+
+        size_t corte = sa.substr(0, m).rfind('\n');
+        if (corte != std::string_view::npos) {
+            linhas += contar_linhas(sa.substr(0, corte + 1));
+            a.consumir(corte + 1);
+            b.consumir(corte + 1);
+            continue;
+        }
+        if (m > MAX_LINHA) {
+            // primeiro pedaço de uma linha longa, igual nas duas
+            ++linhas;
+            a.consumir(MAX_LINHA);
+            b.consumir(MAX_LINHA);
+            continue;
+        }
+        if (m < n) return false;
+
+        bool a_curto = sa.size() == n, b_curto = sb.size() == n;
+        bool mais_a = a_curto ? a.encher() : true;
+        bool mais_b = b_curto ? b.encher() : true;
+        if ((a_curto && !mais_a) || (b_curto && !mais_b)) {
+            return a.terminou() && b.terminou() && sa.size() == sb.size();
+        }
+    }
+}
+
+enum class Op : char { IGUAL, REMOVE, INSERE };
+
+// algoritmo de Myers; false se o número de edições passar do limite
+bool myers(const std::vector<std::string> &a, const std::vector<std::string> &b, std::vector<Op> &ops) {
+    const int n = static_cast<int>(a.size()), m = static_cast<int>(b.size());
+    const int max = n + m;
+    std::vector<int> v(2 * max + 3, 0);
+    const int off = max + 1;
+    std::vector<std::vector<int>> historico; // v[-(d+1)..d+1] antes do passo d
+
+    int d_final = -1;
+    for (int d = 0; d <= std::min(max, MAX_EDICOES) && d_final < 0; ++d) {
+        historico.emplace_back(v.begin() + off - d - 1, v.begin() + off + d + 2);
+        for (int k = -d; k <= d; k += 2) {
+            int x = (k == -d || (k != d && v[off + k - 1] < v[off + k + 1])) ? v[off + k + 1] : v[off + k - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && a[x] == b[y]) ++x, ++y;
+            v[off + k] = x;
+            if (x >= n && y >= m) {
+                d_final = d;
+                break;
+            }
+        }
+    }
+    if (d_final < 0) return false;
+
+    ops.clear();
+    int x = n, y = m;
+    for (int d = d_final; d >= 0; --d) {
+        const std::vector<int> &h = historico[d];
+        auto val = [&](int k) { return h[k + d + 1]; };
+        int k = x - y;
+        int k_ant = (k == -d || (k != d && val(k - 1) < val(k + 1))) ? k + 1 : k - 1;
+        int x_ant = val(k_ant), y_ant = x_ant - k_ant;
+        while (x > x_ant && y > y_ant) {
+            ops.push_back(Op::IGUAL);
+            --x, --y;
+        }
+        if (d > 0) ops.push_back(x == x_ant ? Op::INSERE : Op::REMOVE);
+        x = x_ant, y = y_ant;
+    }
+    std::reverse(ops.begin(), ops.end());
+    return true;
+}
+
+void escrever_bloco(std::ostream &saida, const std::vector<std::string> &a, const std::vector<std::string> &b,
+                    size_t ia, size_t na, size_t ib, size_t nb, uint64_t base_a, uint64_t base_b) {
+    if (na == 0 && nb == 0) return;
+    uint64_t inicio_a = base_a + ia - (na == 0 ? 1 : 0);
+    uint64_t inicio_b = base_b + ib - (nb == 0 ? 1 : 0);
+    saida << "@@ -" << inicio_a << "," << na << " +" << inicio_b << "," << nb << " @@\n";
+    for (size_t i = 0; i < na; ++i) saida << "-" << a[ia + i] << "\n";
+    for (size_t i = 0; i < nb; ++i) saida << "+" << b[ib + i] << "\n";
+}
+
+// lê linhas até a janela ter JANELA_LINHAS linhas ou JANELA_BYTES bytes
+void completar_janela(Fluxo &f, std::vector<std::string> &linhas) {
+    size_t bytes = 0;
+    for (auto &l : linhas) bytes += l.size();
+    std::string linha;
+    while (linhas.size() < JANELA_LINHAS && bytes < JANELA_BYTES && f.linha(linha)) {
+        bytes += linha.size();
+        linhas.push_back(std::move(linha));
+    }
+}
+
+bool diff_texto(Fluxo &fa, Fluxo &fb, std::ostream &saida) {
+    std::vector<std::string> la, lb;
+    std::vector<Op> ops;
+    uint64_t base_a = 1, base_b = 1;
+    bool igual = true;
+
+    while (true) {
+        if (la.empty() && lb.empty()) {
+            uint64_t puladas = 0;
+            bool resto_igual = pular_iguais(fa, fb, puladas);
+            base_a += puladas;
+            base_b += puladas;
+            if (resto_igual) break;
+        }
+
+        completar_janela(fa, la);
+        completar_janela(fb, lb);
+        if (la.empty() && lb.empty()) break;
+        bool fim = fa.terminou() && fb.terminou();
+
+        size_t ia = 0, ib = 0;
+        if (!myers(la, lb, ops)) {
+            // diferença grande demais para a janela: tudo vira remoção + inserção
+            escrever_bloco(saida, la, lb, 0, la.size(), 0, lb.size(), base_a, base_b);
+            igual = false;
+            ia = la.size();
+            ib = lb.size();
+        } else {
+            size_t bloco_a = 0, bloco_b = 0, na = 0, nb = 0;
+            for (Op op : ops) {
+                if (op == Op::IGUAL) {
+                    if (na || nb) {
+                        escrever_bloco(saida, la, lb, bloco_a, na, bloco_b, nb, base_a, base_b);
+                        igual = false;
+                        na = nb = 0;
+                    }
+                    // corta a janela em um ponto de sincronia: o resto é rediffado com mais contexto
+                    if (!fim && (ia >= la.size() / 2 || ib >= lb.size() / 2)) break;
+                    ++ia, ++ib;
+                } else {
+                    if (!na && !nb) bloco_a = ia, bloco_b = ib;
+                    if (op == Op::REMOVE) ++ia, ++na;
+                    else ++ib, ++nb;
+                }
+            }
+            if (na || nb) {
+                escrever_bloco(saida, la, lb, bloco_a, na, bloco_b, nb, base_a, base_b);
+                igual = false;
+            }
+        }
+
+        la.erase(la.begin(), la.begin() + ia);
+        lb.erase(lb.begin(), lb.begin() + ib);
+        base_a += ia;
+        base_b += ib;
+
+        // linhas iguais no início da sobra voltam para o caminho rápido por blocos
+        size_t comuns = 0;
+        while (comuns < la.size() && comuns < lb.size() && la[comuns] == lb[comuns]) ++comuns;
+        la.erase(la.begin(), la.begin() + comuns);
+        lb.erase(lb.begin(), lb.begin() + comuns);
+        base_a += comuns;
+        base_b += comuns;
+    }
+    return igual;
+}
+
+bool diff_binario(Fluxo &fa, Fluxo &fb, std::ostream &saida) {
+    uint64_t posicao = 0, inicio_faixa = 0;
+    bool em_faixa = false, igual = true;
+
+    auto fechar_faixa = [&](uint64_t fim) {
+        if (!em_faixa) return;
+        saida << "bytes 0x" << std::hex << inicio_faixa << "-0x" << (fim - 1) << std::dec << " diferem\n";
+        em_faixa = false;
+        igual = false;
+    };
+
+    while (true) {
+        if (fa.disponivel().size() < BLOCO_BINARIO) fa.encher();
+        if (fb.disponivel().size() < BLOCO_BINARIO) fb.encher();
+        std::string_view sa = fa.disponivel(), sb = fb.disponivel();
+        size_t n = std::min({sa.size(), sb.size(), BLOCO_BINARIO});
+        if (n == 0) break;
+
+        bool bloco_igual = std::memcmp(sa.data(), sb.data(), n) == 0;
+        if (!bloco_igual && !em_faixa) {
+            em_faixa = true;
+            inicio_faixa = posicao;
+        } else if (bloco_igual) {
+            fechar_faixa(posicao);
+        }
+        fa.consumir(n);
+        fb.consumir(n);
+        posicao += n;
+    }
+    fechar_faixa(posicao);
+
+    // conta o que sobrou da versão mais longa sem guardar nada
+    uint64_t resto_a = 0, resto_b = 0;
+    do { resto_a += fa.disponivel().size(); fa.consumir(fa.disponivel().size()); } while (fa.encher());
+    do { resto_b += fb.disponivel().size(); fb.consumir(fb.disponivel().size()); } while (fb.encher());
+    resto_a += fa.disponivel().size();
+    resto_b += fb.disponivel().size();
+    if (resto_a != resto_b) {
+        saida << "tamanhos diferem: " << posicao + resto_a << " bytes vs " << posicao + resto_b << " bytes\n";
+        igual = false;
+    }
+    return igual;
+}
+
+bool parece_binario(Fluxo &f) {
+    while (f.disponivel().size() < 8192 && f.encher()) {}
+    std::string_view s = f.disponivel().substr(0, 8192);
+    return s.find('\0') != std::string_view::npos;
+}
+
+} // namespace
+
+bool diff_versoes(const fs::path &versao_a, const fs::path &versao_b, std::ostream &saida) {
+    Fluxo fa(versao_a), fb(versao_b);
+    if (parece_binario(fa) || parece_binario(fb)) return diff_binario(fa, fb, saida);
+    return diff_texto(fa, fb, saida);
+}
@@ -0,0 +1,571 @@
+#include "exportar.h"
+#include "cripto.h"
+#include "indice.h"
+#include "integridade.h"
+#include "leitor_versao.h"
+#include "motor_es.h"
+#include "store.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t BLOCO = 512;
+constexpr size_t REGISTRO = 20 * BLOCO; // tamanho de registro tradicional do tar
+constexpr size_t MAX_TRANSFERENCIA = 1 << 30;
+
+// arquivos que cada trabalhador da restauração pega de uma vez (profundidade do MotorES)
+constexpr size_t LOTE_RESTAURACAO = 32;
+constexpr unsigned MAX_TRABALHADORES_RESTAURACAO = 4;
+
+struct CabecalhoTar {
+    char nome[100];
+    char modo[8];
+    char uid[8];
+    char gid[8];
+    char tamanho[12];
+    char mtime[12];
+    char soma[8];
+    char tipo;
+    char link[100];
+    char magica[6];
+    char versao[2];
+    char usuario[32];
+    char grupo[32];
+    char dev_maior[8];
+    char dev_menor[8];
+    char prefixo[155];
+    char preenchimento[12];
+};
+static_assert(sizeof(CabecalhoTar) == BLOCO, "cabeçalho tar deve ter 512 bytes");
+
+class SaidaTar {
+public:
+    explicit SaidaTar(int fd) : fd(fd) {
+        struct stat st {};
+        pipe = ::fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+    }
+
+    void escrever(const void *dados, size_t n) {
+        auto *p = static_cast<const char *>(dados);
+        while (n > 0) {
+            ssize_t w = ::write(fd, p, n);
+            if (w < 0 && errno == EINTR) continue;
+            if (w < 0) throw std::runtime_error(std::string("erro escrevendo o tar: ") + std::strerror(errno));
+            p += w;
+            n -= w;
+            total += w;
+        }
+    }
+
+    void completar_bloco() {
+        static const char zeros[BLOCO] = {};
+        if (total % BLOCO) escrever(zeros, BLOCO - total % BLOCO);
+    }
+
+    // dois blocos zerados e preenchimento até o fim do registro
+    void finalizar() {
+        static const char zeros[REGISTRO] = {};
+        escrever(zeros, 2 * BLOCO);
+        if (total % REGISTRO) escrever(zeros, REGISTRO - total % REGISTRO);
+    }
+
+    // copia `n` bytes de `in` no kernel; false se o tipo de saída não suportar
+    bool transferir(int in, uint64_t n) {
+        off_t deslocamento = 0;
+        while (n > 0) {
+            size_t parte = std::min<uint64_t>(n, MAX_TRANSFERENCIA);
+            ssize_t r = pipe ? ::splice(in, &deslocamento, fd, nullptr, parte, SPLICE_F_MOVE | SPLICE_F_MORE)
+                             : ::sendfile(fd, in, &deslocamento, parte);
+            if (r < 0 && errno == EINTR) continue;
+            if (r < 0 && (errno == EINVAL || errno == ENOSYS) && deslocamento == 0) return false;
+            if (r < 0) throw std::runtime_error(std::string("erro exportando versão: ") + std::strerror(errno));
+            if (r == 0) throw std::runtime_error("versão encolheu durante a exportação");
+            n -= r;
+            total += r;
+        }
+        return true;
+    }
+
+private:
+    int fd;
+    bool pipe = false;
+    uint64_t total = 0;
+};
+
+bool cabe_octal(uint64_t valor, size_t largura) {
+    return (largura - 1) * 3 >= 64 || valor < (uint64_t(1) << ((largura - 1) * 3));
+}
+
+void octal(char *campo, size_t largura, uint64_t valor) {
+    std::snprintf(campo, largura, "%0*llo", static_cast<int>(largura - 1), static_cast<unsigned long long>(valor));
+}
+
+// registro pax "<comprimento> chave=valor\n", em que o comprimento conta os próprios dígitos
+std::string registro_pax(const std::string &chave, const std::string &valor) {
+    size_t corpo = chave.size() + valor.size() + 3;
+    size_t n = corpo + 1;
+    while (std::to_string(n).size() + corpo != n) n = std::to_string(n).size() + corpo;
+    return std::to_string(n) + " " + chave + "=" + valor + "\n";
+}
+
+// ustar guarda até 155 bytes de diretório em `prefixo` e 100 de nome
+bool dividir_nome(const std::string &caminho, std::string &prefixo, std::string &nome) {
+    if (caminho.size() <= sizeof(CabecalhoTar::nome)) {
+        prefixo.clear();
+        nome = caminho;
+        return true;
+    }
+    for (size_t barra = caminho.find('/'); barra != std::string::npos; barra = caminho.find('/', barra + 1)) {
+        if (barra > sizeof(CabecalhoTar::prefixo)) break;
+        if (caminho.size() - barra - 1 <= sizeof(CabecalhoTar::nome)) {
+            prefixo = caminho.substr(0, barra);
+            nome = caminho.substr(barra + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+void escrever_cabecalho(SaidaTar &saida, const std::string &prefixo, const std::string &nome, char tipo,
+                        uint64_t tamanho, unsigned modo, int64_t mtime, uint32_t uid, uint32_t gid) {
+    CabecalhoTar h{};
+    std::memcpy(h.nome, nome.data(), std::min(nome.size(), sizeof(h.nome)));
+    std::memcpy(h.prefixo, prefixo.data(), std::min(prefixo.size(), sizeof(h.prefixo)));
+    octal(h.modo, sizeof(h.modo), modo & 07777);
+    octal(h.uid, sizeof(h.uid), cabe_octal(uid, sizeof(h.uid)) ? uid : 0);
+    octal(h.gid, sizeof(h.gid), cabe_octal(gid, sizeof(h.gid)) ? gid : 0);
+    octal(h.tamanho, sizeof(h.tamanho), cabe_octal(tamanho, sizeof(h.tamanho)) ? tamanho : 0);
+    octal(h.mtime, sizeof(h.mtime), static_cast<uint64_t>(std::max<int64_t>(mtime, 0)));
+    h.tipo = tipo;
+    std::memcpy(h.magica, "ustar", 6);
+    std::memcpy(h.versao, "00", 2);
+
+    std::memset(h.soma, ' ', sizeof(h.soma));
+    unsigned soma = 0;
+    for (size_t i = 0; i < sizeof(h); ++i) soma += reinterpret_cast<const unsigned char *>(&h)[i];
+    std::snprintf(h.soma, sizeof(h.soma), "%06o", soma);
+    h.soma[7] = ' ';
+    saida.escrever(&h, sizeof(h));
+}
+
+void escrever_entrada(SaidaTar &saida, const std::string &caminho, uint64_t tamanho, const struct stat &st,
+                      int64_t mtime) {
+    std::string prefixo, nome, pax;
+    if (!dividir_nome(caminho, prefixo, nome)) {
+        pax += registro_pax("path", caminho);
+        prefixo.clear();
+        nome = caminho.substr(caminho.size() - sizeof(CabecalhoTar::nome));
+    }
+    if (!cabe_octal(tamanho, sizeof(CabecalhoTar::tamanho))) pax += registro_pax("size", std::to_string(tamanho));
+
+    if (!pax.empty()) {
+        escrever_cabecalho(saida, "", "PaxHeaders/" + fs::path(caminho).filename().string().substr(0, 80), 'x',
+                           pax.size(), 0644, mtime, 0, 0);
+        saida.escrever(pax.data(), pax.size());
+        saida.completar_bloco();
+    }
+    escrever_cabecalho(saida, prefixo, nome, '0', tamanho, st.st_mode, mtime, st.st_uid, st.st_gid);
+}
+
+// versão de `nome` vigente no instante: a de maior captura até ele
+bool versao_no_instante(IndiceVersoes &indice, const std::string &nome, int64_t instante_ns,
+                        IndiceVersoes::Entrada &saida) {
+    const size_t LOTE = 4096;
+    size_t total = indice.total(nome);
+    bool achou = false;
+    for (size_t inicio = 0; inicio < total; inicio += LOTE) {
+        for (auto &e : indice.ler(nome, inicio, LOTE)) {
+            if (e.meta.captura_ns <= instante_ns && (!achou || e.meta.captura_ns >= saida.meta.captura_ns)) {
+                saida = std::move(e);
+                achou = true;
+            }
+        }
+    }
+    return achou;
+}
+
+// permissões do arquivo de origem gravadas no índice; entradas antigas, sem elas, usam
+// as da própria versão (certas para as em texto claro, 0600 para as cifradas)
+unsigned modo_da_entrada(const IndiceVersoes::Entrada &entrada, const struct stat &st) {
+    return entrada.meta.modo ? entrada.meta.modo & 07777 : st.st_mode & 07777;
+}
+
+std::set<std::string> arquivos_no_store(const fs::path &backup_dir) {
+    std::set<std::string> nomes;
+    percorrer_versoes(backup_dir, [&](const std::string &relativo) {
+        std::string nome, hash;
+        if (separar_versao(relativo, nome, hash)) nomes.insert(nome);
+    });
+    return nomes;
+}
+
+void definir_mtime(const fs::path &arquivo, int64_t mtime_ns) {
+    timespec tempos[2] = {{0, UTIME_OMIT}, {mtime_ns / 1000000000, mtime_ns % 1000000000}};
+    ::utimensat(AT_FDCWD, arquivo.c_str(), tempos, 0);
+}
+
+// conteúdo original da versão, decifrado se preciso
+void copiar_versao(LeitorVersao &leitor, const fs::path &destino, unsigned modo, std::vector<char> &buffer) {
+    int out = ::open(destino.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, modo);
+    if (out < 0) throw std::runtime_error("não foi possível criar " + destino.string() + ": " + std::strerror(errno));
+    try {
+        while (size_t n = leitor.ler(buffer.data(), buffer.size())) {
+            for (size_t feito = 0; feito < n;) {
+                ssize_t w = ::write(out, buffer.data() + feito, n - feito);
+                if (w < 0 && errno == EINTR) continue;
+                if (w < 0) throw std::runtime_error("erro gravando " + destino.string() + ": " + std::strerror(errno));
+                feito += w;
+            }
+        }
+    } catch (...) {
+        ::close(out);
+        throw;
+    }
+    ::close(out);
+}
+
+void copiar_versao(const fs::path &versao, const fs::path &destino, unsigned modo, std::vector<char> &buffer) {
+    LeitorVersao leitor(versao);
+    copiar_versao(leitor, destino, modo, buffer);
+}
+
+// reflink da versão; false se o sistema de arquivos não suportar (e `suportado` vira false)
+bool clonar_versao(int in, const fs::path &destino, unsigned modo, bool &suportado) {
+    int out = ::open(destino.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, modo);
+    if (out < 0) throw std::runtime_error("não foi possível criar " + destino.string() + ": " + std::strerror(errno));
+    int r = ::ioctl(out, FICLONE, in);
+    int erro = errno;
+    ::close(out);
+    if (r == 0) return true;
+    ::unlink(destino.c_str());
+    if (erro == EOPNOTSUPP || erro == ENOTTY || erro == EINVAL || erro == EXDEV || erro == EPERM)
+        suportado = false;
+    else
+        throw std::runtime_error("erro clonando " + destino.string() + ": " + std::strerror(erro));
+    return false;
+}
+
+// nome de trabalho ao lado de `arquivo`, na mesma pasta para que o rename seja atômico
+fs::path nome_temporario(const fs::path &arquivo) {
+    return arquivo.parent_path() /
+           ("." + arquivo.filename().string() + ".restaurando-" + std::to_string(::getpid()));
+}
+
+// posição física do início do arquivo no dispositivo; false se o sistema de arquivos
+// não informar (ou o arquivo não tiver extents)
+bool posicao_fisica(int fd, uint64_t &posicao) {
+    alignas(fiemap) char buffer[sizeof(fiemap) + sizeof(fiemap_extent)] = {};
+    auto *mapa = reinterpret_cast<fiemap *>(buffer);
+    mapa->fm_start = 0;
+    mapa->fm_length = FIEMAP_MAX_OFFSET;
+    mapa->fm_extent_count = 1;
+    if (::ioctl(fd, FS_IOC_FIEMAP, mapa) != 0 || mapa->fm_mapped_extents == 0) return false;
+    posicao = mapa->fm_extents[0].fe_physical;
+    return true;
+}
+
+} // namespace
+
+size_t exportar_tar(const fs::path &backup_dir, int64_t instante_ns, int fd) {
+    std::set<std::string> nomes = arquivos_no_store(backup_dir);
+
+    SaidaTar saida(fd);
+    IndiceVersoes indice(backup_dir);
+    std::vector<char> buffer(1 << 16);
+    size_t exportados = 0;
+
+    for (auto &nome : nomes) {
+        IndiceVersoes::Entrada entrada;
+        if (!versao_no_instante(indice, nome, instante_ns, entrada)) continue;
+
+        fs::path versao = backup_dir / (nome + "_" + entrada.hash);
+        int in = ::open(versao.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            std::cerr << "⚠️ Versão ausente no store: " << versao << std::endl;
+            continue;
+        }
+        struct stat st {};
+        unsigned char inicio[TAMANHO_CABECALHO_CRIPTO] = {};
+        ssize_t lidos = ::pread(in, inicio, sizeof(inicio), 0);
+        bool cifrada = lidos > 0 && cabecalho_cifrado(inicio, static_cast<size_t>(lidos));
+        ::fstat(in, &st);
+        uint64_t tamanho = cifrada ? tamanho_decifrado(st.st_size) : static_cast<uint64_t>(st.st_size);
+        st.st_mode = (st.st_mode & ~07777) | modo_da_entrada(entrada, st);
+        int64_t mtime_ns = entrada.meta.mtime_origem_ns ? entrada.meta.mtime_origem_ns : entrada.meta.captura_ns;
+
+        try {
+            // com somas, cada bloco é conferido (e reconstruído pela paridade) antes de ir
+            // para a saída; só as versões sem somas vão pelo kernel
+            LeitorVersao leitor(versao);
+            escrever_entrada(saida, nome, tamanho, st, mtime_ns / 1000000000);
+            if (cifrada || leitor.conferida() || !saida.transferir(in, tamanho)) {
+                uint64_t escritos = 0;
+                while (size_t n = leitor.ler(buffer.data(), buffer.size())) {
+                    saida.escrever(buffer.data(), n);
+                    escritos += n;
+                }
+                if (escritos != tamanho) throw std::runtime_error("tamanho inesperado em " + versao.string());
+            }
+        } catch (...) {
+            ::close(in);
+            throw;
+        }
+        ::close(in);
+        saida.completar_bloco();
+        ++exportados;
+    }
+    saida.finalizar();
+    return exportados;
+}
+
+ResultadoSnapshot criar_snapshot(const fs::path &backup_dir, int64_t instante_ns, const fs::path &destino) {
+    std::error_code ec;
+    if (fs::exists(destino, ec) && !fs::is_empty(destino, ec))
+        throw std::runtime_error(destino.string() + " já existe e não está vazio");
+    fs::create_directories(destino);
+
+    IndiceVersoes indice(backup_dir);
+    std::vector<char> buffer(1 << 16);
+    ResultadoSnapshot r;
+    bool reflink = true;
+
+    for (auto &nome : arquivos_no_store(backup_dir)) {
+        IndiceVersoes::Entrada entrada;
+        if (!versao_no_instante(indice, nome, instante_ns, entrada)) continue;
+
+        fs::path versao = backup_dir / (nome + "_" + entrada.hash);
+        int in = ::open(versao.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            std::cerr << "⚠️ Versão ausente no store: " << versao << std::endl;
+            continue;
+        }
+        struct stat st {};
+        unsigned char inicio[TAMANHO_CABECALHO_CRIPTO] = {};
+        ssize_t lidos = ::pread(in, inicio, sizeof(inicio), 0);
+        bool cifrada = lidos > 0 && cabecalho_cifrado(inicio, static_cast<size_t>(lidos));
+        ::fstat(in, &st);
+        unsigned modo = modo_da_entrada(entrada, st);
+        int64_t mtime_ns = entrada.meta.mtime_origem_ns ? entrada.meta.mtime_origem_ns : entrada.meta.captura_ns;
+
+        fs::path arquivo = destino / nome;
+        try {
+            fs::create_directories(arquivo.parent_path());
+            if (cifrada) {
+                copiar_versao(versao, arquivo, modo, buffer);
+                definir_mtime(arquivo, mtime_ns);
+                ++r.copiados;
+            } else if (reflink && clonar_versao(in, arquivo, modo, reflink)) {
+                definir_mtime(arquivo, mtime_ns);
+                ++r.clonados;
+            } else if (::link(versao.c_str(), arquivo.c_str()) == 0) {
+                ++r.ligados;
+            } else if (errno == EMLINK) {
+                // a versão já está em snapshots demais para outro link
+                copiar_versao(versao, arquivo, modo, buffer);
+                definir_mtime(arquivo, mtime_ns);
+                ++r.copiados;
+            } else if (errno == EXDEV) {
+                throw std::runtime_error("o snapshot precisa ficar no mesmo sistema de arquivos do store (" +
+                                         backup_dir.string() + ")");
+            } else {
+                throw std::runtime_error("não foi possível criar " + arquivo.string() + ": " + std::strerror(errno));
+            }
+        } catch (...) {
+            ::close(in);
+            throw;
+        }
+        ::close(in);
+    }
+    return r;
+}
+
+ResultadoRestauracao restaurar_arvore(const fs::path &backup_dir, int64_t instante_ns, const fs::path &destino,
+                                      unsigned threads) {
+    struct Item {
+        std::string nome;
+        fs::path versao;
+        std::string hash;
+        unsigned modo;
+        int64_t mtime_ns;
+        uint64_t posicao;
+    };
+    ResultadoRestauracao r;
+
+    // 1. versões vigentes e onde estão no disco: só metadados, nenhum dado é lido aqui
+    std::vector<Item> itens;
+    IndiceVersoes indice(backup_dir);
+    for (auto &nome : arquivos_no_store(backup_dir)) {
+        IndiceVersoes::Entrada entrada;
+        if (!versao_no_instante(indice, nome, instante_ns, entrada)) continue;
+        fs::path versao = backup_dir / (nome + "_" + entrada.hash);
+        int fd = ::open(versao.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st {};
+        if (fd < 0 || ::fstat(fd, &st) != 0) {
+            if (fd >= 0) ::close(fd);
+            std::cerr << "⚠️ Versão ausente no store: " << versao << std::endl;
+            ++r.erros;
+            continue;
+        }
+        uint64_t posicao = 0;
+        if (posicao_fisica(fd, posicao)) r.fiemap = true;
+        else posicao = st.st_ino;
+        ::close(fd);
+        int64_t mtime_ns = entrada.meta.mtime_origem_ns ? entrada.meta.mtime_origem_ns : entrada.meta.captura_ns;
+        itens.push_back({nome, std::move(versao), entrada.hash, modo_da_entrada(entrada, st), mtime_ns, posicao});
+    }
+    std::sort(itens.begin(), itens.end(), [](const Item &a, const Item &b) { return a.posicao < b.posicao; });
+
+    // diretórios antes dos trabalhadores, que só criam arquivos
+    std::set<fs::path> pastas;
+    for (auto &item : itens) pastas.insert((destino / item.nome).parent_path());
+    for (auto &p : pastas) fs::create_directories(p);
+
+    // 2. lotes consecutivos da ordem física, distribuídos entre os trabalhadores
+    if (threads == 0) threads = std::min(MAX_TRABALHADORES_RESTAURACAO, std::max(1u, std::thread::hardware_concurrency()));
+    std::atomic<size_t> proximo{0};
+    std::atomic<size_t> arquivos{0}, erros{0};
+    std::atomic<uint64_t> bytes{0};
+    std::mutex mutex_saida;
+    auto falhou = [&](const fs::path &arquivo, const std::string &motivo) {
+        std::lock_guard<std::mutex> l(mutex_saida);
+        std::cerr << "⚠️ " << arquivo.string() << ": " << motivo << std::endl;
+        ++erros;
+    };
+
+    // o arquivo completo substitui o destino de uma vez; até lá o atual continua intacto
+    auto publicar = [&](const fs::path &temporario, const fs::path &arquivo, int64_t mtime_ns) {
+        definir_mtime(temporario, mtime_ns);
+        if (::rename(temporario.c_str(), arquivo.c_str()) == 0) return true;
+        int erro = errno;
+        ::unlink(temporario.c_str());
+        falhou(arquivo, std::strerror(erro));
+        return false;
+    };
+
+    auto trabalhar = [&] {
+        MotorES motor(LOTE_RESTAURACAO);
+        std::vector<char> buffer(1 << 16);
+        while (true) {
+            size_t inicio = proximo.fetch_add(LOTE_RESTAURACAO);
+            if (inicio >= itens.size()) return;
+            size_t fim = std::min(inicio + LOTE_RESTAURACAO, itens.size());
+
+            // leitura antecipada do lote que vem depois deste na ordem física
+            for (size_t i = fim; i < std::min(fim + LOTE_RESTAURACAO, itens.size()); ++i) {
+                int fd = ::open(itens[i].versao.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd < 0) continue;
+                ::posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+                ::close(fd);
+            }
+
+            std::vector<ArquivoLote> lote;
+            std::vector<size_t> origem;
+            for (size_t i = inicio; i < fim; ++i) {
+                const Item &item = itens[i];
+                fs::path arquivo = destino / item.nome;
+                fs::path temporario = nome_temporario(arquivo);
+                ::unlink(temporario.c_str()); // resto de uma restauração interrompida
+
+                int fd = ::open(item.versao.c_str(), O_RDONLY | O_CLOEXEC);
+                unsigned char cabecalho[TAMANHO_CABECALHO_CRIPTO] = {};
+                ssize_t lidos = fd < 0 ? -1 : ::pread(fd, cabecalho, sizeof(cabecalho), 0);
+                if (fd >= 0) ::close(fd);
+                if (lidos > 0 && cabecalho_cifrado(cabecalho, static_cast<size_t>(lidos))) {
+                    try {
+                        copiar_versao(item.versao, temporario, item.modo, buffer);
+                        std::error_code ec;
+                        uint64_t tamanho = fs::file_size(temporario, ec);
+                        if (publicar(temporario, arquivo, item.mtime_ns)) {
+                            bytes += tamanho;
+                            ++arquivos;
+                        }
+                    } catch (const std::exception &e) {
+                        ::unlink(temporario.c_str());
+                        falhou(arquivo, e.what());
+                    }
+                    continue;
+                }
+                // o MotorES não passa pelo LeitorVersao: o tamanho é conferido antes e o
+                // conteúdo inteiro pelo SHA-256 calculado na própria cópia
+                try {
+                    conferir_tamanho(item.versao);
+                } catch (const std::exception &e) {
+                    falhou(arquivo, e.what());
+                    continue;
+                }
+                lote.push_back({.origem = item.versao, .destino = temporario, .modo = item.modo});
+                origem.push_back(i);
+            }
+
+            motor.executar(lote, true, false);
+            for (size_t k = 0; k < lote.size(); ++k) {
+                const Item &item = itens[origem[k]];
+                if (lote[k].erro == 0 && lote[k].hash != item.hash) {
+                    // a cópia não confere: o LeitorVersao acha o bloco ruim pelas somas e o
+                    // reconstrói pela paridade, se houver
+                    ::unlink(lote[k].destino.c_str());
+                    try {
+                        LeitorVersao leitor(item.versao);
+                        if (!leitor.conferida()) throw std::runtime_error("conteúdo não confere com o hash da versão");
+                        copiar_versao(leitor, lote[k].destino, item.modo, buffer);
+                        // a cópia refeita também precisa bater com o nome da versão
+                        std::vector<ArquivoLote> refeita{{.origem = lote[k].destino}};
+                        motor.executar(refeita, true, false);
+                        if (refeita[0].erro != 0 || refeita[0].hash != item.hash)
+                            throw std::runtime_error("conteúdo não confere com o hash da versão");
+                        lote[k].hash = refeita[0].hash;
+                        lote[k].bytes = refeita[0].bytes;
+                    } catch (const std::exception &e) {
+                        ::unlink(lote[k].destino.c_str());
+                        falhou(destino / item.nome, e.what());
+                        continue;
+                    }
+                }
+                if (lote[k].erro != 0) {
+                    ::unlink(lote[k].destino.c_str());
+                    falhou(destino / item.nome, std::strerror(lote[k].erro));
+                    continue;
+                }
+                if (publicar(lote[k].destino, destino / item.nome, item.mtime_ns)) {
+                    bytes += lote[k].bytes;
+                    ++arquivos;
+                }
+            }
+        }
+    };
+    std::vector<std::thread> trabalhadores;
+    for (unsigned t = 1; t < threads; ++t) trabalhadores.emplace_back(trabalhar);
+    trabalhar();
+    for (auto &t : trabalhadores) t.join();
+
+    int fd = ::open(destino.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::syncfs(fd);
+        ::close(fd);
+    }
+    r.arquivos = arquivos;
+    r.bytes = bytes;
+    r.erros += erros;
+    return r;
+}
@@ -0,0 +1,125 @@
+#include "fanotify.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/fanotify.h>
+#include <sys/statfs.h>
+#include <system_error>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// conteúdo final de arquivos e entradas novas; diretórios novos chegam com FAN_ONDIR.
+// FAN_MODIFY cobre arquivos que ficam abertos (logs, bancos de dados, mmap)
+constexpr uint64_t MASCARA = FAN_CLOSE_WRITE | FAN_MODIFY | FAN_CREATE | FAN_MOVED_TO | FAN_ONDIR;
+
+uint64_t para_fsid(const void *fsid) {
+    uint64_t v = 0;
+    std::memcpy(&v, fsid, sizeof(v));
+    return v;
+}
+
+} // namespace
+
+FonteFanotify::FonteFanotify(const std::vector<fs::path> &pastas) : buffer(256 * 1024) {
+    fd = ::fanotify_init(FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME | FAN_CLOEXEC | FAN_NONBLOCK, O_RDONLY | O_LARGEFILE);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "fanotify_init");
+
+    try {
+        marcar(pastas);
+    } catch (...) {
+        for (auto &m : montagens) ::close(m.fd);
+        ::close(fd);
+        throw;
+    }
+}
+
+void FonteFanotify::marcar(const std::vector<fs::path> &pastas) {
+    for (auto &pasta : pastas) {
+        struct statfs st {};
+        if (::statfs(pasta.c_str(), &st) != 0) throw std::system_error(errno, std::generic_category(), pasta.string());
+        uint64_t fsid = para_fsid(&st.f_fsid);
+        bool marcado = false;
+        for (auto &m : montagens) marcado |= m.fsid == fsid;
+        if (marcado) continue;
+
+        if (::fanotify_mark(fd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, MASCARA, AT_FDCWD, pasta.c_str()) != 0)
+            throw std::system_error(errno, std::generic_category(), "fanotify_mark " + pasta.string());
+        int fd_montagem = ::open(pasta.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd_montagem < 0) throw std::system_error(errno, std::generic_category(), pasta.string());
+        montagens.push_back({fsid, fd_montagem});
+    }
+}
+
+FonteFanotify::~FonteFanotify() {
+    for (auto &m : montagens) ::close(m.fd);
+    if (fd >= 0) ::close(fd);
+}
+
+std::string FonteFanotify::resolver_diretorio(uint64_t fsid, const void *handle) {
+    int fd_montagem = -1;
+    for (auto &m : montagens) {
+        if (m.fsid == fsid) fd_montagem = m.fd;
+    }
+    if (fd_montagem < 0) return {};
+
+    // open_by_handle_at não aceita ponteiro const; o handle fica no buffer de eventos
+    auto *fh = static_cast<file_handle *>(const_cast<void *>(handle));
+    int dir = ::open_by_handle_at(fd_montagem, fh, O_PATH | O_CLOEXEC);
+    if (dir < 0) return {}; // ESTALE: diretório já removido
+
+    char caminho[4096];
+    std::string link = "/proc/self/fd/" + std::to_string(dir);
+    ssize_t n = ::readlink(link.c_str(), caminho, sizeof(caminho));
+    ::close(dir);
+    if (n <= 0 || static_cast<size_t>(n) == sizeof(caminho)) return {};
+    return std::string(caminho, n);
+}
+
+bool FonteFanotify::aguardar(std::chrono::milliseconds espera, std::vector<fs::path> &saida,
+                             std::vector<fs::path> &modificados) {
+    pollfd p{fd, POLLIN, 0};
+    if (::poll(&p, 1, static_cast<int>(espera.count())) <= 0) return true;
+
+    // o mesmo diretório costuma aparecer em muitos eventos seguidos
+    std::unordered_map<std::string, std::string> diretorios;
+    bool completo = true;
+    while (true) {
+        ssize_t lidos = ::read(fd, buffer.data(), buffer.size());
+        if (lidos < 0 && errno == EINTR) continue;
+        if (lidos <= 0) break; // EAGAIN: fila vazia
+
+        auto *evento = reinterpret_cast<const fanotify_event_metadata *>(buffer.data());
+        for (; FAN_EVENT_OK(evento, lidos); evento = FAN_EVENT_NEXT(evento, lidos)) {
+            if (evento->vers != FANOTIFY_METADATA_VERSION) continue;
+            if (evento->mask & FAN_Q_OVERFLOW) {
+                completo = false;
+                continue;
+            }
+
+            auto *info = reinterpret_cast<const fanotify_event_info_fid *>(evento + 1);
+            if (evento->event_len < sizeof(*evento) + sizeof(*info) ||
+                info->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME)
+                continue;
+            auto *fh = reinterpret_cast<const file_handle *>(info->handle);
+            const char *nome = reinterpret_cast<const char *>(fh->f_handle + fh->handle_bytes);
+
+            std::string chave(reinterpret_cast<const char *>(&info->fsid), sizeof(info->fsid));
+            chave.append(reinterpret_cast<const char *>(fh), sizeof(*fh) + fh->handle_bytes);
+            auto it = diretorios.find(chave);
+            if (it == diretorios.end()) it = diretorios.emplace(chave, resolver_diretorio(para_fsid(&info->fsid), fh)).first;
+            if (it->second.empty()) continue;
+
+            // o kernel junta eventos repetidos do mesmo arquivo ainda na fila, então um só
+            // evento pode trazer FAN_MODIFY e FAN_CLOSE_WRITE: vale o fechamento
+            bool so_escrita = (evento->mask & (FAN_CLOSE_WRITE | FAN_CREATE | FAN_MOVED_TO)) == 0;
+            (so_escrita ? modificados : saida).push_back(fs::path(it->second) / nome);
+        }
+    }
+    return completo;
+}
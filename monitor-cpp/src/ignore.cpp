@@ -0,0 +1,344 @@
+#include "ignore.h"
+
+#include <algorithm>
+#include <fnmatch.h>
+#include <fstream>
+
+namespace {
+
+bool tem_metacaractere(std::string_view s) {
+    return s.find_first_of("*?[\\") != std::string_view::npos;
+}
+
+void inserir_unico(std::vector<uint32_t> &v, uint32_t x) {
+    if (std::find(v.begin(), v.end(), x) == v.end()) v.push_back(x);
+}
+
+void inserir_tamanho(std::vector<size_t> &v, size_t x) {
+    if (std::find(v.begin(), v.end(), x) == v.end()) v.push_back(x);
+}
+
+// unidades de um glob: caractere literal (0..255), curinga de um caractere ou "*"
+constexpr int UM_CARACTERE = -1;
+constexpr int ESTRELA = -2;
+
+// fim de uma classe "[...]" que começa em `i`; npos se ela não fechar (o fnmatch então
+// trata o '[' como literal, mas como curinga de um caractere ele só deixa de ser chave)
+size_t fim_classe(std::string_view p, size_t i) {
+    size_t k = i + 1;
+    if (k < p.size() && (p[k] == '!' || p[k] == '^')) ++k;
+    if (k < p.size() && p[k] == ']') ++k;
+    while (k < p.size() && p[k] != ']') {
+        if (p[k] == '[' && k + 1 < p.size() && (p[k + 1] == ':' || p[k + 1] == '.' || p[k + 1] == '=')) {
+            size_t fecha = p.find(std::string{p[k + 1], ']'}, k + 2);
+            if (fecha != std::string_view::npos) {
+                k = fecha + 2;
+                continue;
+            }
+        }
+        k += p[k] == '\\' && k + 1 < p.size() ? 2 : 1;
+    }
+    return k < p.size() ? k : std::string_view::npos;
+}
+
+std::vector<int> unidades_glob(std::string_view p) {
+    std::vector<int> unidades;
+    for (size_t i = 0; i < p.size();) {
+        char c = p[i];
+        if (c == '*') {
+            unidades.push_back(ESTRELA);
+            ++i;
+        } else if (c == '\\' && i + 1 < p.size()) {
+            unidades.push_back(static_cast<unsigned char>(p[i + 1]));
+            i += 2;
+        } else if (c == '?' || c == '\\') {
+            unidades.push_back(UM_CARACTERE);
+            ++i;
+        } else if (c == '[') {
+            size_t fim = fim_classe(p, i);
+            unidades.push_back(UM_CARACTERE);
+            i = fim == std::string_view::npos ? i + 1 : fim + 1;
+        } else {
+            unidades.push_back(static_cast<unsigned char>(c));
+            ++i;
+        }
+    }
+    return unidades;
+}
+
+// maior sequência de literais em [inicio, fim): devolve a posição e preenche `literal`
+size_t maior_literal(const std::vector<int> &u, size_t inicio, size_t fim, std::string &literal) {
+    size_t melhor = inicio, tamanho = 0;
+    for (size_t i = inicio; i < fim;) {
+        if (u[i] < 0) {
+            ++i;
+            continue;
+        }
+        size_t j = i;
+        while (j < fim && u[j] >= 0) ++j;
+        if (j - i > tamanho) {
+            melhor = i;
+            tamanho = j - i;
+        }
+        i = j;
+    }
+    literal.clear();
+    for (size_t i = melhor; i < melhor + tamanho; ++i) literal.push_back(static_cast<char>(u[i]));
+    return melhor;
+}
+
+} // namespace
+
+FiltroIgnorar::FiltroIgnorar() {
+    novo_no(); // raiz
+}
+
+uint32_t FiltroIgnorar::novo_no() {
+    nos.emplace_back();
+    return static_cast<uint32_t>(nos.size() - 1);
+}
+
+// Os trechos literais que um nome precisa ter para casar com o glob: a maior sequência
+// de literais antes do primeiro '*', a partir do início, e a maior depois do último,
+// a partir do fim. Só contam unidades de largura fixa, então a posição do trecho no
+// nome é conhecida. Preenche `chave` com os trechos do próprio padrão.
+FiltroIgnorar::FormaGlob FiltroIgnorar::forma_glob(std::string_view padrao, std::string &chave) {
+    std::vector<int> u = unidades_glob(padrao);
+    size_t primeira = std::find(u.begin(), u.end(), ESTRELA) - u.begin();
+    size_t ultima = u.rend() - std::find(u.rbegin(), u.rend(), ESTRELA);
+
+    FormaGlob forma;
+    std::string inicio, fim;
+    forma.deslocamento_inicio = maior_literal(u, 0, primeira, inicio);
+    forma.tamanho_inicio = inicio.size();
+    if (primeira < u.size()) {
+        size_t pos = maior_literal(u, ultima, u.size(), fim);
+        forma.tamanho_fim = fim.size();
+        forma.deslocamento_fim = fim.empty() ? 0 : u.size() - pos - fim.size();
+    }
+    if (forma.tamanho_inicio == 0) forma.deslocamento_inicio = 0;
+    chave = inicio + '/' + fim; // '/' não aparece em um componente
+    return forma;
+}
+
+// a chave do nome na forma dada; false se o nome for curto demais para ela
+bool FiltroIgnorar::chave_glob(const FormaGlob &forma, std::string_view nome, std::string &chave) {
+    if (forma.deslocamento_inicio + forma.tamanho_inicio > nome.size() ||
+        forma.deslocamento_fim + forma.tamanho_fim > nome.size())
+        return false;
+    chave.assign(nome.substr(forma.deslocamento_inicio, forma.tamanho_inicio));
+    chave += '/';
+    chave += nome.substr(nome.size() - forma.deslocamento_fim - forma.tamanho_fim, forma.tamanho_fim);
+    return true;
+}
+
+// devolve (criando se preciso) o nó alcançado a partir de `no` pelo componente;
+// com `literal`, o componente é um nome de pasta e não um padrão
+uint32_t FiltroIgnorar::filho_para(uint32_t no, const std::string &componente, bool literal) {
+    if (!literal && componente == "**") {
+        if (nos[no].duplo == NENHUM) {
+            uint32_t d = novo_no();
+            nos[no].duplo = d;
+            nos[d].duplo = d; // "**" consome qualquer quantidade de componentes
+        }
+        return nos[no].duplo;
+    }
+
+    enum { LITERAL, SUFIXO, PREFIXO, GLOB } tipo = GLOB;
+    std::string chave;
+
+    if (literal || !tem_metacaractere(componente)) {
+        tipo = LITERAL;
+        chave = componente;
+    } else if (componente[0] == '*' && !tem_metacaractere(std::string_view(componente).substr(1))) {
+        tipo = SUFIXO;
+        chave = componente.substr(1);
+    } else if (componente.back() == '*' &&
+               !tem_metacaractere(std::string_view(componente).substr(0, componente.size() - 1))) {
+        tipo = PREFIXO;
+        chave = componente.substr(0, componente.size() - 1);
+    }
+
+    if (tipo != GLOB) {
+        auto tabela = [&]() -> std::unordered_map<std::string, uint32_t> & {
+            if (tipo == LITERAL) return nos[no].literais;
+            return tipo == SUFIXO ? nos[no].sufixos : nos[no].prefixos;
+        };
+        auto it = tabela().find(chave);
+        if (it != tabela().end()) return it->second;
+        uint32_t f = novo_no(); // pode realocar `nos`
+        tabela().emplace(chave, f);
+        if (tipo == SUFIXO) inserir_tamanho(nos[no].tamanhos_sufixo, chave.size());
+        if (tipo == PREFIXO) inserir_tamanho(nos[no].tamanhos_prefixo, chave.size());
+        return f;
+    }
+
+    FormaGlob forma = forma_glob(componente, chave);
+    auto grupo = nos[no].globs.find(chave);
+    if (grupo != nos[no].globs.end()) {
+        for (auto &[padrao, f] : grupo->second) {
+            if (padrao == componente) return f;
+        }
+    }
+    uint32_t f = novo_no(); // pode realocar `nos`
+    nos[no].globs[chave].emplace_back(componente, f);
+    auto &formas = nos[no].formas_glob;
+    if (std::find(formas.begin(), formas.end(), forma) == formas.end()) formas.push_back(forma);
+    return f;
+}
+
+void FiltroIgnorar::adicionar_regra(std::string_view linha, std::string_view base) {
+    while (!linha.empty() && (linha.back() == ' ' || linha.back() == '\t' || linha.back() == '\r'))
+        linha.remove_suffix(1);
+    if (linha.empty() || linha[0] == '#') return;
+
+    Regra regra{false, false};
+    if (linha[0] == '!') {
+        regra.negar = true;
+        linha.remove_prefix(1);
+    } else if (linha.size() > 1 && linha[0] == '\\' && (linha[1] == '!' || linha[1] == '#')) {
+        linha.remove_prefix(1);
+    }
+    if (!linha.empty() && linha.back() == '/') {
+        regra.so_diretorio = true;
+        while (!linha.empty() && linha.back() == '/') linha.remove_suffix(1);
+    }
+    if (linha.empty()) return;
+
+    // sem barra (fora a final) a regra vale em qualquer nível, como "**/regra"
+    bool ancorada = linha.find('/') != std::string_view::npos;
+    while (!linha.empty() && linha[0] == '/') linha.remove_prefix(1);
+    if (linha.empty()) return;
+
+    // regras de uma subpasta começam pelo caminho dela, com cada nome tomado literalmente
+    std::vector<std::string> componentes;
+    for (size_t inicio = 0; inicio < base.size();) {
+        size_t fim = std::min(base.find('/', inicio), base.size());
+        if (fim > inicio) componentes.emplace_back(base.substr(inicio, fim - inicio));
+        inicio = fim + 1;
+    }
+    size_t literais = componentes.size();
+    if (!ancorada) componentes.emplace_back("**");
+    size_t inicio = 0;
+    while (inicio <= linha.size()) {
+        size_t fim = linha.find('/', inicio);
+        if (fim == std::string_view::npos) fim = linha.size();
+        std::string comp(linha.substr(inicio, fim - inicio));
+        if (!comp.empty() && !(comp == "**" && !componentes.empty() && componentes.back() == "**"))
+            componentes.push_back(std::move(comp));
+        inicio = fim + 1;
+    }
+
+    uint32_t no = 0;
+    for (size_t i = 0; i < componentes.size(); ++i) no = filho_para(no, componentes[i], i < literais);
+
+    int32_t indice = static_cast<int32_t>(regras.size());
+    regras.push_back(regra);
+    if (regra.so_diretorio) nos[no].regra_dir = indice;
+    else nos[no].regra = indice;
+}
+
+bool FiltroIgnorar::carregar(const std::filesystem::path &arquivo, std::string_view base) {
+    std::ifstream in(arquivo);
+    if (!in) return false;
+    std::string linha;
+    while (std::getline(in, linha)) adicionar_regra(linha, base);
+    return true;
+}
+
+size_t FiltroIgnorar::carregar_arvore(const std::filesystem::path &raiz) {
+    size_t arquivos = carregar(raiz / NOME_ARQUIVO) ? 1 : 0;
+    std::vector<std::string> pastas{""};
+    while (!pastas.empty()) {
+        std::string relativo = std::move(pastas.back());
+        pastas.pop_back();
+        // refeito a partir da raiz: as regras carregadas desde a pasta de cima criam nós novos
+        Estado estado = estado_de(relativo), filho;
+        std::error_code ec;
+        for (auto &entry : std::filesystem::directory_iterator(raiz / relativo, ec)) {
+            if (!entry.is_directory(ec) || entry.is_symlink(ec)) continue;
+            std::string nome = entry.path().filename().string();
+            if (ignorado(estado, nome, true, filho)) continue;
+            std::string sub = relativo.empty() ? nome : relativo + '/' + nome;
+            if (carregar(entry.path() / NOME_ARQUIVO, sub)) ++arquivos;
+            pastas.push_back(std::move(sub));
+        }
+    }
+    return arquivos;
+}
+
+// estado de uma pasta não ignorada, descendo da raiz pelos componentes
+FiltroIgnorar::Estado FiltroIgnorar::estado_de(std::string_view relativo) const {
+    Estado estado = estado_inicial(), filho;
+    for (size_t inicio = 0; inicio < relativo.size();) {
+        size_t fim = std::min(relativo.find('/', inicio), relativo.size());
+        if (ignorado(estado, relativo.substr(inicio, fim - inicio), true, filho)) return {};
+        std::swap(estado, filho);
+        inicio = fim + 1;
+    }
+    return estado;
+}
+
+// fecho: um nó com "**" também está ativo no nó "**" (zero componentes)
+void FiltroIgnorar::fechar(std::vector<uint32_t> &conjunto, uint32_t no) const {
+    inserir_unico(conjunto, no);
+    uint32_t d = nos[no].duplo;
+    if (d != NENHUM && d != no) inserir_unico(conjunto, d);
+}
+
+void FiltroIgnorar::avancar(uint32_t indice, std::string_view nome, std::vector<uint32_t> &saida) const {
+    const No &no = nos[indice];
+
+    if (no.duplo == indice) inserir_unico(saida, indice);
+
+    if (!no.literais.empty()) {
+        auto it = no.literais.find(std::string(nome));
+        if (it != no.literais.end()) inserir_unico(saida, it->second);
+    }
+    for (size_t t : no.tamanhos_sufixo) {
+        if (t > nome.size()) continue;
+        auto it = no.sufixos.find(std::string(nome.substr(nome.size() - t)));
+        if (it != no.sufixos.end()) inserir_unico(saida, it->second);
+    }
+    for (size_t t : no.tamanhos_prefixo) {
+        if (t > nome.size()) continue;
+        auto it = no.prefixos.find(std::string(nome.substr(0, t)));
+        if (it != no.prefixos.end()) inserir_unico(saida, it->second);
+    }
+    if (!no.globs.empty()) {
+        std::string s(nome), chave;
+        for (const FormaGlob &forma : no.formas_glob) {
+            if (!chave_glob(forma, nome, chave)) continue;
+            auto grupo = no.globs.find(chave);
+            if (grupo == no.globs.end()) continue;
+            for (auto &[padrao, f] : grupo->second) {
+                if (fnmatch(padrao.c_str(), s.c_str(), 0) == 0) inserir_unico(saida, f);
+            }
+        }
+    }
+}
+
+FiltroIgnorar::Estado FiltroIgnorar::estado_inicial() const {
+    Estado e;
+    fechar(e.nos, 0);
+    return e;
+}
+
+bool FiltroIgnorar::ignorado(const Estado &pai, std::string_view nome, bool diretorio, Estado &filho) const {
+    std::vector<uint32_t> diretos;
+    for (uint32_t n : pai.nos) avancar(n, nome, diretos);
+
+    // vence a última regra (maior índice) que casar, como no git
+    int32_t melhor = -1;
+    for (uint32_t n : diretos) {
+        melhor = std::max(melhor, nos[n].regra);
+        if (diretorio) melhor = std::max(melhor, nos[n].regra_dir);
+    }
+    if (melhor >= 0 && !regras[melhor].negar) return true;
+
+    filho.nos.clear();
+    if (diretorio) {
+        for (uint32_t n : diretos) fechar(filho.nos, n);
+    }
+    return false;
+}
@@ -0,0 +1,300 @@
+#include "indice.h"
+#include "cripto.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char MAGICA[8] = {'M', 'O', 'N', 'I', 'D', 'X', '0', '1'};
+
+struct Cabecalho {
+    char magica[8];
+    uint32_t versao;
+    uint32_t tamanho_registro;
+};
+
+// registro em disco (little-endian, 64 bytes)
+struct Registro {
+    int64_t captura_ns;
+    uint64_t tamanho;
+    int64_t mtime_origem_ns;
+    uint8_t hash[32];
+    uint32_t modo;
+    uint32_t reservado;
+};
+static_assert(sizeof(Registro) == 64, "registro do índice deve ter 64 bytes");
+
+// versão 1, sem o modo: ainda lida, e convertida na primeira gravação
+struct RegistroV1 {
+    int64_t captura_ns;
+    uint64_t tamanho;
+    int64_t mtime_origem_ns;
+    uint8_t hash[32];
+};
+static_assert(sizeof(RegistroV1) == 56, "registro da versão 1 do índice deve ter 56 bytes");
+
+void hex_para_bytes(const std::string &hex, uint8_t saida[32]) {
+    auto valor = [](char c) -> uint8_t { return c <= '9' ? c - '0' : c - 'a' + 10; };
+    for (size_t i = 0; i < 32; ++i)
+        saida[i] = 2 * i + 1 < hex.size() ? static_cast<uint8_t>(valor(hex[2 * i]) << 4 | valor(hex[2 * i + 1])) : 0;
+}
+
+std::string bytes_para_hex(const uint8_t hash[32]) {
+    static const char digitos[] = "0123456789abcdef";
+    std::string s(64, '0');
+    for (size_t i = 0; i < 32; ++i) {
+        s[2 * i] = digitos[hash[i] >> 4];
+        s[2 * i + 1] = digitos[hash[i] & 0xF];
+    }
+    return s;
+}
+
+IndiceVersoes::Entrada para_entrada(const Registro &r) {
+    return {{r.captura_ns, r.tamanho, r.mtime_origem_ns, r.modo}, bytes_para_hex(r.hash)};
+}
+
+int abrir_indice(const fs::path &arquivo, int flags) {
+    int fd = ::open(arquivo.c_str(), flags | O_CLOEXEC, 0644);
+    if (fd < 0 && (flags & O_CREAT))
+        throw std::runtime_error("não foi possível abrir " + arquivo.string() + ": " + std::strerror(errno));
+    return fd;
+}
+
+// tamanho dos registros declarado no cabeçalho; 0 se o cabeçalho for inválido
+uint32_t tamanho_registro(int fd) {
+    Cabecalho c{};
+    if (::pread(fd, &c, sizeof(c), 0) != sizeof(c) || std::memcmp(c.magica, MAGICA, 8) != 0) return 0;
+    if (c.versao == 2 && c.tamanho_registro == sizeof(Registro)) return sizeof(Registro);
+    if (c.versao == 1 && c.tamanho_registro == sizeof(RegistroV1)) return sizeof(RegistroV1);
+    return 0;
+}
+
+void escrever_cabecalho(int fd) {
+    Cabecalho c{};
+    std::memcpy(c.magica, MAGICA, 8);
+    c.versao = 2;
+    c.tamanho_registro = sizeof(Registro);
+    if (::pwrite(fd, &c, sizeof(c), 0) != sizeof(c)) throw std::runtime_error("erro escrevendo cabeçalho do índice");
+}
+
+size_t contar(int fd, uint32_t tamanho) {
+    struct stat st {};
+    if (tamanho == 0 || ::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Cabecalho)) return 0;
+    return (st.st_size - sizeof(Cabecalho)) / tamanho;
+}
+
+// lê até `quantidade` registros a partir de `inicio`, convertendo os da versão 1
+std::vector<Registro> ler_registros(int fd, uint32_t tamanho, size_t inicio, size_t quantidade) {
+    std::vector<Registro> registros;
+    if (tamanho == sizeof(Registro)) {
+        registros.resize(quantidade);
+        ssize_t lidos = ::pread(fd, registros.data(), quantidade * sizeof(Registro),
+                                sizeof(Cabecalho) + inicio * sizeof(Registro));
+        registros.resize(lidos > 0 ? lidos / sizeof(Registro) : 0);
+        return registros;
+    }
+    std::vector<RegistroV1> antigos(quantidade);
+    ssize_t lidos = ::pread(fd, antigos.data(), quantidade * sizeof(RegistroV1),
+                            sizeof(Cabecalho) + inicio * sizeof(RegistroV1));
+    antigos.resize(lidos > 0 ? lidos / sizeof(RegistroV1) : 0);
+    for (auto &a : antigos) {
+        Registro r{a.captura_ns, a.tamanho, a.mtime_origem_ns, {}, 0, 0};
+        std::memcpy(r.hash, a.hash, 32);
+        registros.push_back(r);
+    }
+    return registros;
+}
+
+// grava o índice inteiro com outro nome e renomeia
+void gravar_indice(const fs::path &arquivo, const std::vector<Registro> &registros) {
+    fs::path temporario = arquivo;
+    temporario += ".novo";
+    fs::create_directories(arquivo.parent_path());
+    int fd = abrir_indice(temporario, O_RDWR | O_CREAT | O_TRUNC);
+    escrever_cabecalho(fd);
+    size_t bytes = registros.size() * sizeof(Registro);
+    bool ok = ::pwrite(fd, registros.data(), bytes, sizeof(Cabecalho)) == static_cast<ssize_t>(bytes);
+    ::close(fd);
+    if (!ok) throw std::runtime_error("erro gravando " + temporario.string());
+    fs::rename(temporario, arquivo);
+}
+
+} // namespace
+
+std::string formatar_instante(int64_t ns) {
+    std::time_t t = static_cast<std::time_t>(ns / 1000000000);
+    std::tm tm{};
+    localtime_r(&t, &tm);
+    std::ostringstream oss;
+    oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
+    return oss.str();
+}
+
+bool interpretar_instante(const std::string &texto, int64_t &ns) {
+    if (!texto.empty() && texto.find_first_not_of("0123456789") == std::string::npos) {
+        long long segundos = 0;
+        try {
+            segundos = std::stoll(texto);
+        } catch (const std::out_of_range &) {
+            return false;
+        }
+        if (segundos > INT64_MAX / 1000000000) return false;
+        ns = static_cast<int64_t>(segundos) * 1000000000;
+        return true;
+    }
+    for (const char *formato : {"%Y-%m-%d %H:%M:%S", "%Y-%m-%dT%H:%M:%S", "%Y-%m-%d"}) {
+        std::tm tm{};
+        const char *fim = ::strptime(texto.c_str(), formato, &tm);
+        if (!fim || *fim != '\0') continue;
+        tm.tm_isdst = -1;
+        ns = static_cast<int64_t>(std::mktime(&tm)) * 1000000000;
+        return true;
+    }
+    return false;
+}
+
+IndiceVersoes::IndiceVersoes(const fs::path &backup_dir)
+    : backup_dir(backup_dir), dir_indice(backup_dir / ".monitor" / "indice") {}
+
+fs::path IndiceVersoes::arquivo_indice(const std::string &nome) const {
+    return dir_indice / (nome + ".idx");
+}
+
+void IndiceVersoes::adicionar(const std::string &nome, const std::string &hash, const MetadadosVersao &meta) {
+    fs::path arquivo = arquivo_indice(nome);
+    fs::create_directories(arquivo.parent_path());
+    int fd = abrir_indice(arquivo, O_RDWR | O_CREAT);
+
+    uint32_t tamanho = tamanho_registro(fd);
+    size_t n = contar(fd, tamanho);
+    if (tamanho == sizeof(RegistroV1)) {
+        // índice da versão 1: reescrito com o modo desconhecido (0) nas entradas antigas
+        std::vector<Registro> registros = ler_registros(fd, tamanho, 0, n);
+        ::close(fd);
+        gravar_indice(arquivo, registros);
+        fd = abrir_indice(arquivo, O_RDWR | O_CREAT);
+        tamanho = sizeof(Registro);
+    } else if (tamanho == 0) {
+        struct stat st {};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            ::close(fd);
+            throw std::runtime_error("índice inválido: " + arquivo.string());
+        }
+        escrever_cabecalho(fd);
+        n = 0;
+    }
+
+    Registro r{meta.captura_ns, meta.tamanho, meta.mtime_origem_ns, {}, meta.modo, 0};
+    hex_para_bytes(hash, r.hash);
+
+    if (n > 0) {
+        Registro ultimo{};
+        off_t pos = sizeof(Cabecalho) + (n - 1) * sizeof(Registro);
+        if (::pread(fd, &ultimo, sizeof(ultimo), pos) == sizeof(ultimo) &&
+            std::memcmp(ultimo.hash, r.hash, 32) == 0 && ultimo.captura_ns == r.captura_ns) {
+            ::close(fd);
+            return;
+        }
+    }
+
+    off_t pos = sizeof(Cabecalho) + n * sizeof(Registro);
+    bool ok = ::pwrite(fd, &r, sizeof(r), pos) == sizeof(r);
+    ::close(fd);
+    if (!ok) throw std::runtime_error("erro escrevendo índice de " + nome);
+}
+
+// versões gravadas antes do índice existir: usa o mtime do arquivo no store como captura
+// e as permissões da versão como modo, menos nas cifradas, que são sempre 0600
+void IndiceVersoes::reconstruir(const std::string &nome) {
+    fs::path pasta = (backup_dir / nome).parent_path();
+    std::string base = fs::path(nome).filename().string() + "_";
+    std::vector<Registro> registros;
+
+    std::error_code ec;
+    for (auto &entry : fs::directory_iterator(pasta, ec)) {
+        std::string arquivo = entry.path().filename().string();
+        if (!entry.is_regular_file(ec) || arquivo.rfind(base, 0) != 0 || arquivo.size() != base.size() + 64) continue;
+
+        auto quando = std::chrono::file_clock::to_sys(entry.last_write_time(ec));
+        Registro r{std::chrono::duration_cast<std::chrono::nanoseconds>(quando.time_since_epoch()).count(),
+                   static_cast<uint64_t>(entry.file_size(ec)), 0, {}, 0, 0};
+        hex_para_bytes(arquivo.substr(base.size()), r.hash);
+        int fd = ::open(entry.path().c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            struct stat st {};
+            unsigned char cabecalho[8];
+            ssize_t lidos = ::pread(fd, cabecalho, sizeof(cabecalho), 0);
+            if (::fstat(fd, &st) == 0 && !cabecalho_cifrado(cabecalho, lidos > 0 ? lidos : 0))
+                r.modo = st.st_mode & 07777;
+            ::close(fd);
+        }
+        registros.push_back(r);
+    }
+    if (registros.empty()) return;
+    std::sort(registros.begin(), registros.end(),
+              [](const Registro &a, const Registro &b) { return a.captura_ns < b.captura_ns; });
+    try {
+        gravar_indice(arquivo_indice(nome), registros);
+    } catch (const std::exception &) {
+        throw std::runtime_error("erro reconstruindo índice de " + nome);
+    }
+}
+
+size_t IndiceVersoes::total(const std::string &nome) {
+    fs::path arquivo = arquivo_indice(nome);
+    if (!fs::exists(arquivo)) reconstruir(nome);
+
+    int fd = abrir_indice(arquivo, O_RDONLY);
+    if (fd < 0) return 0;
+    size_t n = contar(fd, tamanho_registro(fd));
+    ::close(fd);
+    return n;
+}
+
+std::vector<IndiceVersoes::Entrada> IndiceVersoes::ler(const std::string &nome, size_t inicio, size_t quantidade) {
+    std::vector<Entrada> saida;
+    int fd = abrir_indice(arquivo_indice(nome), O_RDONLY);
+    if (fd < 0) return saida;
+
+    uint32_t tamanho = tamanho_registro(fd);
+    size_t n = contar(fd, tamanho);
+    if (inicio < n) {
+        for (auto &r : ler_registros(fd, tamanho, inicio, std::min(quantidade, n - inicio)))
+            saida.push_back(para_entrada(r));
+    }
+    ::close(fd);
+    return saida;
+}
+
+bool IndiceVersoes::buscar(const std::string &nome, const std::string &hash, Entrada &saida) {
+    int fd = abrir_indice(arquivo_indice(nome), O_RDONLY);
+    if (fd < 0) return false;
+
+    uint8_t alvo[32];
+    hex_para_bytes(hash, alvo);
+    uint32_t tamanho = tamanho_registro(fd);
+    size_t n = contar(fd, tamanho);
+    bool achou = false;
+    for (size_t inicio = 0; inicio < n; inicio += 4096) {
+        for (auto &r : ler_registros(fd, tamanho, inicio, std::min<size_t>(4096, n - inicio))) {
+            if (std::memcmp(r.hash, alvo, 32) == 0) {
+                saida = para_entrada(r);
+                achou = true; // continua até o fim: vale a captura mais recente
+            }
+        }
+    }
+    ::close(fd);
+    return achou;
+}
@@ -0,0 +1,575 @@
+#include "integridade.h"
+#include "store.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CRC32C_SSE42 1
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char MAGICA[8] = {'M', 'O', 'N', 'C', 'R', 'C', '0', '1'};
+constexpr size_t TAMANHO_CABECALHO = 32;
+
+// tabela do polinômio refletido 0x82F63B78, para processadores sem SSE4.2
+struct TabelaCrc {
+    uint32_t valores[256];
+    TabelaCrc() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c >> 1) ^ (0x82F63B78u & (0u - (c & 1)));
+            valores[i] = c;
+        }
+    }
+};
+
+uint32_t crc32c_tabela(uint32_t crc, const unsigned char *p, size_t n) {
+    static const TabelaCrc tabela;
+    while (n--) crc = tabela.valores[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+#ifdef CRC32C_SSE42
+__attribute__((target("sse4.2"))) uint32_t crc32c_sse42(uint32_t crc, const unsigned char *p, size_t n) {
+    uint64_t c = crc;
+    for (; n >= 8; n -= 8, p += 8) {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        c = _mm_crc32_u64(c, v);
+    }
+    uint32_t c32 = static_cast<uint32_t>(c);
+    while (n--) c32 = _mm_crc32_u8(c32, *p++);
+    return c32;
+}
+#endif
+
+void escrever_u32(unsigned char *p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+void escrever_u64(unsigned char *p, uint64_t v) {
+    for (int i = 0; i < 8; ++i) p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+
+uint32_t ler_u32(const unsigned char *p) {
+    uint32_t v = 0;
+    for (int i = 3; i >= 0; --i) v = v << 8 | p[i];
+    return v;
+}
+
+uint64_t ler_u64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; --i) v = v << 8 | p[i];
+    return v;
+}
+
+int64_t mtime_ns(const struct stat &st) {
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+}
+
+// lê até n bytes em `pos`; menos só no fim do arquivo
+size_t ler_em(int fd, void *destino, size_t n, uint64_t pos) {
+    size_t total = 0;
+    while (total < n) {
+        ssize_t r = ::pread(fd, static_cast<char *>(destino) + total, n - total, static_cast<off_t>(pos + total));
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) throw std::runtime_error(std::string("erro lendo: ") + std::strerror(errno));
+        if (r == 0) break;
+        total += static_cast<size_t>(r);
+    }
+    return total;
+}
+
+void escrever_em(int fd, const void *dados, size_t n, uint64_t pos) {
+    size_t total = 0;
+    while (total < n) {
+        ssize_t r = ::pwrite(fd, static_cast<const char *>(dados) + total, n - total, static_cast<off_t>(pos + total));
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) throw std::runtime_error(std::string("erro gravando: ") + std::strerror(errno));
+        total += static_cast<size_t>(r);
+    }
+}
+
+void xor_bloco(unsigned char *acumulado, const unsigned char *bloco, size_t n) {
+    for (size_t i = 0; i < n; ++i) acumulado[i] ^= bloco[i];
+}
+
+// store que contém a versão: o primeiro ancestral com .monitor/formato
+fs::path store_da_versao(const fs::path &versao) {
+    std::error_code ec;
+    for (fs::path p = versao.parent_path(); !p.empty(); p = p.parent_path()) {
+        if (fs::exists(p / ".monitor" / "formato", ec)) return p;
+        if (p == p.parent_path()) break;
+    }
+    return {};
+}
+
+struct Somas {
+    uint32_t bloco = 0;
+    uint32_t grupo = 0;
+    uint64_t tamanho = 0;
+    int64_t mtime_ns = 0;
+    std::vector<uint32_t> crcs;
+    uint64_t inicio_paridade = 0;
+
+    size_t blocos() const { return crcs.size(); }
+    uint64_t deslocamento_paridade(size_t grupo_indice) const {
+        return inicio_paridade + static_cast<uint64_t>(grupo_indice) * bloco;
+    }
+};
+
+size_t total_blocos(uint64_t tamanho) {
+    return static_cast<size_t>((tamanho + TAMANHO_BLOCO_INTEGRIDADE - 1) / TAMANHO_BLOCO_INTEGRIDADE);
+}
+
+// false se o arquivo de somas não existir ou não for legível (a versão fica sem conferência)
+bool ler_somas(int fd, Somas &s) {
+    unsigned char cabecalho[TAMANHO_CABECALHO];
+    if (ler_em(fd, cabecalho, sizeof(cabecalho), 0) != sizeof(cabecalho) ||
+        std::memcmp(cabecalho, MAGICA, sizeof(MAGICA)) != 0)
+        return false;
+    s.bloco = ler_u32(cabecalho + 8);
+    s.grupo = ler_u32(cabecalho + 12);
+    s.tamanho = ler_u64(cabecalho + 16);
+    s.mtime_ns = static_cast<int64_t>(ler_u64(cabecalho + 24));
+    if (s.bloco != TAMANHO_BLOCO_INTEGRIDADE) return false;
+
+    size_t n = total_blocos(s.tamanho);
+    std::vector<unsigned char> tabela(n * 4 + 4);
+    if (ler_em(fd, tabela.data(), tabela.size(), TAMANHO_CABECALHO) != tabela.size()) return false;
+    uint32_t esperado = ler_u32(tabela.data() + n * 4);
+    uint32_t crc = crc32c(crc32c(0, cabecalho, sizeof(cabecalho)), tabela.data(), n * 4);
+    if (crc != esperado) return false;
+
+    s.crcs.resize(n);
+    for (size_t i = 0; i < n; ++i) s.crcs[i] = ler_u32(tabela.data() + i * 4);
+    s.inicio_paridade = TAMANHO_CABECALHO + tabela.size();
+    return true;
+}
+
+// reconstrói o bloco `indice` a partir da paridade e dos outros blocos do grupo
+bool reconstruir(int fd_versao, int fd_somas, const Somas &s, size_t indice, std::vector<unsigned char> &saida) {
+    size_t grupo = indice / s.grupo;
+    std::vector<unsigned char> bloco(s.bloco);
+    saida.assign(s.bloco, 0);
+    if (ler_em(fd_somas, saida.data(), s.bloco, s.deslocamento_paridade(grupo)) != s.bloco) return false;
+
+    size_t primeiro = grupo * s.grupo, ultimo = std::min(primeiro + s.grupo, s.blocos());
+    for (size_t i = primeiro; i < ultimo; ++i) {
+        if (i == indice) continue;
+        std::fill(bloco.begin(), bloco.end(), 0);
+        ler_em(fd_versao, bloco.data(), s.bloco, static_cast<uint64_t>(i) * s.bloco);
+        xor_bloco(saida.data(), bloco.data(), s.bloco);
+    }
+    size_t tamanho = std::min<uint64_t>(s.bloco, s.tamanho - static_cast<uint64_t>(indice) * s.bloco);
+    saida.resize(tamanho);
+    return crc32c(0, saida.data(), saida.size()) == s.crcs[indice];
+}
+
+// regrava os blocos reparados preservando permissões e mtime (que identificam as somas)
+void regravar(const fs::path &versao, const struct stat &st,
+              const std::vector<std::pair<size_t, std::vector<unsigned char>>> &reparos) {
+    bool liberou = false;
+    int fd = ::open(versao.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0 && errno == EACCES && ::chmod(versao.c_str(), (st.st_mode & 07777) | S_IWUSR) == 0) {
+        liberou = true;
+        fd = ::open(versao.c_str(), O_WRONLY | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        int erro = errno;
+        if (liberou) ::chmod(versao.c_str(), st.st_mode & 07777);
+        throw std::runtime_error("não foi possível reparar " + versao.string() + ": " + std::strerror(erro));
+    }
+    try {
+        for (auto &[indice, dados] : reparos)
+            escrever_em(fd, dados.data(), dados.size(), static_cast<uint64_t>(indice) * TAMANHO_BLOCO_INTEGRIDADE);
+        ::fdatasync(fd);
+    } catch (...) {
+        ::close(fd);
+        if (liberou) ::chmod(versao.c_str(), st.st_mode & 07777);
+        throw;
+    }
+    timespec tempos[2] = {st.st_atim, st.st_mtim};
+    ::futimens(fd, tempos);
+    ::close(fd);
+    if (liberou) ::chmod(versao.c_str(), st.st_mode & 07777);
+}
+
+size_t tamanho_do_bloco(const Somas &s, size_t indice) {
+    return static_cast<size_t>(std::min<uint64_t>(s.bloco, s.tamanho - static_cast<uint64_t>(indice) * s.bloco));
+}
+
+// "início-fim" em bytes do bloco `indice`, para as mensagens de erro
+std::string faixa_do_bloco(const Somas &s, size_t indice) {
+    uint64_t inicio = static_cast<uint64_t>(indice) * s.bloco;
+    return std::to_string(inicio) + "-" + std::to_string(inicio + tamanho_do_bloco(s, indice) - 1);
+}
+
+std::runtime_error erro_de_tamanho(const fs::path &versao, uint64_t tamanho, uint64_t registrado) {
+    return std::runtime_error(versao.string() + ": tamanho " + std::to_string(tamanho) +
+                              " diferente do registrado nas somas (" + std::to_string(registrado) + ")");
+}
+
+} // namespace
+
+uint32_t crc32c(uint32_t crc, const void *dados, size_t n) {
+    auto *p = static_cast<const unsigned char *>(dados);
+#ifdef CRC32C_SSE42
+    static const bool sse42 = __builtin_cpu_supports("sse4.2");
+    if (sse42) return ~crc32c_sse42(~crc, p, n);
+#endif
+    return ~crc32c_tabela(~crc, p, n);
+}
+
+uint32_t grupo_paridade_configurado() {
+    static const uint32_t grupo = [] {
+        const char *v = std::getenv("MONITOR_PARIDADE");
+        return v ? static_cast<uint32_t>(std::strtoul(v, nullptr, 10)) : 0u;
+    }();
+    return grupo;
+}
+
+fs::path arquivo_integridade(const fs::path &backup_dir, const std::string &relativo) {
+    return backup_dir / ".monitor" / "integridade" / (relativo + ".crc");
+}
+
+SomasEmFluxo::SomasEmFluxo(fs::path temporario, uint32_t grupo, uint64_t tamanho_previsto)
+    : temporario(std::move(temporario)), grupo(grupo), blocos_previstos(total_blocos(tamanho_previsto)),
+      paridade(grupo ? TAMANHO_BLOCO_INTEGRIDADE : 0) {}
+
+SomasEmFluxo::~SomasEmFluxo() {
+    if (fd < 0) return;
+    ::close(fd);
+    ::unlink(temporario.c_str());
+}
+
+void SomasEmFluxo::abrir() {
+    if (fd >= 0) return;
+    std::error_code ec;
+    fs::create_directories(temporario.parent_path(), ec);
+    fd = ::open(temporario.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) throw std::runtime_error("não foi possível criar " + temporario.string() + ": " + std::strerror(errno));
+}
+
+void SomasEmFluxo::atualizar(const void *dados, size_t n) {
+    auto *p = static_cast<const unsigned char *>(dados);
+    total += n;
+    while (n > 0) {
+        size_t parte = std::min<size_t>(n, TAMANHO_BLOCO_INTEGRIDADE - no_bloco);
+        crc_atual = crc32c(crc_atual, p, parte);
+        if (grupo) xor_bloco(paridade.data() + no_bloco, p, parte);
+        no_bloco += parte;
+        p += parte;
+        n -= parte;
+        if (no_bloco == TAMANHO_BLOCO_INTEGRIDADE) fechar_bloco();
+    }
+}
+
+void SomasEmFluxo::fechar_bloco() {
+    crcs.push_back(crc_atual);
+    crc_atual = 0;
+    no_bloco = 0;
+    if (grupo && crcs.size() % grupo == 0) gravar_paridade(crcs.size() / grupo - 1);
+}
+
+// chamada no meio da cópia, que não espera exceções: a falha fica para concluir()
+void SomasEmFluxo::gravar_paridade(size_t indice_grupo) {
+    try {
+        if (erro == 0) {
+            abrir();
+            uint64_t inicio = TAMANHO_CABECALHO + blocos_previstos * 4 + 4;
+            escrever_em(fd, paridade.data(), paridade.size(), inicio + indice_grupo * TAMANHO_BLOCO_INTEGRIDADE);
+        }
+    } catch (const std::exception &) {
+        erro = errno ? errno : EIO;
+    }
+    std::fill(paridade.begin(), paridade.end(), 0);
+}
+
+void SomasEmFluxo::concluir(const fs::path &versao, const fs::path &somas) {
+    if (no_bloco > 0) fechar_bloco();
+    size_t n = crcs.size();
+    if (grupo && n % grupo != 0) gravar_paridade(n / grupo);
+    if (erro) throw std::runtime_error("erro gravando a paridade de " + versao.string() + ": " + std::strerror(erro));
+    struct stat st {};
+    if (::stat(versao.c_str(), &st) != 0)
+        throw std::runtime_error("não foi possível ler " + versao.string() + ": " + std::strerror(errno));
+    if (static_cast<uint64_t>(st.st_size) != total)
+        throw std::runtime_error(versao.string() + " não tem os bytes de que as somas foram calculadas");
+    abrir();
+
+    // a paridade foi posicionada pelo tamanho previsto; com outro número de blocos a
+    // tabela muda de tamanho e os grupos andam juntos (do fim, se for para a frente)
+    size_t grupos = grupo ? (n + grupo - 1) / grupo : 0;
+    uint64_t de = TAMANHO_CABECALHO + blocos_previstos * 4 + 4, para = TAMANHO_CABECALHO + n * 4 + 4;
+    if (grupos > 0 && de != para) {
+        std::vector<unsigned char> buffer(TAMANHO_BLOCO_INTEGRIDADE);
+        for (size_t k = 0; k < grupos; ++k) {
+            size_t g = para > de ? grupos - 1 - k : k;
+            if (ler_em(fd, buffer.data(), buffer.size(), de + g * buffer.size()) != buffer.size())
+                throw std::runtime_error("paridade incompleta em " + temporario.string());
+            escrever_em(fd, buffer.data(), buffer.size(), para + g * buffer.size());
+        }
+    }
+    if (::ftruncate(fd, static_cast<off_t>(para + grupos * TAMANHO_BLOCO_INTEGRIDADE)) != 0)
+        throw std::runtime_error("erro gravando " + temporario.string() + ": " + std::strerror(errno));
+
+    unsigned char cabecalho[TAMANHO_CABECALHO] = {};
+    std::memcpy(cabecalho, MAGICA, sizeof(MAGICA));
+    escrever_u32(cabecalho + 8, TAMANHO_BLOCO_INTEGRIDADE);
+    escrever_u32(cabecalho + 12, grupo);
+    escrever_u64(cabecalho + 16, total);
+    escrever_u64(cabecalho + 24, static_cast<uint64_t>(mtime_ns(st)));
+    std::vector<unsigned char> tabela(n * 4 + 4);
+    for (size_t i = 0; i < n; ++i) escrever_u32(tabela.data() + i * 4, crcs[i]);
+    escrever_u32(tabela.data() + n * 4, crc32c(crc32c(0, cabecalho, sizeof(cabecalho)), tabela.data(), n * 4));
+    escrever_em(fd, cabecalho, sizeof(cabecalho), 0);
+    escrever_em(fd, tabela.data(), tabela.size(), TAMANHO_CABECALHO);
+
+    fs::create_directories(somas.parent_path());
+    ::close(fd);
+    fd = -1;
+    if (::rename(temporario.c_str(), somas.c_str()) != 0) {
+        int e = errno;
+        ::unlink(temporario.c_str());
+        throw std::runtime_error("não foi possível gravar " + somas.string() + ": " + std::strerror(e));
+    }
+}
+
+void gravar_integridade(const fs::path &conteudo, const fs::path &somas, uint32_t grupo) {
+    int in = ::open(conteudo.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) throw std::runtime_error("não foi possível abrir " + conteudo.string() + ": " + std::strerror(errno));
+    struct stat antes {}, depois {};
+    ::fstat(in, &antes);
+    fs::path temporario = somas;
+    temporario += ".novo";
+    SomasEmFluxo fluxo(temporario, grupo, static_cast<uint64_t>(antes.st_size));
+    try {
+        std::vector<unsigned char> buffer(16 * TAMANHO_BLOCO_INTEGRIDADE);
+        ::posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+        for (uint64_t pos = 0;;) {
+            size_t n = ler_em(in, buffer.data(), buffer.size(), pos);
+            if (n == 0) break;
+            fluxo.atualizar(buffer.data(), n);
+            pos += n;
+        }
+        ::fstat(in, &depois);
+    } catch (...) {
+        ::close(in);
+        throw;
+    }
+    ::close(in);
+    if (depois.st_size != antes.st_size || mtime_ns(depois) != mtime_ns(antes))
+        throw std::runtime_error(conteudo.string() + " mudou durante o cálculo das somas");
+    fluxo.concluir(conteudo, somas);
+}
+
+void conferir_tamanho(const fs::path &versao) {
+    fs::path store = store_da_versao(versao);
+    if (store.empty()) return;
+    fs::path somas = arquivo_integridade(store, versao.lexically_relative(store).generic_string());
+    int fd_somas = ::open(somas.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_somas < 0) return;
+    unsigned char cabecalho[TAMANHO_CABECALHO];
+    size_t lidos = 0;
+    try {
+        lidos = ler_em(fd_somas, cabecalho, sizeof(cabecalho), 0);
+    } catch (const std::exception &) {
+    }
+    ::close(fd_somas);
+    struct stat st {};
+    if (lidos != sizeof(cabecalho) || std::memcmp(cabecalho, MAGICA, sizeof(MAGICA)) != 0 ||
+        ::stat(versao.c_str(), &st) != 0 || static_cast<int64_t>(ler_u64(cabecalho + 24)) != mtime_ns(st))
+        return;
+    uint64_t tamanho = ler_u64(cabecalho + 16);
+    if (static_cast<uint64_t>(st.st_size) != tamanho) throw erro_de_tamanho(versao, st.st_size, tamanho);
+}
+
+VerificacaoVersao conferir_versao(const fs::path &versao, bool reparar) {
+    VerificacaoVersao r;
+    fs::path store = store_da_versao(versao);
+    if (store.empty()) return r;
+    fs::path somas = arquivo_integridade(store, versao.lexically_relative(store).generic_string());
+
+    int fd_somas = ::open(somas.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_somas < 0) return r;
+    int fd = ::open(versao.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        ::close(fd_somas);
+        return r; // quem lê a versão reporta o erro de abertura
+    }
+
+    std::vector<std::pair<size_t, std::vector<unsigned char>>> reparos;
+    struct stat st {};
+    try {
+        Somas s;
+        ::fstat(fd, &st);
+        if (!ler_somas(fd_somas, s) || s.mtime_ns != mtime_ns(st)) {
+            ::close(fd);
+            ::close(fd_somas);
+            return r; // somas de outro arquivo: a versão fica sem conferência
+        }
+        r.com_somas = true;
+        r.blocos = s.blocos();
+        if (static_cast<uint64_t>(st.st_size) != s.tamanho) throw erro_de_tamanho(versao, st.st_size, s.tamanho);
+
+        // uma passada sequencial; a leitura que vem depois encontra a versão no cache
+        std::vector<size_t> ruins;
+        std::vector<unsigned char> buffer(16 * static_cast<size_t>(s.bloco));
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        for (size_t i = 0; i < s.blocos(); i += 16) {
+            size_t lidos = ler_em(fd, buffer.data(), buffer.size(), static_cast<uint64_t>(i) * s.bloco);
+            for (size_t k = 0; k < 16 && i + k < s.blocos(); ++k) {
+                size_t inicio = k * s.bloco;
+                size_t n = std::min<size_t>(s.bloco, lidos > inicio ? lidos - inicio : 0);
+                if (crc32c(0, buffer.data() + inicio, n) != s.crcs[i + k]) ruins.push_back(i + k);
+            }
+        }
+
+        std::string irreparaveis;
+        for (size_t j = 0; j < ruins.size(); ++j) {
+            size_t i = ruins[j];
+            bool sozinho = s.grupo > 0 && (j == 0 || ruins[j - 1] / s.grupo != i / s.grupo) &&
+                           (j + 1 == ruins.size() || ruins[j + 1] / s.grupo != i / s.grupo);
+            std::vector<unsigned char> dados;
+            if (sozinho && reconstruir(fd, fd_somas, s, i, dados)) {
+                reparos.emplace_back(i, std::move(dados));
+                continue;
+            }
+            irreparaveis += (irreparaveis.empty() ? "" : ", ") + faixa_do_bloco(s, i);
+        }
+        if (!irreparaveis.empty())
+            throw std::runtime_error(versao.string() + ": conteúdo corrompido sem reparo nos bytes " + irreparaveis);
+        if (!reparos.empty() && !reparar)
+            throw std::runtime_error(versao.string() + ": " + std::to_string(reparos.size()) +
+                                     (reparos.size() == 1 ? " bloco corrompido" : " blocos corrompidos") +
+                                     ", reparável pela paridade com --verify");
+    } catch (...) {
+        ::close(fd);
+        ::close(fd_somas);
+        throw;
+    }
+    ::close(fd);
+    ::close(fd_somas);
+
+    if (!reparos.empty()) {
+        regravar(versao, st, reparos);
+        r.reparados = reparos.size();
+        std::cerr << "🩹 " << r.reparados << (r.reparados == 1 ? " bloco reparado" : " blocos reparados")
+                  << " pela paridade em " << versao << std::endl;
+    }
+    return r;
+}
+
+struct LeitorConferido::Estado {
+    Somas somas;
+    int fd = -1;
+
+    ~Estado() {
+        if (fd >= 0) ::close(fd);
+    }
+};
+
+LeitorConferido::LeitorConferido(int fd, const fs::path &versao) : fd(fd), versao(versao) {
+    fs::path store = store_da_versao(versao);
+    if (store.empty()) return;
+    auto e = std::make_unique<Estado>();
+    fs::path somas = arquivo_integridade(store, versao.lexically_relative(store).generic_string());
+    e->fd = ::open(somas.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st {};
+    if (e->fd < 0 || ::fstat(fd, &st) != 0 || !ler_somas(e->fd, e->somas) || e->somas.mtime_ns != mtime_ns(st))
+        return; // somas ausentes ou de outro arquivo: a versão é lida sem conferência
+    if (static_cast<uint64_t>(st.st_size) != e->somas.tamanho)
+        throw erro_de_tamanho(versao, st.st_size, e->somas.tamanho);
+    bloco.resize(e->somas.bloco);
+    estado = std::move(e);
+}
+
+LeitorConferido::~LeitorConferido() = default;
+
+void LeitorConferido::ler_trecho(unsigned char *destino, size_t n, uint64_t pos) {
+    size_t lidos = 0;
+    try {
+        lidos = ler_em(fd, destino, n, pos);
+    } catch (const std::exception &e) {
+        throw std::runtime_error(versao.string() + ": " + e.what());
+    }
+    if (lidos != n) throw std::runtime_error(versao.string() + " encolheu durante a leitura");
+}
+
+// confere o bloco já lido em `dados` e, se não conferir, o substitui pela reconstrução
+void LeitorConferido::conferir_bloco(size_t indice, unsigned char *dados) {
+    const Somas &s = estado->somas;
+    size_t n = tamanho_do_bloco(s, indice);
+    if (crc32c(0, dados, n) == s.crcs[indice]) return;
+    std::vector<unsigned char> reconstruido;
+    if (s.grupo == 0 || !reconstruir(fd, estado->fd, s, indice, reconstruido))
+        throw std::runtime_error(versao.string() + ": conteúdo corrompido sem reparo nos bytes " +
+                                 faixa_do_bloco(s, indice));
+    std::memcpy(dados, reconstruido.data(), n);
+    ++total_reconstruidos;
+    std::cerr << "🩹 bytes " << faixa_do_bloco(s, indice) << " de " << versao
+              << " reconstruídos pela paridade na leitura (--verify regrava a versão)" << std::endl;
+}
+
+size_t LeitorConferido::ler(void *destino, size_t n, uint64_t pos) {
+    auto *saida = static_cast<unsigned char *>(destino);
+    if (!estado) return ler_em(fd, saida, n, pos);
+    const Somas &s = estado->somas;
+    if (pos >= s.tamanho) return 0;
+    n = static_cast<size_t>(std::min<uint64_t>(n, s.tamanho - pos));
+
+    for (size_t feito = 0; feito < n;) {
+        uint64_t atual = pos + feito;
+        size_t indice = static_cast<size_t>(atual / s.bloco), dentro = static_cast<size_t>(atual % s.bloco);
+        // blocos inteiros vão direto para o destino e são conferidos lá
+        size_t inteiros = n - feito == s.tamanho - atual ? n - feito : (n - feito) / s.bloco * s.bloco;
+        if (dentro == 0 && inteiros > 0 && indice != bloco_carregado) {
+            ler_trecho(saida + feito, inteiros, atual);
+            for (size_t k = 0; k * s.bloco < inteiros; ++k) conferir_bloco(indice + k, saida + feito + k * s.bloco);
+            feito += inteiros;
+            continue;
+        }
+        // pedaço de bloco: o bloco inteiro é lido e conferido uma vez, e os pedidos
+        // seguintes dentro dele saem do buffer
+        if (indice != bloco_carregado) {
+            bloco_carregado = SIZE_MAX;
+            ler_trecho(bloco.data(), tamanho_do_bloco(s, indice), static_cast<uint64_t>(indice) * s.bloco);
+            conferir_bloco(indice, bloco.data());
+            bloco_carregado = indice;
+        }
+        size_t parte = std::min(tamanho_do_bloco(s, indice) - dentro, n - feito);
+        std::memcpy(saida + feito, bloco.data() + dentro, parte);
+        feito += parte;
+    }
+    return n;
+}
+
+ResultadoConferencia conferir_store(const fs::path &backup_dir) {
+    ResultadoConferencia r;
+    percorrer_versoes(backup_dir, [&](const std::string &relativo) {
+        try {
+            VerificacaoVersao v = conferir_versao(backup_dir / relativo, true);
+            if (!v.com_somas) ++r.sem_somas;
+            else ++r.conferidas;
+            if (v.reparados) ++r.reparadas;
+        } catch (const std::exception &e) {
+            ++r.corrompidas;
+            std::cerr << "❌ " << e.what() << std::endl;
+        }
+    });
+    return r;
+}
@@ -0,0 +1,242 @@
+#include "journal.h"
+#include "store.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+int abrir_ou_falhar(const fs::path &caminho, int flags, mode_t modo = 0) {
+    int fd = ::open(caminho.c_str(), flags | O_CLOEXEC, modo);
+    if (fd < 0)
+        throw std::runtime_error("não foi possível abrir " + caminho.string() + ": " + std::strerror(errno));
+    return fd;
+}
+
+void sincronizar_caminho(const fs::path &caminho, bool diretorio) {
+    int fd = ::open(caminho.c_str(), (diretorio ? O_RDONLY | O_DIRECTORY : O_RDONLY) | O_CLOEXEC);
+    if (fd < 0) return;
+    if (diretorio) ::fsync(fd);
+    else ::fdatasync(fd);
+    ::close(fd);
+}
+
+std::string octal(uint32_t modo) {
+    char texto[16];
+    std::snprintf(texto, sizeof(texto), "%o", modo);
+    return texto;
+}
+
+// tab, quebra de linha e barra invertida nos caminhos viram \t, \n e \\ no registro
+std::string escapar(const std::string &texto) {
+    std::string saida;
+    saida.reserve(texto.size());
+    for (char c : texto) {
+        if (c == '\\') saida += "\\\\";
+        else if (c == '\t') saida += "\\t";
+        else if (c == '\n') saida += "\\n";
+        else saida += c;
+    }
+    return saida;
+}
+
+// inverso de escapar; false numa sequência inválida (registro de journal corrompido)
+bool desescapar(const std::string &texto, std::string &saida) {
+    saida.clear();
+    for (size_t i = 0; i < texto.size(); ++i) {
+        if (texto[i] != '\\') {
+            saida += texto[i];
+            continue;
+        }
+        if (++i == texto.size()) return false;
+        if (texto[i] == '\\') saida += '\\';
+        else if (texto[i] == 't') saida += '\t';
+        else if (texto[i] == 'n') saida += '\n';
+        else return false;
+    }
+    return true;
+}
+
+// caminho relativo ao store, escapado para o registro
+std::string relativo(const fs::path &caminho, const fs::path &base) {
+    return escapar(fs::relative(caminho, base).generic_string());
+}
+
+} // namespace
+
+JournalVersoes::JournalVersoes(const fs::path &backup_dir, size_t tamanho_grupo)
+    : backup_dir(backup_dir),
+      dir_pendentes(backup_dir / ".monitor" / "pendentes"),
+      caminho_journal(backup_dir / ".monitor" / "journal"),
+      tamanho_grupo(tamanho_grupo == 0 ? 1 : tamanho_grupo),
+      indice(backup_dir) {
+    fs::create_directories(dir_pendentes);
+    fd_backup = abrir_ou_falhar(backup_dir, O_RDONLY | O_DIRECTORY);
+    fd_journal = abrir_ou_falhar(caminho_journal, O_RDWR | O_CREAT | O_APPEND, 0644);
+}
+
+JournalVersoes::~JournalVersoes() {
+    try {
+        confirmar();
+    } catch (const std::exception &e) {
+        std::cerr << "Erro confirmando versões pendentes: " << e.what() << std::endl;
+    }
+    if (fd_journal >= 0) ::close(fd_journal);
+    if (fd_backup >= 0) ::close(fd_backup);
+}
+
+void JournalVersoes::escrever(const std::string &registro) {
+    const char *p = registro.data();
+    size_t restante = registro.size();
+    while (restante > 0) {
+        ssize_t n = ::write(fd_journal, p, restante);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("erro escrevendo journal: ") + std::strerror(errno));
+        }
+        p += n;
+        restante -= n;
+    }
+}
+
+// um syncfs cobre todo o grupo; se não estiver disponível, fdatasync arquivo a arquivo
+void JournalVersoes::sincronizar(const std::vector<Entrada> &entradas, bool diretorios) {
+    if (::syncfs(fd_backup) == 0) return;
+
+    std::set<fs::path> pastas;
+    for (auto &e : entradas) {
+        if (diretorios) {
+            pastas.insert(e.destino.parent_path());
+        } else {
+            sincronizar_caminho(e.pendente, false);
+        }
+    }
+    if (diretorios) {
+        pastas.insert(dir_pendentes);
+        for (auto &p : pastas) sincronizar_caminho(p, true);
+    }
+    ::fdatasync(fd_journal);
+}
+
+void JournalVersoes::publicar(const std::vector<Entrada> &entradas) {
+    for (auto &e : entradas) {
+        std::error_code ec;
+        if (!e.pendente.empty() && fs::exists(e.pendente, ec)) {
+            fs::create_directories(e.destino.parent_path(), ec);
+            fs::rename(e.pendente, e.destino, ec);
+            if (ec) {
+                std::cerr << "Erro publicando versão " << e.destino << ": " << ec.message() << std::endl;
+                continue;
+            }
+        } else if (!fs::exists(e.destino, ec)) {
+            continue;
+        }
+
+        // no replay da recuperação o registro pode já existir; o índice ignora a repetição
+        std::string nome, hash;
+        if (separar_versao(fs::relative(e.destino, backup_dir).generic_string(), nome, hash)) {
+            try {
+                indice.adicionar(nome, hash, e.meta);
+            } catch (const std::exception &erro) {
+                std::cerr << "Erro atualizando índice: " << erro.what() << std::endl;
+            }
+        }
+    }
+}
+
+void JournalVersoes::recuperar() {
+    std::vector<Entrada> confirmadas, abertas;
+    {
+        std::ifstream in(caminho_journal);
+        std::string linha;
+        while (std::getline(in, linha)) {
+            if (linha == "C") {
+                confirmadas.insert(confirmadas.end(), abertas.begin(), abertas.end());
+                abertas.clear();
+            } else if (linha.size() > 2 && linha[0] == 'P') {
+                // P <pendente>\t<destino>\t<captura>\t<tamanho>\t<mtime origem>\t<modo>; pendente
+                // vazio numa captura de conteúdo que já estava no store; sem modo em journals antigos
+                std::vector<std::string> campos;
+                size_t inicio = 2;
+                while (true) {
+                    size_t tab = linha.find('\t', inicio);
+                    campos.push_back(linha.substr(inicio, tab - inicio));
+                    if (tab == std::string::npos) break;
+                    inicio = tab + 1;
+                }
+                if (campos.size() != 5 && campos.size() != 6) continue;
+                std::string nome_pendente, nome_destino;
+                if (!desescapar(campos[0], nome_pendente) || !desescapar(campos[1], nome_destino)) continue;
+                try {
+                    MetadadosVersao meta{std::stoll(campos[2]), std::stoull(campos[3]), std::stoll(campos[4]),
+                                         campos.size() == 6 ? static_cast<uint32_t>(std::stoul(campos[5], nullptr, 8)) : 0};
+                    fs::path pendente = nome_pendente.empty() ? fs::path() : backup_dir / nome_pendente;
+                    abertas.push_back({pendente, backup_dir / nome_destino, meta});
+                } catch (const std::exception &) {
+                    // registro cortado no meio por uma queda: a versão não tem commit
+                }
+            }
+        }
+    }
+
+    // versões com commit gravado já estão duráveis: só falta o rename
+    publicar(confirmadas);
+
+    // o resto (sem commit ou sem registro no journal) pode estar incompleto
+    std::error_code ec;
+    for (auto &entry : fs::directory_iterator(dir_pendentes, ec)) fs::remove(entry.path(), ec);
+
+    sincronizar(confirmadas, true);
+    if (::ftruncate(fd_journal, 0) != 0)
+        throw std::runtime_error(std::string("erro truncando journal: ") + std::strerror(errno));
+    ::fdatasync(fd_journal);
+
+    if (!confirmadas.empty() || !abertas.empty()) {
+        std::cout << "🩹 Journal recuperado: " << confirmadas.size() << " versões publicadas, "
+                  << abertas.size() << " descartadas" << std::endl;
+    }
+}
+
+fs::path JournalVersoes::proximo_pendente() {
+    return dir_pendentes / std::to_string(sequencia++);
+}
+
+void JournalVersoes::adicionar(const fs::path &pendente, const fs::path &destino, const MetadadosVersao &meta) {
+    escrever("P " + relativo(pendente, backup_dir) + "\t" + relativo(destino, backup_dir) + "\t" +
+             std::to_string(meta.captura_ns) + "\t" + std::to_string(meta.tamanho) + "\t" +
+             std::to_string(meta.mtime_origem_ns) + "\t" + octal(meta.modo) + "\n");
+    grupo.push_back({pendente, destino, meta});
+    if (grupo.size() >= tamanho_grupo) confirmar();
+}
+
+void JournalVersoes::registrar_existente(const fs::path &destino, const MetadadosVersao &meta) {
+    escrever("P \t" + relativo(destino, backup_dir) + "\t" + std::to_string(meta.captura_ns) + "\t" +
+             std::to_string(meta.tamanho) + "\t" + std::to_string(meta.mtime_origem_ns) + "\t" + octal(meta.modo) +
+             "\n");
+    grupo.push_back({fs::path(), destino, meta});
+    if (grupo.size() >= tamanho_grupo) confirmar();
+}
+
+void JournalVersoes::confirmar() {
+    if (grupo.empty()) return;
+
+    // 1) dados + registros P duráveis  2) commit durável  3) renames  4) renames duráveis
+    sincronizar(grupo, false);
+    escrever("C\n");
+    ::fdatasync(fd_journal);
+    publicar(grupo);
+    sincronizar(grupo, true);
+
+    if (::ftruncate(fd_journal, 0) != 0)
+        throw std::runtime_error(std::string("erro truncando journal: ") + std::strerror(errno));
+    grupo.clear();
+}
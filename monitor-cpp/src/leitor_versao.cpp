@@ -0,0 +1,52 @@
+#include "leitor_versao.h"
+#include "cripto.h"
+#include "integridade.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+LeitorVersao::LeitorVersao(const std::filesystem::path &arquivo) {
+    fd = ::open(arquivo.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("não foi possível abrir " + arquivo.string() + ": " + std::strerror(errno));
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    try {
+        conferido = std::make_unique<LeitorConferido>(fd, arquivo);
+        // o cabeçalho também vem conferido: o bloco fica no buffer para a primeira leitura
+        unsigned char inicio[TAMANHO_CABECALHO_CRIPTO];
+        size_t n = conferido->ler(inicio, sizeof(inicio), 0);
+        if (cabecalho_cifrado(inicio, n)) {
+            const ChaveCripto *chave = chave_configurada();
+            if (!chave)
+                throw std::runtime_error("versão cifrada e nenhuma chave configurada (MONITOR_CHAVE): " +
+                                         arquivo.string());
+            decifrador = std::make_unique<DecifradorVersao>(
+                [this](unsigned char *destino, size_t n) { return ler_store(destino, n); }, *chave);
+        }
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+
+LeitorVersao::~LeitorVersao() {
+    if (fd >= 0) ::close(fd);
+}
+
+bool LeitorVersao::conferida() const {
+    return conferido->com_somas();
+}
+
+size_t LeitorVersao::ler_store(unsigned char *destino, size_t n) {
+    size_t r = conferido->ler(destino, n, posicao);
+    posicao += r;
+    return r;
+}
+
+size_t LeitorVersao::ler(char *destino, size_t n) {
+    if (decifrador) return decifrador->ler(destino, n);
+    return ler_store(reinterpret_cast<unsigned char *>(destino), n);
+}
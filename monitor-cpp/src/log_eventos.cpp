@@ -0,0 +1,324 @@
+#include "log_eventos.h"
+#include "indice.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+static_assert(std::endian::native == std::endian::little, "o formato do log é little-endian");
+
+namespace {
+
+constexpr char MAGICA[8] = {'M', 'O', 'N', 'L', 'O', 'G', '0', '1'};
+constexpr size_t MAX_TEXTO = 65535;
+constexpr auto PERIODO_DRENAGEM = std::chrono::milliseconds(50);
+
+struct Cabecalho {
+    uint32_t tamanho; // cabeçalho + texto
+    uint16_t tipo;
+    uint16_t erro;
+    int64_t instante_ns;
+    uint64_t bytes;
+};
+static_assert(sizeof(Cabecalho) == 24, "cabeçalho de evento deve ter 24 bytes");
+
+// anel de uma thread: ela escreve, só a drenagem lê
+struct Anel {
+    static constexpr uint64_t CAPACIDADE = 1 << 20;
+
+    alignas(64) std::atomic<uint64_t> escrita{0};
+    std::atomic<uint64_t> descartados{0};
+    alignas(64) std::atomic<uint64_t> leitura{0};
+    uint64_t descartados_informados = 0;
+    std::unique_ptr<char[]> dados{new char[CAPACIDADE]};
+
+    void copiar_para(uint64_t posicao, const void *origem, size_t n) {
+        size_t inicio = posicao % CAPACIDADE, primeira = std::min<size_t>(n, CAPACIDADE - inicio);
+        std::memcpy(&dados[inicio], origem, primeira);
+        std::memcpy(&dados[0], static_cast<const char *>(origem) + primeira, n - primeira);
+    }
+
+    void copiar_de(uint64_t posicao, void *destino, size_t n) const {
+        size_t inicio = posicao % CAPACIDADE, primeira = std::min<size_t>(n, CAPACIDADE - inicio);
+        std::memcpy(destino, &dados[inicio], primeira);
+        std::memcpy(static_cast<char *>(destino) + primeira, &dados[0], n - primeira);
+    }
+};
+
+// registros ocupam múltiplos de 8 bytes no anel
+constexpr uint64_t ocupacao(size_t tamanho) {
+    return (tamanho + 7) & ~uint64_t(7);
+}
+
+struct Aneis {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Anel>> todos;
+};
+
+// nunca destruído: threads podem registrar eventos até o fim do processo
+Aneis &aneis() {
+    static Aneis *a = new Aneis;
+    return *a;
+}
+
+Anel &anel_da_thread() {
+    thread_local Anel *anel = [] {
+        Aneis &a = aneis();
+        std::lock_guard<std::mutex> l(a.mutex);
+        a.todos.push_back(std::make_unique<Anel>());
+        return a.todos.back().get();
+    }();
+    return *anel;
+}
+
+std::atomic<LogEventos *> ativo{nullptr};
+
+int64_t agora_ns() {
+    timespec t{};
+    ::clock_gettime(CLOCK_REALTIME, &t);
+    return static_cast<int64_t>(t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+void escrever_tudo(int fd, const char *p, size_t n) {
+    while (n > 0) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w < 0) throw std::runtime_error(std::string("erro escrevendo o log de eventos: ") + std::strerror(errno));
+        p += w;
+        n -= w;
+    }
+}
+
+std::string serializar(const Cabecalho &c, std::string_view texto) {
+    std::string r(reinterpret_cast<const char *>(&c), sizeof(c));
+    r.append(texto);
+    return r;
+}
+
+} // namespace
+
+void registrar_evento(TipoEvento tipo, std::string_view texto, uint64_t bytes, int erro) {
+    texto = texto.substr(0, MAX_TEXTO);
+    Cabecalho c{static_cast<uint32_t>(sizeof(Cabecalho) + texto.size()), static_cast<uint16_t>(tipo),
+                static_cast<uint16_t>(erro), agora_ns(), bytes};
+
+    if (!ativo.load(std::memory_order_acquire)) {
+        Evento e{tipo, erro, c.instante_ns, bytes, std::string(texto)};
+        (tipo == TipoEvento::VERSAO_SALVA || tipo == TipoEvento::VERSAO_MOVIDA ? std::cout : std::cerr) << formatar_evento(e) << std::endl;
+        return;
+    }
+
+    Anel &anel = anel_da_thread();
+    uint64_t escrita = anel.escrita.load(std::memory_order_relaxed);
+    uint64_t leitura = anel.leitura.load(std::memory_order_acquire);
+    if (escrita + ocupacao(c.tamanho) - leitura > Anel::CAPACIDADE) {
+        anel.descartados.store(anel.descartados.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    anel.copiar_para(escrita, &c, sizeof(c));
+    anel.copiar_para(escrita + sizeof(c), texto.data(), texto.size());
+    anel.escrita.store(escrita + ocupacao(c.tamanho), std::memory_order_release);
+}
+
+std::string formatar_evento(const Evento &evento) {
+    char milis[8];
+    std::snprintf(milis, sizeof(milis), ".%03d", static_cast<int>(evento.instante_ns / 1000000 % 1000));
+    std::string linha = formatar_instante(evento.instante_ns) + milis + " ";
+    std::string caminho = "\"" + evento.texto + "\"";
+    switch (evento.tipo) {
+    case TipoEvento::VERSAO_SALVA:
+        return linha + "💾 Nova versão salva: " + caminho + " (" + std::to_string(evento.bytes) + " bytes)";
+    case TipoEvento::ERRO_LEITURA:
+        return linha + "Erro lendo " + caminho + ": " + std::strerror(evento.erro);
+    case TipoEvento::ERRO_COPIA:
+        return linha + "Erro salvando versão: " + caminho + ": " + std::strerror(evento.erro);
+    case TipoEvento::ERRO:
+        return linha + evento.texto;
+    case TipoEvento::DESCARTADOS:
+        return linha + "⚠️ " + std::to_string(evento.bytes) + " eventos descartados (log atrasado)";
+    case TipoEvento::VERSAO_MOVIDA: {
+        size_t sep = evento.texto.find('\n');
+        return linha + "🔀 Arquivo movido, versão ligada: \"" + evento.texto.substr(0, sep) + "\" ← \"" +
+               (sep == std::string::npos ? "" : evento.texto.substr(sep + 1)) + "\" (" +
+               std::to_string(evento.bytes) + " bytes)";
+    }
+    }
+    return linha + "evento desconhecido " + std::to_string(static_cast<unsigned>(evento.tipo));
+}
+
+LogEventos::LogEventos(const fs::path &arquivo, uint64_t tamanho_maximo, unsigned copias)
+    : arquivo(arquivo), tamanho_maximo(tamanho_maximo), copias(std::max(1u, copias)) {
+    abrir();
+    LogEventos *nenhum = nullptr;
+    if (!ativo.compare_exchange_strong(nenhum, this)) {
+        ::close(fd);
+        throw std::runtime_error("já existe um log de eventos ativo");
+    }
+    thread = std::thread([this] {
+        std::unique_lock<std::mutex> l(mutex_espera);
+        while (!encerrar) {
+            cv.wait_for(l, PERIODO_DRENAGEM);
+            l.unlock();
+            try {
+                drenar();
+            } catch (const std::exception &e) {
+                std::cerr << "⚠️ " << e.what() << std::endl;
+            }
+            l.lock();
+        }
+    });
+}
+
+LogEventos::~LogEventos() {
+    ativo.store(nullptr, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> l(mutex_espera);
+        encerrar = true;
+    }
+    cv.notify_all();
+    thread.join();
+    try {
+        drenar();
+    } catch (const std::exception &e) {
+        std::cerr << "⚠️ " << e.what() << std::endl;
+    }
+    ::close(fd);
+}
+
+void LogEventos::abrir() {
+    fs::create_directories(arquivo.parent_path());
+    fd = ::open(arquivo.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) throw std::runtime_error("não foi possível abrir o log de eventos " + arquivo.string());
+    off_t fim = ::lseek(fd, 0, SEEK_END);
+    if (fim == 0) escrever_tudo(fd, MAGICA, sizeof(MAGICA));
+    tamanho = fim > 0 ? static_cast<uint64_t>(fim) : sizeof(MAGICA);
+}
+
+void LogEventos::rotacionar() {
+    ::close(fd);
+    fd = -1;
+    std::error_code ec;
+    auto copia = [&](unsigned n) { return fs::path(arquivo.string() + "." + std::to_string(n)); };
+    fs::remove(copia(copias), ec);
+    for (unsigned n = copias; n > 1; --n) fs::rename(copia(n - 1), copia(n), ec);
+    fs::rename(arquivo, copia(1), ec);
+    abrir();
+}
+
+void LogEventos::drenar() {
+    std::lock_guard<std::mutex> l(mutex);
+    std::vector<Anel *> lista;
+    {
+        Aneis &a = aneis();
+        std::lock_guard<std::mutex> la(a.mutex);
+        for (auto &anel : a.todos) lista.push_back(anel.get());
+    }
+
+    std::vector<std::pair<int64_t, std::string>> registros;
+    uint64_t descartados = 0;
+    for (Anel *anel : lista) {
+        uint64_t leitura = anel->leitura.load(std::memory_order_relaxed);
+        uint64_t escrita = anel->escrita.load(std::memory_order_acquire);
+        while (leitura < escrita) {
+            Cabecalho c;
+            anel->copiar_de(leitura, &c, sizeof(c));
+            std::string registro(c.tamanho, '\0');
+            anel->copiar_de(leitura, registro.data(), c.tamanho);
+            registros.emplace_back(c.instante_ns, std::move(registro));
+            leitura += ocupacao(c.tamanho);
+        }
+        anel->leitura.store(leitura, std::memory_order_release);
+
+        uint64_t total = anel->descartados.load(std::memory_order_relaxed);
+        descartados += total - anel->descartados_informados;
+        anel->descartados_informados = total;
+    }
+    if (descartados > 0) {
+        Cabecalho c{sizeof(Cabecalho), static_cast<uint16_t>(TipoEvento::DESCARTADOS), 0, agora_ns(), descartados};
+        registros.emplace_back(c.instante_ns, serializar(c, {}));
+    }
+    if (registros.empty()) return;
+
+    std::stable_sort(registros.begin(), registros.end(),
+                     [](const auto &a, const auto &b) { return a.first < b.first; });
+    std::string lote;
+    for (auto &r : registros) lote += r.second;
+    if (tamanho > sizeof(MAGICA) && tamanho + lote.size() > tamanho_maximo) rotacionar();
+    escrever_tudo(fd, lote.data(), lote.size());
+    tamanho += lote.size();
+}
+
+LeitorEventos::LeitorEventos(const fs::path &arquivo) : posicao(sizeof(MAGICA)) {
+    fd = ::open(arquivo.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("não foi possível abrir " + arquivo.string());
+    char magica[sizeof(MAGICA)];
+    if (::pread(fd, magica, sizeof(magica), 0) != static_cast<ssize_t>(sizeof(magica)) ||
+        std::memcmp(magica, MAGICA, sizeof(MAGICA)) != 0) {
+        ::close(fd);
+        throw std::runtime_error(arquivo.string() + " não é um log de eventos do monitor");
+    }
+}
+
+LeitorEventos::~LeitorEventos() {
+    ::close(fd);
+}
+
+bool LeitorEventos::proximo(Evento &evento) {
+    auto garantir = [&](size_t n) {
+        while (buffer.size() - consumido < n) {
+            char bloco[1 << 16];
+            ssize_t lidos = ::pread(fd, bloco, sizeof(bloco), static_cast<off_t>(posicao));
+            if (lidos < 0 && errno == EINTR) continue;
+            if (lidos <= 0) return false;
+            if (consumido > 0) {
+                buffer.erase(0, consumido);
+                consumido = 0;
+            }
+            buffer.append(bloco, lidos);
+            posicao += lidos;
+        }
+        return true;
+    };
+
+    if (!garantir(sizeof(Cabecalho))) return false;
+    Cabecalho c;
+    std::memcpy(&c, buffer.data() + consumido, sizeof(c));
+    if (c.tamanho < sizeof(Cabecalho) || c.tamanho > sizeof(Cabecalho) + MAX_TEXTO)
+        throw std::runtime_error("registro corrompido no log de eventos");
+    if (!garantir(c.tamanho)) return false;
+
+    evento.tipo = static_cast<TipoEvento>(c.tipo);
+    evento.erro = c.erro;
+    evento.instante_ns = c.instante_ns;
+    evento.bytes = c.bytes;
+    evento.texto.assign(buffer, consumido + sizeof(Cabecalho), c.tamanho - sizeof(Cabecalho));
+    consumido += c.tamanho;
+    return true;
+}
+
+void ler_eventos(const fs::path &arquivo, const std::function<void(const Evento &)> &visitar) {
+    std::vector<fs::path> partes;
+    for (unsigned n = 1; fs::exists(arquivo.string() + "." + std::to_string(n)); ++n)
+        partes.push_back(arquivo.string() + "." + std::to_string(n));
+    std::reverse(partes.begin(), partes.end());
+    partes.push_back(arquivo);
+
+    Evento evento;
+    for (auto &parte : partes) {
+        if (!fs::exists(parte)) continue;
+        LeitorEventos leitor(parte);
+        while (leitor.proximo(evento)) visitar(evento);
+    }
+}
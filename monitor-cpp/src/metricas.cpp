@@ -0,0 +1,302 @@
+#include "metricas.h"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t TOTAL_CONTADORES = static_cast<size_t>(Contador::TOTAL);
+constexpr size_t TOTAL_HISTOGRAMAS = static_cast<size_t>(Histograma::TOTAL);
+constexpr size_t MAX_LIMITES = 16;
+
+struct DefinicaoContador {
+    const char *nome;
+    const char *ajuda;
+};
+
+// na ordem do enum Contador
+const DefinicaoContador CONTADORES[TOTAL_CONTADORES] = {
+    {"monitor_arquivos_varridos_total", "Arquivos examinados por varreduras e eventos."},
+    {"monitor_varreduras_total", "Varreduras completas de uma raiz."},
+    {"monitor_bytes_hash_total", "Bytes lidos para calcular o SHA-256."},
+    {"monitor_hashes_em_cache_total", "Hashes reaproveitados do atributo user.monitor.sha256."},
+    {"monitor_bytes_copiados_total", "Bytes gravados no store."},
+    {"monitor_versoes_salvas_total", "Versões novas registradas no journal."},
+    {"monitor_erros_leitura_total", "Arquivos que não puderam ser lidos na captura."},
+    {"monitor_erros_copia_total", "Versões que não puderam ser gravadas no store."},
+    {"monitor_fila_transbordamentos_total", "Vezes em que os pendentes de uma raiz passaram do limite e ela foi revarrida."},
+    {"monitor_diretorios_sondados_total", "Diretórios listados pela varredura adaptativa."},
+};
+
+struct DefinicaoHistograma {
+    const char *nome;
+    const char *ajuda;
+    double limites[MAX_LIMITES]; // segundos, crescentes; 0 encerra a lista
+};
+
+// na ordem do enum Histograma
+const DefinicaoHistograma HISTOGRAMAS[TOTAL_HISTOGRAMAS] = {
+    {"monitor_latencia_captura_segundos",
+     "Tempo entre a escrita do arquivo (ou a partida do monitor) e o registro da versão.",
+     {0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 300, 900, 3600}},
+    {"monitor_duracao_varredura_segundos", "Duração de uma varredura completa de uma raiz.",
+     {0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5, 10, 30, 60, 300}},
+};
+
+// um por thread; só a dona escreve
+struct alignas(64) Fragmento {
+    std::atomic<uint64_t> contadores[TOTAL_CONTADORES] = {};
+    struct {
+        std::atomic<uint64_t> baldes[MAX_LIMITES + 1] = {}; // não cumulativos; o último é +Inf
+        std::atomic<uint64_t> soma_ns{0};
+    } histogramas[TOTAL_HISTOGRAMAS];
+};
+
+struct Registro {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Fragmento>> fragmentos;
+};
+
+// nunca destruído: threads podem contar até o fim do processo
+Registro &registro() {
+    static Registro *r = new Registro;
+    return *r;
+}
+
+Fragmento &fragmento() {
+    thread_local Fragmento *f = [] {
+        Registro &r = registro();
+        std::lock_guard<std::mutex> l(r.mutex);
+        r.fragmentos.push_back(std::make_unique<Fragmento>());
+        return r.fragmentos.back().get();
+    }();
+    return *f;
+}
+
+// único escritor: dispensa o fetch_add (lock add no x86)
+void somar(std::atomic<uint64_t> &valor, uint64_t n) {
+    valor.store(valor.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+size_t total_limites(const DefinicaoHistograma &h) {
+    size_t n = 0;
+    while (n < MAX_LIMITES && h.limites[n] > 0) ++n;
+    return n;
+}
+
+std::string numero(double v) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", v);
+    return buf;
+}
+
+void escrever_tudo(int fd, const std::string &dados) {
+    const char *p = dados.data();
+    size_t n = dados.size();
+    while (n > 0) {
+        ssize_t w = ::write(fd, p, n);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return;
+        p += w;
+        n -= w;
+    }
+}
+
+} // namespace
+
+void contar(Contador contador, uint64_t n) {
+    somar(fragmento().contadores[static_cast<size_t>(contador)], n);
+}
+
+void observar(Histograma histograma, int64_t ns) {
+    size_t h = static_cast<size_t>(histograma);
+    const DefinicaoHistograma &def = HISTOGRAMAS[h];
+    double segundos = static_cast<double>(std::max<int64_t>(ns, 0)) / 1e9;
+    size_t limites = total_limites(def), balde = 0;
+    while (balde < limites && segundos > def.limites[balde]) ++balde;
+    if (balde == limites) balde = MAX_LIMITES; // além do último limite: +Inf
+
+    auto &destino = fragmento().histogramas[h];
+    somar(destino.baldes[balde], 1);
+    somar(destino.soma_ns, static_cast<uint64_t>(std::max<int64_t>(ns, 0)));
+}
+
+std::string texto_metricas() {
+    uint64_t contadores[TOTAL_CONTADORES] = {};
+    uint64_t baldes[TOTAL_HISTOGRAMAS][MAX_LIMITES + 1] = {};
+    uint64_t somas[TOTAL_HISTOGRAMAS] = {};
+    {
+        Registro &r = registro();
+        std::lock_guard<std::mutex> l(r.mutex);
+        for (auto &f : r.fragmentos) {
+            for (size_t c = 0; c < TOTAL_CONTADORES; ++c) contadores[c] += f->contadores[c].load(std::memory_order_relaxed);
+            for (size_t h = 0; h < TOTAL_HISTOGRAMAS; ++h) {
+                for (size_t b = 0; b <= MAX_LIMITES; ++b)
+                    baldes[h][b] += f->histogramas[h].baldes[b].load(std::memory_order_relaxed);
+                somas[h] += f->histogramas[h].soma_ns.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::string texto;
+    for (size_t c = 0; c < TOTAL_CONTADORES; ++c) {
+        texto += std::string("# HELP ") + CONTADORES[c].nome + " " + CONTADORES[c].ajuda + "\n";
+        texto += std::string("# TYPE ") + CONTADORES[c].nome + " counter\n";
+        texto += std::string(CONTADORES[c].nome) + " " + std::to_string(contadores[c]) + "\n";
+    }
+    for (size_t h = 0; h < TOTAL_HISTOGRAMAS; ++h) {
+        const DefinicaoHistograma &def = HISTOGRAMAS[h];
+        std::string nome = def.nome;
+        texto += "# HELP " + nome + " " + def.ajuda + "\n";
+        texto += "# TYPE " + nome + " histogram\n";
+        uint64_t acumulado = 0;
+        for (size_t b = 0; b < total_limites(def); ++b) {
+            acumulado += baldes[h][b];
+            texto += nome + "_bucket{le=\"" + numero(def.limites[b]) + "\"} " + std::to_string(acumulado) + "\n";
+        }
+        acumulado += baldes[h][MAX_LIMITES];
+        texto += nome + "_bucket{le=\"+Inf\"} " + std::to_string(acumulado) + "\n";
+        texto += nome + "_sum " + numero(static_cast<double>(somas[h]) / 1e9) + "\n";
+        texto += nome + "_count " + std::to_string(acumulado) + "\n";
+    }
+    return texto;
+}
+
+ExportadorMetricas::ExportadorMetricas(const std::string &destino, std::function<void(std::string &)> medidores,
+                                       unsigned intervalo_ms)
+    : intervalo_ms(intervalo_ms), medidores(std::move(medidores)) {
+    bool numerico = !destino.empty() && destino.find_first_not_of("0123456789") == std::string::npos;
+    if (numerico) {
+        unsigned long valor = std::stoul(destino);
+        if (valor > 65535) throw std::runtime_error("porta de métricas inválida: " + destino);
+
+        servidor = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (servidor < 0) throw std::runtime_error("não foi possível criar o socket de métricas");
+        int sim = 1;
+        ::setsockopt(servidor, SOL_SOCKET, SO_REUSEADDR, &sim, sizeof(sim));
+        // só local: as métricas expõem caminhos monitorados
+        sockaddr_in endereco{};
+        endereco.sin_family = AF_INET;
+        endereco.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        endereco.sin_port = htons(static_cast<uint16_t>(valor));
+        socklen_t tamanho = sizeof(endereco);
+        if (::bind(servidor, reinterpret_cast<sockaddr *>(&endereco), sizeof(endereco)) != 0 ||
+            ::listen(servidor, 16) != 0 ||
+            ::getsockname(servidor, reinterpret_cast<sockaddr *>(&endereco), &tamanho) != 0) {
+            ::close(servidor);
+            throw std::runtime_error("não foi possível escutar métricas na porta " + destino);
+        }
+        porta = ntohs(endereco.sin_port);
+    } else {
+        arquivo = destino;
+    }
+
+    if (::pipe2(acordar, O_CLOEXEC) != 0) {
+        if (servidor >= 0) ::close(servidor);
+        throw std::runtime_error("não foi possível criar o pipe do exportador de métricas");
+    }
+    thread = std::thread([this] {
+        if (servidor >= 0) servir();
+        else gravar_periodicamente();
+    });
+}
+
+ExportadorMetricas::~ExportadorMetricas() {
+    ::close(acordar[1]); // POLLHUP no outro lado encerra a thread
+    if (thread.joinable()) thread.join();
+    if (servidor >= 0) ::close(servidor);
+    ::close(acordar[0]);
+}
+
+std::string ExportadorMetricas::descricao() const {
+    if (servidor >= 0) return "http://127.0.0.1:" + std::to_string(porta) + "/metrics";
+    return arquivo;
+}
+
+std::string ExportadorMetricas::gerar() const {
+    std::string texto = texto_metricas();
+    if (medidores) medidores(texto);
+    return texto;
+}
+
+void ExportadorMetricas::servir() {
+    while (true) {
+        pollfd p[2] = {{servidor, POLLIN, 0}, {acordar[0], POLLIN, 0}};
+        if (::poll(p, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        if (p[1].revents) return;
+        int cliente = ::accept4(servidor, nullptr, nullptr, SOCK_CLOEXEC);
+        if (cliente < 0) continue;
+        responder(cliente);
+        ::close(cliente);
+    }
+}
+
+// HTTP/1.0 mínimo: uma requisição por conexão
+void ExportadorMetricas::responder(int cliente) const {
+    timeval limite{2, 0};
+    ::setsockopt(cliente, SOL_SOCKET, SO_RCVTIMEO, &limite, sizeof(limite));
+    ::setsockopt(cliente, SOL_SOCKET, SO_SNDTIMEO, &limite, sizeof(limite));
+
+    std::string requisicao;
+    char buffer[1024];
+    while (requisicao.find("\r\n\r\n") == std::string::npos && requisicao.size() < 8192) {
+        ssize_t n = ::recv(cliente, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        requisicao.append(buffer, n);
+    }
+
+    std::string linha = requisicao.substr(0, requisicao.find("\r\n"));
+    std::string status, tipo = "text/plain; charset=utf-8", corpo;
+    if (linha.rfind("GET /metrics ", 0) == 0 || linha.rfind("GET / ", 0) == 0) {
+        status = "200 OK";
+        tipo = "text/plain; version=0.0.4; charset=utf-8";
+        corpo = gerar();
+    } else if (linha.rfind("GET ", 0) == 0) {
+        status = "404 Not Found";
+        corpo = "use /metrics\n";
+    } else {
+        status = "405 Method Not Allowed";
+        corpo = "use GET /metrics\n";
+    }
+    escrever_tudo(cliente, "HTTP/1.0 " + status + "\r\nContent-Type: " + tipo + "\r\nContent-Length: " +
+                               std::to_string(corpo.size()) + "\r\nConnection: close\r\n\r\n" + corpo);
+}
+
+// grava em arquivo temporário e renomeia: quem lê nunca vê o arquivo pela metade
+void ExportadorMetricas::gravar_periodicamente() {
+    fs::path temporario = arquivo + ".tmp";
+    while (true) {
+        {
+            std::ofstream out(temporario, std::ios::trunc);
+            out << gerar();
+        }
+        std::error_code ec;
+        fs::rename(temporario, arquivo, ec);
+
+        pollfd p{acordar[0], POLLIN, 0};
+        int r = ::poll(&p, 1, static_cast<int>(intervalo_ms));
+        if (r < 0 && errno == EINTR) continue;
+        if (r != 0) return;
+    }
+}
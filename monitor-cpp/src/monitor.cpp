@@ -0,0 +1,1075 @@
+#include "monitor.h"
+#include "bloom.h"
+#include "cache_hash.h"
+#include "cripto.h"
+#include "fanotify.h"
+#include "ignore.h"
+#include "indice.h"
+#include "integridade.h"
+#include "journal.h"
+#include "log_eventos.h"
+#include "metricas.h"
+#include "motor_es.h"
+#include "store.h"
+#include "tabela_arquivos.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// custo mínimo de uma tarefa no escalonador, para que arquivos vazios também contem
+constexpr uint64_t CUSTO_MINIMO = 4096;
+
+// cada trabalhador retira da fila até TAMANHO_LOTE arquivos (ou BYTES_LOTE) de uma vez
+// e submete todos juntos ao motor de E/S
+constexpr size_t TAMANHO_LOTE = 32;
+constexpr uint64_t BYTES_LOTE = 64ull << 20;
+
+// estimativa do que cada caminho pendente ocupa além do texto (nó da árvore, alocação)
+constexpr uint64_t CUSTO_NO_PENDENTE = 64;
+
+// varredura adaptativa: intervalo de um diretório logo após uma mudança e o teto ao
+// qual chegam os parados, dobrando a cada listagem sem novidade
+constexpr std::chrono::milliseconds SONDAGEM_MINIMA{250};
+constexpr std::chrono::milliseconds SONDAGEM_MAXIMA{32000};
+// sem diretório vencido, o laço ainda acorda a cada segundo (raízes que ficaram ociosas)
+constexpr std::chrono::milliseconds ESPERA_MAXIMA_SONDAGEM{1000};
+// com o orçamento esgotado, espera ao menos isto pelas fichas
+constexpr std::chrono::milliseconds ESPERA_MINIMA_SONDAGEM{20};
+
+// diretório acompanhado pela varredura adaptativa
+struct DiretorioSondado {
+    fs::path caminho;
+    FiltroIgnorar::Estado estado; // regras de exclusão ativas para as entradas
+    std::chrono::milliseconds intervalo = SONDAGEM_MINIMA;
+    std::chrono::steady_clock::time_point proxima{};
+};
+
+int64_t agora_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+void descartar(const fs::path &pendente) {
+    std::error_code ec;
+    if (!pendente.empty()) fs::remove(pendente, ec);
+}
+
+} // namespace
+
+void varrer_diretorio(const fs::path &dir, TabelaArquivos &tabela, TabelaArquivos::Id id_dir,
+                      const FiltroIgnorar &filtro, const FiltroIgnorar::Estado &estado,
+                      const std::function<void(const fs::directory_entry &, TabelaArquivos::Id)> &visitar) {
+    std::error_code ec;
+    FiltroIgnorar::Estado estado_filho;
+    for (auto &entry : fs::directory_iterator(dir, ec)) {
+        bool diretorio = entry.is_directory(ec) && !entry.is_symlink(ec);
+        std::string nome = entry.path().filename().string();
+        if (filtro.ignorado(estado, nome, diretorio, estado_filho)) continue;
+
+        if (diretorio) {
+            varrer_diretorio(entry.path(), tabela, tabela.internar(id_dir, nome), filtro, estado_filho, visitar);
+        } else if (entry.is_regular_file(ec)) {
+            visitar(entry, tabela.internar(id_dir, nome));
+        }
+    }
+}
+
+ConfigMonitor carregar_config(const fs::path &arquivo) {
+    std::ifstream in(arquivo);
+    if (!in) throw std::runtime_error("não foi possível abrir " + arquivo.string());
+
+    ConfigMonitor config;
+    std::string linha;
+    for (size_t numero = 1; std::getline(in, linha); ++numero) {
+        auto erro = [&](const std::string &msg) {
+            return std::runtime_error(arquivo.string() + ":" + std::to_string(numero) + ": " + msg);
+        };
+        std::istringstream campos(linha.substr(0, linha.find('#')));
+        std::string chave;
+        if (!(campos >> chave)) continue;
+
+        if (chave == "threads") {
+            if (!(campos >> config.threads)) throw erro("esperado: threads <n>");
+        } else if (chave == "intervalo") {
+            long ms = 0;
+            if (!(campos >> ms) || ms <= 0) throw erro("esperado: intervalo <milissegundos>");
+            config.intervalo = std::chrono::milliseconds(ms);
+        } else if (chave == "eventos") {
+            std::string modo;
+            campos >> modo;
+            if (modo != "fanotify" && modo != "varredura") throw erro("esperado: eventos fanotify|varredura");
+            config.fanotify = modo == "fanotify";
+        } else if (chave == "log") {
+            std::string log;
+            if (!(campos >> log)) throw erro("esperado: log <arquivo>");
+            config.log = log;
+        } else if (chave == "fila") {
+            uint64_t mib = 0;
+            if (!(campos >> config.fila_arquivos) || config.fila_arquivos == 0)
+                throw erro("esperado: fila <arquivos> [MiB]");
+            if (campos >> mib) {
+                if (mib == 0) throw erro("o limite em MiB deve ser maior que zero");
+                config.fila_bytes = mib << 20;
+            }
+        } else if (chave == "sondagem") {
+            if (!(campos >> config.sondagem) || config.sondagem == 0) throw erro("esperado: sondagem <chamadas por segundo>");
+        } else if (chave == "metricas") {
+            if (!(campos >> config.metricas)) throw erro("esperado: metricas <porta|arquivo>");
+        } else if (chave == "raiz") {
+            ConfigRaiz raiz;
+            std::string entrada, saida;
+            if (!(campos >> entrada >> saida)) throw erro("esperado: raiz <entrada> <saida> [prioridade]");
+            raiz.entrada = entrada;
+            raiz.saida = saida;
+            if (campos >> raiz.prioridade && raiz.prioridade == 0) throw erro("prioridade deve ser maior que zero");
+            if (raiz.prioridade == 0) raiz.prioridade = 1;
+            config.raizes.push_back(raiz);
+        } else {
+            throw erro("diretiva desconhecida: " + chave);
+        }
+    }
+    if (config.raizes.empty()) throw std::runtime_error(arquivo.string() + ": nenhuma raiz configurada");
+    return config;
+}
+
+struct MonitorRaizes::Tarefa {
+    TabelaArquivos::Id id;
+    fs::path caminho;
+    int64_t mtime;
+    uint64_t tamanho;
+    int64_t mtime_origem_ns;
+    unsigned modo; // permissões do arquivo, preservadas na versão
+    IdentidadeArquivo identidade{}; // só de arquivos ainda não capturados, candidatos a movidos
+
+    // arquivo movido: hash e versão existente do caminho antigo (ver detectar_movidos)
+    std::string hash_movido{};
+    fs::path versao_movida{};
+};
+
+// tarefas de uma varredura ou de um lote de eventos; a fila da raiz está vazia quando
+// elas são coletadas, então o limite da coleta é o limite da fila
+struct MonitorRaizes::Coleta {
+    std::vector<Tarefa> tarefas;
+    uint64_t bytes = 0;
+    bool transbordou = false;
+};
+
+struct MonitorRaizes::Raiz {
+    ConfigRaiz config;
+    FiltroIgnorar filtro;
+    TabelaArquivos arquivos;
+    JournalVersoes journal;
+    FiltroBloom versoes_salvas;
+    std::mutex mutex_store; // journal e filtro de versões
+
+    // identidades em `arquivos` (ver detectar_movidos): os trabalhadores atualizam sob
+    // mutex_inodes, a thread principal consulta com a raiz ociosa
+    std::mutex mutex_inodes;
+
+    // protegidos por MonitorRaizes::mutex
+    std::deque<Tarefa> fila;
+    size_t em_andamento = 0; // tarefas na fila ou executando
+    bool transbordou = false; // a última coleta deixou arquivos de fora: varrer de novo logo
+    double passada = 0;      // relógio virtual do escalonador
+    std::chrono::steady_clock::time_point proxima_varredura{};
+
+    // modo fanotify, usados só pela thread principal
+    std::string canonica;           // entrada como o kernel a reporta
+    std::set<std::string> sujos;    // caminhos relativos apontados por eventos
+    uint64_t bytes_sujos = 0;       // estimativa da memória de `sujos`
+    // arquivos escritos e ainda abertos, com o instante do primeiro FAN_MODIFY; passam a
+    // `sujos` quando fecham ou quando o evento mais antigo completa um intervalo
+    std::map<std::string, std::chrono::steady_clock::time_point> modificados;
+    uint64_t bytes_modificados = 0;
+    bool varrer_tudo = true;        // também na varredura adaptativa
+
+    // varredura adaptativa, também só da thread principal
+    std::unordered_map<TabelaArquivos::Id, DiretorioSondado> diretorios;
+
+    // medidores exportados em /metrics
+    std::atomic<uint64_t> bytes_store{0};
+    std::atomic<uint64_t> versoes_store{0};
+    std::atomic<int64_t> ultima_captura_ns{0};
+
+    // resumo impresso ao fim de cada passada; o detalhe de cada arquivo vai para o log de eventos
+    std::atomic<uint64_t> salvas_passada{0};
+    std::atomic<uint64_t> erros_passada{0};
+
+    explicit Raiz(const ConfigRaiz &config) : config(config), journal(config.saida) {}
+};
+
+MonitorRaizes::MonitorRaizes(const ConfigMonitor &config) : config(config), inicio_ns(agora_ns()) {
+    std::set<fs::path> saidas;
+    for (auto &c : config.raizes) {
+        if (!fs::is_directory(c.entrada)) throw std::runtime_error("Diretório inválido: " + c.entrada.string());
+        fs::create_directories(c.saida);
+        if (!saidas.insert(fs::weakly_canonical(c.saida)).second)
+            throw std::runtime_error("duas raízes usam o mesmo store: " + c.saida.string());
+
+        preparar_store(c.saida);
+        auto raiz = std::make_unique<Raiz>(c);
+        if (size_t arquivos = raiz->filtro.carregar_arvore(c.entrada)) {
+            std::cout << "🚫 " << raiz->filtro.total_regras() << " regras de exclusão carregadas de " << arquivos
+                      << " arquivos " << FiltroIgnorar::NOME_ARQUIVO << " em " << c.entrada << std::endl;
+        }
+        raiz->canonica = fs::canonical(c.entrada).string();
+        raiz->journal.recuperar();
+        abrir_filtro_versoes(raiz->versoes_salvas, c.saida);
+        raizes.push_back(std::move(raiz));
+    }
+    if (this->config.threads == 0) this->config.threads = std::max(1u, std::thread::hardware_concurrency());
+    if (this->config.log.empty()) this->config.log = this->config.raizes.front().saida / ".monitor" / "eventos.bin";
+    if (this->config.metricas.empty()) {
+        if (const char *m = std::getenv("MONITOR_METRICAS")) this->config.metricas = m;
+    }
+    if (this->config.sondagem == 0) {
+        if (const char *s = std::getenv("MONITOR_SONDAGEM")) this->config.sondagem = std::strtoul(s, nullptr, 10);
+    }
+}
+
+MonitorRaizes::~MonitorRaizes() {
+    exportador.reset();
+    {
+        std::lock_guard<std::mutex> l(mutex);
+        encerrar = true;
+    }
+    cv_trabalho.notify_all();
+    for (auto &t : trabalhadores) t.join();
+}
+
+void MonitorRaizes::executar() {
+    log = std::make_unique<LogEventos>(config.log);
+    std::cout << "📝 Eventos de cada arquivo em " << config.log << std::endl;
+    if (chave_configurada()) std::cout << "🔒 Versões novas serão cifradas (AES-256-GCM)" << std::endl;
+    for (auto &r : raizes) {
+        std::cout << "📡 Monitorando " << r->config.entrada << " e salvando versões em " << r->config.saida;
+        if (raizes.size() > 1) std::cout << " (prioridade " << r->config.prioridade << ")";
+        std::cout << std::endl;
+    }
+    if (!config.metricas.empty()) iniciar_metricas();
+    // a marca precisa existir antes da primeira varredura para nenhuma mudança se perder
+    std::unique_ptr<FonteFanotify> fonte;
+    if (config.fanotify) {
+        std::vector<fs::path> pastas;
+        for (auto &r : raizes) pastas.push_back(r->canonica);
+        try {
+            fonte = std::make_unique<FonteFanotify>(pastas);
+            std::cout << "🛰️ Recebendo eventos do sistema de arquivos via fanotify" << std::endl;
+        } catch (const std::exception &e) {
+            std::cerr << "⚠️ fanotify indisponível (" << e.what() << "), usando varredura periódica" << std::endl;
+        }
+    }
+    for (unsigned i = 0; i < config.threads; ++i) trabalhadores.emplace_back([this] { trabalhar(); });
+    if (fonte) {
+        executar_eventos(*fonte);
+        return;
+    }
+    if (config.sondagem > 0) {
+        std::cout << "🎯 Varredura adaptativa por diretório (até " << config.sondagem << " chamadas/s)" << std::endl;
+        executar_sondagem();
+        return;
+    }
+
+    std::unique_lock<std::mutex> l(mutex);
+    while (!encerrar) {
+        auto agora = std::chrono::steady_clock::now();
+        auto proxima = agora + config.intervalo;
+        std::vector<Raiz *> prontas;
+        for (auto &r : raizes) {
+            if (r->em_andamento > 0) continue;
+            if (r->proxima_varredura <= agora) prontas.push_back(r.get());
+            else proxima = std::min(proxima, r->proxima_varredura);
+        }
+
+        if (prontas.empty()) {
+            cv_livre.wait_until(l, proxima);
+            continue;
+        }
+        l.unlock();
+        for (Raiz *r : prontas) varrer(*r);
+        l.lock();
+    }
+}
+
+void MonitorRaizes::iniciar_metricas() {
+    // o tamanho do store é contado uma vez aqui e depois acompanhado a cada versão salva
+    for (auto &r : raizes) {
+        uint64_t bytes = 0, versoes = 0;
+        percorrer_versoes(r->config.saida, [&](const std::string &relativo) {
+            std::error_code ec;
+            uint64_t tamanho = fs::file_size(r->config.saida / relativo, ec);
+            if (ec) return;
+            bytes += tamanho;
+            ++versoes;
+        });
+        r->bytes_store = bytes;
+        r->versoes_store = versoes;
+    }
+    exportador = std::make_unique<ExportadorMetricas>(config.metricas, [this](std::string &texto) { medir(texto); },
+                                                      static_cast<unsigned>(config.intervalo.count()));
+    std::cout << "📈 Métricas em " << exportador->descricao() << std::endl;
+}
+
+// medidores instantâneos por raiz; chamado pela thread do exportador
+void MonitorRaizes::medir(std::string &texto) {
+    struct Medidor {
+        const char *nome, *ajuda;
+        std::function<double(Raiz &)> valor;
+    };
+    std::lock_guard<std::mutex> l(mutex);
+    const Medidor medidores[] = {
+        {"monitor_fila_tarefas", "Arquivos alterados aguardando captura.",
+         [](Raiz &r) { return static_cast<double>(r.fila.size()); }},
+        {"monitor_tarefas_em_andamento", "Arquivos na fila ou sendo capturados.",
+         [](Raiz &r) { return static_cast<double>(r.em_andamento); }},
+        {"monitor_store_bytes", "Bytes ocupados pelas versões no store.",
+         [](Raiz &r) { return static_cast<double>(r.bytes_store.load()); }},
+        {"monitor_store_versoes", "Versões no store.", [](Raiz &r) { return static_cast<double>(r.versoes_store.load()); }},
+        {"monitor_ultima_captura_segundos", "Instante Unix da última versão salva (0 = nenhuma desde a partida).",
+         [](Raiz &r) { return static_cast<double>(r.ultima_captura_ns.load()) / 1e9; }},
+    };
+    for (auto &m : medidores) {
+        texto += std::string("# HELP ") + m.nome + " " + m.ajuda + "\n";
+        texto += std::string("# TYPE ") + m.nome + " gauge\n";
+        for (auto &r : raizes) {
+            std::string rotulo;
+            for (char c : r->config.entrada.string()) {
+                if (c == '\\' || c == '"') rotulo += '\\';
+                if (c == '\n') rotulo += "\\n";
+                else rotulo += c;
+            }
+            char valor[32];
+            std::snprintf(valor, sizeof(valor), "%.17g", m.valor(*r));
+            texto += std::string(m.nome) + "{raiz=\"" + rotulo + "\"} " + valor + "\n";
+        }
+    }
+}
+
+void MonitorRaizes::executar_eventos(FonteFanotify &fonte) {
+    const auto espera = std::min<std::chrono::milliseconds>(config.intervalo, std::chrono::milliseconds(250));
+    std::vector<fs::path> caminhos, modificados;
+
+    // um arquivo sempre aberto gera FAN_MODIFY a cada escrita: ele é examinado no máximo
+    // uma vez por intervalo, e logo que for fechado
+    auto registrar = [&](Raiz &r, std::string relativo, bool so_escrita) {
+        uint64_t custo = relativo.size() + sizeof(std::string) + CUSTO_NO_PENDENTE;
+        if (so_escrita) {
+            if (r.sujos.count(relativo)) return;
+            auto [it, novo] = r.modificados.try_emplace(std::move(relativo), std::chrono::steady_clock::now());
+            if (novo) r.bytes_modificados += custo;
+        } else {
+            auto aberto = r.modificados.find(relativo);
+            if (aberto != r.modificados.end()) {
+                r.modificados.erase(aberto);
+                r.bytes_modificados -= custo;
+            }
+            if (r.sujos.insert(std::move(relativo)).second) r.bytes_sujos += custo;
+        }
+        if (r.sujos.size() + r.modificados.size() > config.fila_arquivos ||
+            r.bytes_sujos + r.bytes_modificados > config.fila_bytes) {
+            std::cerr << "⚠️ Eventos pendentes de " << r.config.entrada << " passaram do limite: varrendo a raiz"
+                      << std::endl;
+            contar(Contador::FILA_TRANSBORDADA);
+            std::set<std::string>().swap(r.sujos);
+            decltype(r.modificados)().swap(r.modificados);
+            r.bytes_sujos = r.bytes_modificados = 0;
+            r.varrer_tudo = true;
+        }
+    };
+
+    while (true) {
+        const auto agora = std::chrono::steady_clock::now();
+        for (auto &r : raizes) {
+            for (auto it = r->modificados.begin(); it != r->modificados.end();) {
+                if (agora - it->second < config.intervalo) {
+                    ++it;
+                    continue;
+                }
+                uint64_t custo = it->first.size() + sizeof(std::string) + CUSTO_NO_PENDENTE;
+                r->bytes_modificados -= custo;
+                if (r->sujos.insert(it->first).second) r->bytes_sujos += custo;
+                it = r->modificados.erase(it);
+            }
+        }
+
+        // a tabela de uma raiz só muda quando ela não tem tarefas em andamento
+        std::vector<Raiz *> ociosas;
+        {
+            std::lock_guard<std::mutex> l(mutex);
+            if (encerrar) return;
+            for (auto &r : raizes) {
+                if (r->em_andamento == 0) ociosas.push_back(r.get());
+            }
+        }
+        for (Raiz *r : ociosas) {
+            if (r->varrer_tudo) {
+                r->varrer_tudo = false;
+                r->sujos.clear();
+                r->modificados.clear();
+                r->bytes_sujos = r->bytes_modificados = 0;
+                varrer(*r);
+            } else if (!r->sujos.empty()) {
+                processar_eventos(*r);
+            }
+        }
+
+        caminhos.clear();
+        modificados.clear();
+        if (!fonte.aguardar(espera, caminhos, modificados)) {
+            std::cerr << "⚠️ Fila do fanotify transbordou: varrendo todas as raízes" << std::endl;
+            for (auto &r : raizes) r->varrer_tudo = true;
+        }
+        // eventos chegam do sistema de arquivos inteiro: só interessam os que caem em uma raiz
+        for (auto *lista : {&caminhos, &modificados}) {
+            for (auto &caminho : *lista) {
+                const std::string &c = caminho.native();
+                for (auto &r : raizes) {
+                    if (c.size() > r->canonica.size() + 1 && c.compare(0, r->canonica.size(), r->canonica) == 0 &&
+                        c[r->canonica.size()] == '/') {
+                        // a varredura completa já cobre o caminho
+                        if (!r->varrer_tudo) registrar(*r, c.substr(r->canonica.size() + 1), lista == &modificados);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Cada passo junta os diretórios vencidos das raízes ociosas e lista os mais atrasados
+// (atraso / intervalo) enquanto houver fichas. As fichas chegam à taxa do orçamento e
+// acumulam no máximo um segundo; cada listagem gasta o que custou, e a dívida de uma
+// listagem grande (a varredura inicial, uma árvore nova) também fica limitada a um
+// segundo, para não congelar os diretórios quentes.
+void MonitorRaizes::executar_sondagem() {
+    using Relogio = std::chrono::steady_clock;
+    struct Vencido {
+        double atraso; // em intervalos do próprio diretório
+        Raiz *raiz;
+        TabelaArquivos::Id id;
+    };
+    const double orcamento = config.sondagem;
+    double fichas = orcamento;
+    auto ultima = Relogio::now();
+    std::vector<Vencido> vencidos;
+    while (true) {
+        std::vector<Raiz *> ociosas;
+        {
+            std::lock_guard<std::mutex> l(mutex);
+            if (encerrar) return;
+            for (auto &r : raizes) {
+                if (r->em_andamento == 0) ociosas.push_back(r.get());
+            }
+        }
+        auto agora = Relogio::now();
+        fichas = std::min(orcamento, fichas + orcamento * std::chrono::duration<double>(agora - ultima).count());
+        ultima = agora;
+        auto gastar = [&](uint64_t custo) { fichas = std::max(-orcamento, fichas - static_cast<double>(custo)); };
+
+        std::unordered_map<Raiz *, Coleta> coletas;
+        auto acordar = agora + ESPERA_MAXIMA_SONDAGEM;
+        vencidos.clear();
+        for (Raiz *r : ociosas) {
+            if (r->varrer_tudo) {
+                // partida ou fila transbordada: a árvore inteira, descobrindo os diretórios
+                r->varrer_tudo = false;
+                auto &raiz = r->diretorios[TabelaArquivos::RAIZ];
+                raiz.caminho = r->config.entrada;
+                raiz.estado = r->filtro.estado_inicial();
+                int64_t inicio = agora_ns();
+                gastar(sondar(*r, TabelaArquivos::RAIZ, coletas[r], true));
+                contar(Contador::VARREDURAS);
+                observar(Histograma::DURACAO_VARREDURA, agora_ns() - inicio);
+                continue;
+            }
+            for (auto &[id, d] : r->diretorios) {
+                if (d.proxima <= agora)
+                    vencidos.push_back({std::chrono::duration<double>(agora - d.proxima) / d.intervalo, r, id});
+                else
+                    acordar = std::min(acordar, d.proxima);
+            }
+        }
+        std::sort(vencidos.begin(), vencidos.end(), [](const Vencido &a, const Vencido &b) { return a.atraso > b.atraso; });
+        for (auto &v : vencidos) {
+            if (fichas <= 0) {
+                auto falta = std::chrono::duration<double>(-fichas / orcamento);
+                acordar = agora + std::max<Relogio::duration>(ESPERA_MINIMA_SONDAGEM,
+                                                             std::chrono::duration_cast<Relogio::duration>(falta));
+                break;
+            }
+            gastar(sondar(*v.raiz, v.id, coletas[v.raiz], false));
+        }
+        for (auto &[r, coleta] : coletas) {
+            if (coleta.transbordou) r->varrer_tudo = true; // o que ficou de fora só aparece numa listagem completa
+            detectar_movidos(*r, coleta);
+            enfileirar(*r, coleta);
+        }
+
+        std::unique_lock<std::mutex> l(mutex);
+        if (!encerrar) cv_livre.wait_until(l, acordar);
+    }
+}
+
+// Lista um diretório da varredura adaptativa e reagenda: com mudança (arquivo novo ou
+// alterado, subdiretório novo) ele volta ao intervalo mínimo; sem, o intervalo dobra.
+// Subdiretórios novos são listados na hora, por inteiro; com `recursivo`, todos.
+// Retorna as chamadas gastas: a listagem e um stat por entrada.
+uint64_t MonitorRaizes::sondar(Raiz &raiz, TabelaArquivos::Id id, Coleta &coleta, bool recursivo) {
+    auto it = raiz.diretorios.find(id);
+    if (it == raiz.diretorios.end()) return 0;
+    DiretorioSondado &d = it->second; // referências ao unordered_map sobrevivem às inserções
+    contar(Contador::DIRETORIOS_SONDADOS);
+
+    std::error_code ec;
+    fs::directory_iterator entradas(d.caminho, ec);
+    if (ec) {
+        // removido ou trocado por arquivo; os subdiretórios saem quando falharem também
+        raiz.diretorios.erase(it);
+        return 1;
+    }
+    uint64_t custo = 1;
+    size_t antes = coleta.tarefas.size();
+    bool subdiretorio_novo = false;
+    std::vector<TabelaArquivos::Id> descer;
+    FiltroIgnorar::Estado estado_filho;
+    for (auto &entry : entradas) {
+        ++custo;
+        bool diretorio = entry.is_directory(ec) && !entry.is_symlink(ec);
+        std::string nome = entry.path().filename().string();
+        if (raiz.filtro.ignorado(d.estado, nome, diretorio, estado_filho)) continue;
+
+        TabelaArquivos::Id filho = raiz.arquivos.internar(id, nome);
+        if (diretorio) {
+            auto [novo, inserido] = raiz.diretorios.try_emplace(filho);
+            if (inserido) {
+                novo->second.caminho = entry.path();
+                novo->second.estado = estado_filho;
+                subdiretorio_novo = true;
+            }
+            if (inserido || recursivo) descer.push_back(filho);
+        } else if (entry.is_regular_file(ec)) {
+            examinar(raiz, entry, filho, coleta);
+        }
+    }
+
+    bool mudou = subdiretorio_novo || coleta.tarefas.size() != antes || coleta.transbordou;
+    d.intervalo = mudou ? SONDAGEM_MINIMA : std::min(d.intervalo * 2, SONDAGEM_MAXIMA);
+    d.proxima = std::chrono::steady_clock::now() + d.intervalo;
+    for (TabelaArquivos::Id filho : descer) custo += sondar(raiz, filho, coleta, recursivo);
+    return custo;
+}
+
+// desce da raiz até cada caminho apontado por evento, aplicando as regras de exclusão
+// componente a componente; um diretório novo é varrido por inteiro
+void MonitorRaizes::processar_eventos(Raiz &raiz) {
+    Coleta coleta;
+    for (auto &relativo : raiz.sujos) {
+        fs::path caminho = raiz.config.entrada;
+        TabelaArquivos::Id id = TabelaArquivos::RAIZ;
+        FiltroIgnorar::Estado estado = raiz.filtro.estado_inicial(), estado_filho;
+        fs::path rel(relativo);
+        for (auto it = rel.begin(); it != rel.end(); ++it) {
+            std::string nome = it->string();
+            bool ultimo = std::next(it) == rel.end();
+            caminho /= nome;
+
+            std::error_code ec;
+            fs::directory_entry entry(caminho, ec);
+            if (ec || !entry.exists(ec)) break; // removido antes de ser examinado
+            bool diretorio = entry.is_directory(ec) && !entry.is_symlink(ec);
+            if ((!ultimo && !diretorio) || raiz.filtro.ignorado(estado, nome, diretorio, estado_filho)) break;
+            id = raiz.arquivos.internar(id, nome);
+            estado = estado_filho;
+            if (!ultimo) continue;
+
+            if (diretorio) {
+                varrer_diretorio(caminho, raiz.arquivos, id, raiz.filtro, estado,
+                                 [&](const fs::directory_entry &e, TabelaArquivos::Id i) { examinar(raiz, e, i, coleta); });
+            } else if (entry.is_regular_file(ec)) {
+                examinar(raiz, entry, id, coleta);
+            }
+        }
+    }
+    raiz.sujos.clear();
+    raiz.bytes_sujos = 0;
+    // os eventos que ficaram de fora já foram consumidos: só uma varredura completa os recupera
+    if (coleta.transbordou) raiz.varrer_tudo = true;
+    detectar_movidos(raiz, coleta);
+    enfileirar(raiz, coleta);
+}
+
+// a varredura só compara mtime e tamanho; hash e cópia ficam para os trabalhadores
+void MonitorRaizes::varrer(Raiz &raiz) {
+    Coleta coleta;
+    int64_t inicio = agora_ns();
+    std::vector<bool> vistos(raiz.arquivos.tamanho());
+    varrer_diretorio(raiz.config.entrada, raiz.arquivos, TabelaArquivos::RAIZ, raiz.filtro,
+                     raiz.filtro.estado_inicial(), [&](const fs::directory_entry &entry, TabelaArquivos::Id id) {
+                         if (id >= vistos.size()) vistos.resize(id + 1);
+                         vistos[id] = true;
+                         examinar(raiz, entry, id, coleta);
+                     });
+    contar(Contador::VARREDURAS);
+    observar(Histograma::DURACAO_VARREDURA, agora_ns() - inicio);
+    if (coleta.transbordou) raiz.varrer_tudo = true; // modo fanotify: o resto vem da próxima varredura
+    detectar_movidos(raiz, coleta);
+
+    // capturados que a varredura completa não encontrou foram apagados (ou movidos, já tratados acima)
+    std::vector<TabelaArquivos::Id> apagados;
+    raiz.arquivos.para_cada_identificado([&](TabelaArquivos::Id id) {
+        if (id >= vistos.size() || !vistos[id]) apagados.push_back(id);
+    });
+    for (auto id : apagados) esquecer(raiz, id);
+    enfileirar(raiz, coleta);
+}
+
+void MonitorRaizes::examinar(Raiz &raiz, const fs::directory_entry &entry, uint32_t id, Coleta &coleta) {
+    std::error_code ec;
+    contar(Contador::ARQUIVOS_VARRIDOS);
+    auto &registro = raiz.arquivos.registro(id);
+    auto escrita = entry.last_write_time(ec);
+    uint64_t tamanho = entry.file_size(ec);
+    if (ec) return;
+    int64_t mod_time = escrita.time_since_epoch().count();
+    if (registro.mtime == mod_time && registro.tamanho == tamanho) return;
+
+    // fila cheia: o registro continua com o estado antigo e a próxima varredura encontra o arquivo
+    uint64_t custo = sizeof(Tarefa) + entry.path().native().size();
+    if (coleta.tarefas.size() >= config.fila_arquivos || coleta.bytes + custo > config.fila_bytes) {
+        coleta.transbordou = true;
+        return;
+    }
+    coleta.bytes += custo;
+    coleta.tarefas.push_back({.id = id,
+                              .caminho = entry.path(),
+                              .mtime = mod_time,
+                              .tamanho = tamanho,
+                              .mtime_origem_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                                     std::chrono::file_clock::to_sys(escrita).time_since_epoch())
+                                                     .count(),
+                              .modo = static_cast<unsigned>(entry.status(ec).permissions() & fs::perms::mask)});
+
+    if (registro.mtime == INT64_MIN && raiz.arquivos.identificados() != 0)
+        identificar_arquivo(entry.path(), coleta.tarefas.back().identidade);
+}
+
+// Arquivos novos que batem em dispositivo, inode, tamanho e mtime com um registro já
+// capturado, cujo caminho antigo não existe mais (ou é outro arquivo), são o mesmo
+// arquivo com outro nome. O ctime não pode ter passado do instante da captura: isso
+// descarta um inode reaproveitado por um arquivo novo e também o arquivo renomeado ele
+// mesmo (rename atualiza o ctime), que é capturado normalmente; o que sobra é o
+// arquivo levado junto com um diretório movido. O hash completo vem da última entrada
+// do índice do caminho antigo, conferida com o prefixo do registro. Roda na thread
+// principal com a raiz ociosa: a tabela pode ser lida sem disputar com os trabalhadores.
+void MonitorRaizes::detectar_movidos(Raiz &raiz, Coleta &coleta) {
+    if (raiz.arquivos.identificados() == 0) return;
+    IndiceVersoes indice(raiz.config.saida);
+    for (Tarefa &t : coleta.tarefas) {
+        TabelaArquivos::Id id = raiz.arquivos.capturado_com_inode(t.identidade.inode);
+        if (id == TabelaArquivos::NENHUM || id == t.id) continue;
+        TabelaArquivos::Registro registro = raiz.arquivos.registro(id);
+        TabelaArquivos::Identidade anterior = raiz.arquivos.identidade(id);
+        std::string antigo = raiz.arquivos.caminho(id);
+
+        IdentidadeArquivo atual;
+        if (!identificar_arquivo(raiz.config.entrada / antigo, atual)) {
+            esquecer(raiz, id); // caminho antigo apagado: o registro não descreve mais arquivo algum
+        } else if (atual.dispositivo == t.identidade.dispositivo && atual.inode == t.identidade.inode) {
+            continue; // o mesmo inode ainda no caminho antigo: um hard link, não uma mudança de nome
+        }
+        if (registro.mtime == INT64_MIN || anterior.dispositivo != TabelaArquivos::dispositivo_compacto(t.identidade.dispositivo) ||
+            t.identidade.ctime_ns > anterior.capturado_ns || t.mtime != registro.mtime ||
+            t.tamanho != registro.tamanho)
+            continue;
+
+        try {
+            size_t total = indice.total(antigo);
+            if (total == 0) continue;
+            auto ultima = indice.ler(antigo, total - 1, 1);
+            uint8_t prefixo[TabelaArquivos::TAMANHO_HASH];
+            if (ultima.empty()) continue;
+            TabelaArquivos::hash_de_hex(ultima[0].hash, prefixo);
+            if (!std::equal(prefixo, prefixo + TabelaArquivos::TAMANHO_HASH, registro.hash)) continue;
+            fs::path versao = raiz.config.saida / (antigo + "_" + ultima[0].hash);
+            if (!fs::exists(versao)) continue;
+            t.hash_movido = ultima[0].hash;
+            t.versao_movida = versao;
+        } catch (const std::exception &) {
+            // índice ilegível: o arquivo é capturado como novo
+        }
+    }
+}
+
+// arquivo que deixou de existir: volta a "nunca capturado" e perde a identidade
+void MonitorRaizes::esquecer(Raiz &raiz, TabelaArquivos::Id id) {
+    raiz.arquivos.definir_identidade(id, {});
+    raiz.arquivos.registro(id) = {};
+}
+
+void MonitorRaizes::enfileirar(Raiz &raiz, Coleta &coleta) {
+    if (coleta.transbordou) {
+        std::cerr << "⚠️ Fila de " << raiz.config.entrada << " cheia com " << coleta.tarefas.size()
+                  << " arquivos: o restante fica para a próxima varredura" << std::endl;
+        contar(Contador::FILA_TRANSBORDADA);
+    }
+    std::lock_guard<std::mutex> l(mutex);
+    raiz.proxima_varredura = std::chrono::steady_clock::now() + config.intervalo;
+    raiz.transbordou = coleta.transbordou;
+    if (coleta.tarefas.empty()) return;
+    // raiz que ficou ociosa não acumula crédito: entra no relógio atual
+    raiz.passada = std::max(raiz.passada, tempo_virtual);
+    raiz.em_andamento = coleta.tarefas.size();
+    for (auto &t : coleta.tarefas) raiz.fila.push_back(std::move(t));
+    cv_trabalho.notify_all();
+}
+
+// raiz com tarefas e menor relógio virtual; chamado com `mutex` travado
+MonitorRaizes::Raiz *MonitorRaizes::escolher() {
+    Raiz *escolhida = nullptr;
+    for (auto &r : raizes) {
+        if (!r->fila.empty() && (!escolhida || r->passada < escolhida->passada)) escolhida = r.get();
+    }
+    return escolhida;
+}
+
+void MonitorRaizes::trabalhar() {
+    MotorES motor(TAMANHO_LOTE);
+    std::unique_lock<std::mutex> l(mutex);
+    while (true) {
+        Raiz *raiz = nullptr;
+        cv_trabalho.wait(l, [&] { return encerrar || (raiz = escolher()) != nullptr; });
+        if (encerrar) return;
+
+        // lote de tarefas da mesma raiz, limitado em arquivos e bytes para não prejudicar a justiça
+        std::vector<Tarefa> lote;
+        uint64_t custo = 0;
+        while (!raiz->fila.empty() && lote.size() < TAMANHO_LOTE && custo < BYTES_LOTE) {
+            custo += std::max(raiz->fila.front().tamanho, CUSTO_MINIMO);
+            lote.push_back(std::move(raiz->fila.front()));
+            raiz->fila.pop_front();
+        }
+        tempo_virtual = raiz->passada;
+        raiz->passada += static_cast<double>(custo) / raiz->config.prioridade;
+        l.unlock();
+
+        capturar(*raiz, lote, motor);
+
+        l.lock();
+        // último lote da raiz: confirma o grupo antes de liberar a próxima varredura
+        if (raiz->em_andamento == lote.size() && raiz->fila.empty()) {
+            l.unlock();
+            concluir(*raiz);
+            l.lock();
+            // com arquivos deixados de fora, a próxima varredura não espera o intervalo
+            raiz->proxima_varredura = std::chrono::steady_clock::now();
+            if (!raiz->transbordou) raiz->proxima_varredura += config.intervalo;
+        }
+        raiz->em_andamento -= lote.size();
+        if (raiz->em_andamento == 0) cv_livre.notify_one();
+    }
+}
+
+void MonitorRaizes::concluir(Raiz &raiz) {
+    {
+        std::lock_guard<std::mutex> l(raiz.mutex_store);
+        try {
+            raiz.journal.confirmar();
+            if (raiz.versoes_salvas.cheio()) abrir_filtro_versoes(raiz.versoes_salvas, raiz.config.saida);
+        } catch (const std::exception &e) {
+            std::cerr << "Erro confirmando versões de " << raiz.config.entrada << ": " << e.what() << std::endl;
+        }
+    }
+    if (uint64_t salvas = raiz.salvas_passada.exchange(0))
+        std::cout << "💾 " << salvas << (salvas == 1 ? " versão salva de " : " versões salvas de ") << raiz.config.entrada
+                  << std::endl;
+    if (uint64_t erros = raiz.erros_passada.exchange(0))
+        std::cerr << "⚠️ " << erros << (erros == 1 ? " erro" : " erros") << " capturando " << raiz.config.entrada
+                  << " (detalhes em --log)" << std::endl;
+}
+
+// cada tarefa toca apenas o próprio registro na tabela, que não é realocada enquanto
+// a raiz tem tarefas pendentes (a varredura espera todas terminarem)
+void MonitorRaizes::capturar(Raiz &raiz, const std::vector<Tarefa> &tarefas, MotorES &motor) {
+    struct Captura {
+        std::string hash;
+        uint64_t tamanho = 0;
+        fs::path pendente;
+        fs::path destino;
+        std::string versao;
+        bool salvar = false;
+        bool ligada = false; // pendente é um hard link da versão do caminho antigo
+        std::unique_ptr<SomasEmFluxo> somas; // calculadas enquanto o pendente é gravado
+    };
+    std::vector<Captura> capturas(tarefas.size());
+    auto calcular_somas = [](Captura &c, uint64_t tamanho_previsto) {
+        fs::path temporario = c.pendente;
+        temporario += ".crc";
+        c.somas = std::make_unique<SomasEmFluxo>(temporario, grupo_paridade_configurado(), tamanho_previsto);
+        return c.somas.get();
+    };
+
+    // identidade de cada arquivo capturado, para reconhecê-lo se for movido; o instante
+    // é tomado depois da gravação do atributo de cache, que também atualiza o ctime
+    auto lembrar = [&](TabelaArquivos::Id id, const IdentidadeArquivo &atual) {
+        TabelaArquivos::Identidade identidade{atual.inode, agora_ns(),
+                                              TabelaArquivos::dispositivo_compacto(atual.dispositivo)};
+        std::lock_guard<std::mutex> l(raiz.mutex_inodes);
+        raiz.arquivos.definir_identidade(id, identidade);
+    };
+
+    // 1. hash de todo o lote: atributo estendido válido dispensa a leitura; sem ele, com
+    //    chave configurada, hash e cifra saem da mesma leitura do arquivo, já gravando o
+    //    conteúdo cifrado no pendente
+    const ChaveCripto *chave = chave_configurada();
+    std::vector<IdentidadeArquivo> identidades(tarefas.size());
+    std::vector<size_t> ler;
+    for (size_t i = 0; i < tarefas.size(); ++i) {
+        Captura &c = capturas[i];
+        bool identificado = identificar_arquivo(tarefas[i].caminho, identidades[i]);
+        if (!tarefas[i].hash_movido.empty()) {
+            c.hash = tarefas[i].hash_movido;
+            c.tamanho = tarefas[i].tamanho;
+        } else if (identificado && hash_em_cache(tarefas[i].caminho, identidades[i], c.hash)) {
+            c.tamanho = identidades[i].tamanho;
+            contar(Contador::HASHES_EM_CACHE);
+        } else {
+            ler.push_back(i);
+        }
+    }
+
+    if (chave) {
+        for (size_t i : ler) {
+            Captura &c = capturas[i];
+            try {
+                {
+                    std::lock_guard<std::mutex> l(raiz.mutex_store);
+                    c.pendente = raiz.journal.proximo_pendente();
+                }
+                SomasEmFluxo *somas = calcular_somas(c, tamanho_cifrado(tarefas[i].tamanho));
+                c.hash = capturar_cifrado(tarefas[i].caminho, c.pendente, *chave, c.tamanho, somas);
+                contar(Contador::BYTES_HASH, c.tamanho);
+                guardar_hash(tarefas[i].caminho, identidades[i], c.hash);
+            } catch (const std::exception &e) {
+                contar(Contador::ERROS_LEITURA);
+                registrar_evento(TipoEvento::ERRO, std::string("Erro salvando versão: ") + e.what());
+                raiz.erros_passada += 1;
+                descartar(c.pendente);
+                c.pendente.clear();
+                c.somas.reset();
+            }
+        }
+    } else {
+        std::vector<ArquivoLote> leituras(ler.size());
+        for (size_t k = 0; k < ler.size(); ++k) leituras[k].origem = tarefas[ler[k]].caminho;
+        motor.executar(leituras, true, false);
+        uint64_t lidos = 0;
+        for (size_t k = 0; k < ler.size(); ++k) {
+            size_t i = ler[k];
+            lidos += leituras[k].bytes;
+            if (leituras[k].erro != 0) {
+                contar(Contador::ERROS_LEITURA);
+                registrar_evento(TipoEvento::ERRO_LEITURA, tarefas[i].caminho.native(), 0, leituras[k].erro);
+                raiz.erros_passada += 1;
+                continue;
+            }
+            capturas[i].hash = std::move(leituras[k].hash);
+            capturas[i].tamanho = tarefas[i].tamanho;
+            guardar_hash(tarefas[i].caminho, identidades[i], capturas[i].hash);
+        }
+        contar(Contador::BYTES_HASH, lidos);
+    }
+    // com a cifra, nome e índice usam o HMAC do hash (ver hash_nome_cifrado); o SHA-256
+    // do texto claro fica só no atributo de cache do arquivo de origem
+    if (chave) {
+        for (size_t i = 0; i < tarefas.size(); ++i) {
+            if (!capturas[i].hash.empty() && tarefas[i].hash_movido.empty())
+                capturas[i].hash = hash_nome_cifrado(capturas[i].hash, *chave);
+        }
+    }
+
+    // 2. separa o que já está salvo; o resto recebe um pendente e entra no lote de cópia
+    std::vector<ArquivoLote> copias;
+    std::vector<size_t> indice_copia;
+    std::vector<size_t> cifrar; // hash veio do cache, mas a versão cifrada ainda precisa ser gravada
+    for (size_t i = 0; i < tarefas.size(); ++i) {
+        const Tarefa &t = tarefas[i];
+        Captura &c = capturas[i];
+        if (c.hash.empty()) continue;
+        auto &registro = raiz.arquivos.registro(t.id);
+        uint8_t hash_bin[TabelaArquivos::TAMANHO_HASH];
+        TabelaArquivos::hash_de_hex(c.hash, hash_bin);
+
+        // só o mtime mudou: o conteúdo já está salvo
+        if (registro.mtime != INT64_MIN &&
+            std::equal(hash_bin, hash_bin + TabelaArquivos::TAMANHO_HASH, registro.hash)) {
+            descartar(c.pendente);
+            registro.mtime = t.mtime;
+            lembrar(t.id, identidades[i]);
+            continue;
+        }
+
+        c.versao = raiz.arquivos.caminho(t.id) + "_" + c.hash;
+        c.destino = raiz.config.saida / c.versao;
+        bool talvez_salva;
+        {
+            std::lock_guard<std::mutex> l(raiz.mutex_store);
+            talvez_salva = raiz.versoes_salvas.talvez_contem(c.versao);
+        }
+        // conteúdo já salvo (ex.: arquivo voltou a uma versão anterior): nada a copiar, mas
+        // a captura entra no índice para que --list e as consultas por instante a vejam
+        if (talvez_salva && fs::exists(c.destino)) {
+            descartar(c.pendente);
+            try {
+                MetadadosVersao meta;
+                meta.captura_ns = agora_ns();
+                meta.tamanho = c.tamanho;
+                meta.mtime_origem_ns = t.mtime_origem_ns;
+                meta.modo = t.modo;
+                std::lock_guard<std::mutex> l(raiz.mutex_store);
+                raiz.journal.registrar_existente(c.destino, meta);
+            } catch (const std::exception &e) {
+                registrar_evento(TipoEvento::ERRO, std::string("Erro registrando versão: ") + e.what());
+                raiz.erros_passada += 1;
+            }
+            registro.mtime = t.mtime;
+            registro.tamanho = t.tamanho;
+            lembrar(t.id, identidades[i]);
+            std::copy(hash_bin, hash_bin + TabelaArquivos::TAMANHO_HASH, registro.hash);
+            continue;
+        }
+
+        c.salvar = true;
+        if (c.pendente.empty()) {
+            {
+                std::lock_guard<std::mutex> l(raiz.mutex_store);
+                c.pendente = raiz.journal.proximo_pendente();
+            }
+            // arquivo movido: o conteúdo já está no store com o nome antigo
+            if (!t.versao_movida.empty() && ::link(t.versao_movida.c_str(), c.pendente.c_str()) == 0) {
+                c.ligada = true;
+                continue;
+            }
+            if (chave) cifrar.push_back(i);
+            else {
+                copias.push_back(
+                    {.origem = t.caminho, .destino = c.pendente, .modo = t.modo, .somas = calcular_somas(c, t.tamanho)});
+                indice_copia.push_back(i);
+            }
+        }
+    }
+
+    // 3. copia em lote as versões novas (ou cifra as que tiveram o hash vindo do cache);
+    // o hash é refeito na cópia porque o arquivo pode ter mudado desde a passada 1
+    motor.executar(copias, true, false);
+    for (size_t k = 0; k < copias.size(); ++k) {
+        Captura &c = capturas[indice_copia[k]];
+        if (copias[k].erro != 0) {
+            contar(Contador::ERROS_COPIA);
+            registrar_evento(TipoEvento::ERRO_COPIA, c.destino.native(), 0, copias[k].erro);
+            raiz.erros_passada += 1;
+            descartar(c.pendente);
+            c.salvar = false;
+        } else if (copias[k].hash != c.hash) {
+            // vale o conteúdo efetivamente copiado; o mtime novo traz o arquivo de volta
+            c.hash = std::move(copias[k].hash);
+            c.tamanho = copias[k].bytes;
+            c.versao = raiz.arquivos.caminho(tarefas[indice_copia[k]].id) + "_" + c.hash;
+            c.destino = raiz.config.saida / c.versao;
+        }
+    }
+    for (size_t i : cifrar) {
+        Captura &c = capturas[i];
+        try {
+            SomasEmFluxo *somas = calcular_somas(c, tamanho_cifrado(tarefas[i].tamanho));
+            std::string hash = hash_nome_cifrado(
+                capturar_cifrado(tarefas[i].caminho, c.pendente, *chave, c.tamanho, somas), *chave);
+            if (hash != c.hash) {
+                // o arquivo mudou depois do stat: vale o conteúdo efetivamente gravado
+                c.hash = hash;
+                c.versao = raiz.arquivos.caminho(tarefas[i].id) + "_" + hash;
+                c.destino = raiz.config.saida / c.versao;
+            }
+        } catch (const std::exception &e) {
+            contar(Contador::ERROS_COPIA);
+            registrar_evento(TipoEvento::ERRO, std::string("Erro salvando versão: ") + e.what());
+            raiz.erros_passada += 1;
+            descartar(c.pendente);
+            c.salvar = false;
+        }
+    }
+
+    // 4. registra no journal
+    for (size_t i = 0; i < tarefas.size(); ++i) {
+        const Tarefa &t = tarefas[i];
+        Captura &c = capturas[i];
+        if (!c.salvar) continue;
+        try {
+            MetadadosVersao meta;
+            meta.captura_ns = agora_ns();
+            meta.tamanho = c.tamanho;
+            meta.mtime_origem_ns = t.mtime_origem_ns;
+            meta.modo = t.modo;
+            std::error_code ec;
+            uint64_t gravados = c.ligada ? 0 : fs::file_size(c.pendente, ec); // com a cifra, maior que o original
+            // somas por bloco, já calculadas na cópia; sem elas a versão só não é conferida
+            // na leitura
+            fs::path somas = arquivo_integridade(raiz.config.saida, c.versao);
+            try {
+                if (c.ligada) {
+                    fs::path antigas = arquivo_integridade(
+                        raiz.config.saida, t.versao_movida.lexically_relative(raiz.config.saida).generic_string());
+                    fs::create_directories(somas.parent_path());
+                    fs::remove(somas, ec);
+                    fs::create_hard_link(antigas, somas, ec);
+                } else {
+                    c.somas->concluir(c.pendente, somas);
+                }
+            } catch (const std::exception &e) {
+                registrar_evento(TipoEvento::ERRO, std::string("Erro gravando somas da versão: ") + e.what());
+            }
+            {
+                std::lock_guard<std::mutex> l(raiz.mutex_store);
+                raiz.journal.adicionar(c.pendente, c.destino, meta);
+                raiz.versoes_salvas.adicionar(c.versao);
+            }
+            if (c.ligada)
+                registrar_evento(TipoEvento::VERSAO_MOVIDA, c.destino.native() + "\n" + t.versao_movida.native(),
+                                 c.tamanho);
+            else
+                registrar_evento(TipoEvento::VERSAO_SALVA, c.destino.native(), c.tamanho);
+            raiz.salvas_passada += 1;
+            contar(Contador::VERSOES_SALVAS);
+            contar(Contador::BYTES_COPIADOS, gravados);
+            observar(Histograma::LATENCIA_CAPTURA, meta.captura_ns - std::max(t.mtime_origem_ns, inicio_ns));
+            raiz.bytes_store += gravados;
+            raiz.versoes_store += 1;
+            raiz.ultima_captura_ns = meta.captura_ns;
+            auto &registro = raiz.arquivos.registro(t.id);
+            registro.mtime = t.mtime;
+            registro.tamanho = t.tamanho;
+            lembrar(t.id, identidades[i]);
+            TabelaArquivos::hash_de_hex(c.hash, registro.hash);
+        } catch (const std::exception &e) {
+            registrar_evento(TipoEvento::ERRO, std::string("Erro salvando versão: ") + e.what());
+            raiz.erros_passada += 1;
+            descartar(c.pendente);
+        }
+    }
+}
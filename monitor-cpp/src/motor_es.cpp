@@ -0,0 +1,381 @@
+#include "motor_es.h"
+#include "integridade.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <openssl/evp.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t TAMANHO_BLOCO = 256 * 1024;
+
+int io_uring_setup(unsigned entradas, io_uring_params *p) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entradas, p));
+}
+
+int io_uring_enter(int fd, unsigned submeter, unsigned minimo, unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, submeter, minimo, flags, nullptr, 0));
+}
+
+int io_uring_register(int fd, unsigned opcode, const void *arg, unsigned n) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, n));
+}
+
+std::string para_hex(const unsigned char *dados, unsigned n) {
+    static const char digitos[] = "0123456789abcdef";
+    std::string s(2 * n, '0');
+    for (unsigned i = 0; i < n; ++i) {
+        s[2 * i] = digitos[dados[i] >> 4];
+        s[2 * i + 1] = digitos[dados[i] & 0xF];
+    }
+    return s;
+}
+
+// SHA-256 incremental de um arquivo do lote
+class Resumo {
+public:
+    Resumo() : ctx(EVP_MD_CTX_new()) {}
+    ~Resumo() { EVP_MD_CTX_free(ctx); }
+    Resumo(const Resumo &) = delete;
+    Resumo &operator=(const Resumo &) = delete;
+
+    void iniciar() { EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr); }
+    void atualizar(const void *dados, size_t n) { EVP_DigestUpdate(ctx, dados, n); }
+    std::string finalizar() {
+        unsigned char hash[EVP_MAX_MD_SIZE];
+        unsigned n = 0;
+        EVP_DigestFinal_ex(ctx, hash, &n);
+        return para_hex(hash, n);
+    }
+
+private:
+    EVP_MD_CTX *ctx;
+};
+
+bool uring_desligado() {
+    const char *modo = std::getenv("MONITOR_IO");
+    return modo && std::strcmp(modo, "bloqueante") == 0;
+}
+
+} // namespace
+
+// anéis de submissão e conclusão mapeados do kernel, mais os buffers registrados
+struct MotorES::Anel {
+    int fd = -1;
+    void *mapa_sq = nullptr, *mapa_cq = nullptr;
+    size_t tamanho_sq = 0, tamanho_cq = 0;
+    io_uring_sqe *sqes = nullptr;
+    size_t tamanho_sqes = 0;
+
+    unsigned *sq_cabeca, *sq_cauda, *sq_mascara, *sq_vetor;
+    unsigned *cq_cabeca, *cq_cauda, *cq_mascara;
+    io_uring_cqe *cqes;
+    unsigned a_submeter = 0;
+
+    char *buffers = nullptr;
+    bool buffers_registrados = false;
+
+    ~Anel() {
+        if (sqes) ::munmap(sqes, tamanho_sqes);
+        if (mapa_cq && mapa_cq != mapa_sq) ::munmap(mapa_cq, tamanho_cq);
+        if (mapa_sq) ::munmap(mapa_sq, tamanho_sq);
+        if (fd >= 0) ::close(fd);
+        std::free(buffers);
+    }
+
+    // o anel de submissão nunca enche: cada slot tem no máximo uma operação em voo
+    io_uring_sqe *proxima_sqe() {
+        unsigned cauda = *sq_cauda + a_submeter;
+        unsigned indice = cauda & *sq_mascara;
+        io_uring_sqe *sqe = &sqes[indice];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_vetor[indice] = indice;
+        ++a_submeter;
+        return sqe;
+    }
+
+    void publicar() {
+        __atomic_store_n(sq_cauda, *sq_cauda + a_submeter, __ATOMIC_RELEASE);
+    }
+
+    // submete o que foi preparado e espera ao menos uma conclusão
+    void enviar_e_esperar() {
+        publicar();
+        a_submeter = 0;
+        while (true) {
+            // o que o kernel ainda não consumiu (uma chamada interrompida pode ter submetido parte)
+            unsigned n = *sq_cauda - __atomic_load_n(sq_cabeca, __ATOMIC_ACQUIRE);
+            if (io_uring_enter(fd, n, 1, IORING_ENTER_GETEVENTS) >= 0) return;
+            if (errno != EINTR) throw std::runtime_error(std::string("io_uring_enter: ") + std::strerror(errno));
+        }
+    }
+};
+
+MotorES::MotorES(unsigned profundidade) : profundidade(std::max(1u, profundidade)) {
+    if (uring_desligado()) return;
+
+    io_uring_params p{};
+    auto a = std::make_unique<Anel>();
+    a->fd = io_uring_setup(this->profundidade, &p);
+    if (a->fd < 0) return; // ENOSYS/EPERM: fica no caminho bloqueante
+
+    a->tamanho_sq = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    a->tamanho_cq = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    bool mapa_unico = p.features & IORING_FEAT_SINGLE_MMAP;
+    if (mapa_unico) a->tamanho_sq = a->tamanho_cq = std::max(a->tamanho_sq, a->tamanho_cq);
+
+    a->mapa_sq = ::mmap(nullptr, a->tamanho_sq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, a->fd,
+                        IORING_OFF_SQ_RING);
+    if (a->mapa_sq == MAP_FAILED) {
+        a->mapa_sq = nullptr;
+        return;
+    }
+    a->mapa_cq = mapa_unico ? a->mapa_sq
+                            : ::mmap(nullptr, a->tamanho_cq, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                     a->fd, IORING_OFF_CQ_RING);
+    if (a->mapa_cq == MAP_FAILED) {
+        a->mapa_cq = nullptr;
+        return;
+    }
+    a->tamanho_sqes = p.sq_entries * sizeof(io_uring_sqe);
+    void *sqes = ::mmap(nullptr, a->tamanho_sqes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, a->fd,
+                        IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) return;
+    a->sqes = static_cast<io_uring_sqe *>(sqes);
+
+    auto *sq = static_cast<char *>(a->mapa_sq);
+    auto *cq = static_cast<char *>(a->mapa_cq);
+    a->sq_cabeca = reinterpret_cast<unsigned *>(sq + p.sq_off.head);
+    a->sq_cauda = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+    a->sq_mascara = reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+    a->sq_vetor = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+    a->cq_cabeca = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+    a->cq_cauda = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+    a->cq_mascara = reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+    a->cqes = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+
+    // buffers fixos evitam mapear as páginas do usuário a cada operação; se o registro
+    // falhar (ex.: RLIMIT_MEMLOCK) usa leituras e escritas comuns
+    if (::posix_memalign(reinterpret_cast<void **>(&a->buffers), 4096, this->profundidade * TAMANHO_BLOCO) != 0)
+        return;
+    std::vector<iovec> iovs(this->profundidade);
+    for (unsigned i = 0; i < this->profundidade; ++i) iovs[i] = {a->buffers + i * TAMANHO_BLOCO, TAMANHO_BLOCO};
+    a->buffers_registrados = io_uring_register(a->fd, IORING_REGISTER_BUFFERS, iovs.data(), this->profundidade) == 0;
+
+    anel = std::move(a);
+}
+
+MotorES::~MotorES() = default;
+
+void MotorES::executar(std::vector<ArquivoLote> &lote, bool calcular_hash, bool sincronizar) {
+    if (anel) executar_uring(lote, calcular_hash, sincronizar);
+    else executar_bloqueante(lote, calcular_hash, sincronizar);
+}
+
+void MotorES::executar_bloqueante(std::vector<ArquivoLote> &lote, bool calcular_hash, bool sincronizar) {
+    std::vector<char> buffer(TAMANHO_BLOCO);
+    Resumo resumo;
+    for (auto &arquivo : lote) {
+        int in = ::open(arquivo.origem.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            arquivo.erro = errno;
+            continue;
+        }
+        int out = -1;
+        if (!arquivo.destino.empty()) {
+            out = ::open(arquivo.destino.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, arquivo.modo);
+            if (out < 0) {
+                arquivo.erro = errno;
+                ::close(in);
+                continue;
+            }
+        }
+        ::posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+        if (calcular_hash) resumo.iniciar();
+
+        while (arquivo.erro == 0) {
+            ssize_t n = ::read(in, buffer.data(), buffer.size());
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) arquivo.erro = errno;
+            if (n <= 0) break;
+            if (calcular_hash) resumo.atualizar(buffer.data(), n);
+            if (arquivo.somas) arquivo.somas->atualizar(buffer.data(), n);
+            arquivo.bytes += n;
+            for (ssize_t escrito = 0; out >= 0 && escrito < n && arquivo.erro == 0;) {
+                ssize_t w = ::write(out, buffer.data() + escrito, n - escrito);
+                if (w < 0 && errno != EINTR) arquivo.erro = errno;
+                if (w > 0) escrito += w;
+            }
+        }
+        if (out >= 0 && sincronizar && arquivo.erro == 0 && ::fdatasync(out) != 0) arquivo.erro = errno;
+        if (calcular_hash) arquivo.hash = resumo.finalizar();
+        ::close(in);
+        if (out >= 0) ::close(out);
+    }
+}
+
+void MotorES::executar_uring(std::vector<ArquivoLote> &lote, bool calcular_hash, bool sincronizar) {
+    enum class Etapa { LIVRE, ABRINDO_ORIGEM, ABRINDO_DESTINO, LENDO, ESCREVENDO, SINCRONIZANDO };
+    struct Slot {
+        Etapa etapa = Etapa::LIVRE;
+        size_t arquivo = 0;
+        int in = -1, out = -1;
+        uint64_t offset = 0;  // próxima leitura
+        size_t lidos = 0;     // bytes válidos no buffer
+        size_t escritos = 0;  // bytes do buffer já gravados
+        Resumo resumo;
+    };
+
+    Anel &a = *anel;
+    std::vector<Slot> slots(profundidade);
+    size_t proximo = 0, ativos = 0;
+
+    auto buffer = [&](unsigned s) { return a.buffers + s * TAMANHO_BLOCO; };
+
+    auto abrir = [&](unsigned s, const fs::path &caminho, int flags, Etapa etapa) {
+        io_uring_sqe *sqe = a.proxima_sqe();
+        sqe->opcode = IORING_OP_OPENAT;
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<uint64_t>(caminho.c_str());
+        sqe->open_flags = flags | O_CLOEXEC;
+        sqe->len = lote[slots[s].arquivo].modo;
+        sqe->user_data = s;
+        slots[s].etapa = etapa;
+    };
+    auto ler = [&](unsigned s) {
+        io_uring_sqe *sqe = a.proxima_sqe();
+        sqe->opcode = a.buffers_registrados ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe->fd = slots[s].in;
+        sqe->addr = reinterpret_cast<uint64_t>(buffer(s));
+        sqe->len = TAMANHO_BLOCO;
+        sqe->off = slots[s].offset;
+        sqe->buf_index = static_cast<uint16_t>(s);
+        sqe->user_data = s;
+        slots[s].etapa = Etapa::LENDO;
+    };
+    auto escrever = [&](unsigned s) {
+        Slot &slot = slots[s];
+        io_uring_sqe *sqe = a.proxima_sqe();
+        sqe->opcode = a.buffers_registrados ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+        sqe->fd = slot.out;
+        sqe->addr = reinterpret_cast<uint64_t>(buffer(s) + slot.escritos);
+        sqe->len = static_cast<uint32_t>(slot.lidos - slot.escritos);
+        sqe->off = slot.offset - slot.lidos + slot.escritos;
+        sqe->buf_index = static_cast<uint16_t>(s);
+        sqe->user_data = s;
+        slot.etapa = Etapa::ESCREVENDO;
+    };
+    auto sincronizar_destino = [&](unsigned s) {
+        io_uring_sqe *sqe = a.proxima_sqe();
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fd = slots[s].out;
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        sqe->user_data = s;
+        slots[s].etapa = Etapa::SINCRONIZANDO;
+    };
+    // fecha o arquivo atual do slot e começa o próximo do lote, se houver
+    auto iniciar = [&](unsigned s) {
+        Slot &slot = slots[s];
+        if (slot.etapa != Etapa::LIVRE) {
+            ArquivoLote &arq = lote[slot.arquivo];
+            if (calcular_hash) arq.hash = slot.resumo.finalizar();
+            if (slot.in >= 0) ::close(slot.in);
+            if (slot.out >= 0) ::close(slot.out);
+            --ativos;
+        }
+        slot.etapa = Etapa::LIVRE;
+        slot.in = slot.out = -1;
+        if (proximo == lote.size()) return;
+
+        slot.arquivo = proximo++;
+        slot.offset = slot.lidos = slot.escritos = 0;
+        if (calcular_hash) slot.resumo.iniciar();
+        ++ativos;
+        abrir(s, lote[slot.arquivo].origem, O_RDONLY, Etapa::ABRINDO_ORIGEM);
+    };
+    auto concluir = [&](unsigned s) {
+        Slot &slot = slots[s];
+        ArquivoLote &arq = lote[slot.arquivo];
+        if (slot.out >= 0 && sincronizar && arq.erro == 0) sincronizar_destino(s);
+        else iniciar(s);
+    };
+
+    for (unsigned s = 0; s < profundidade; ++s) iniciar(s);
+
+    while (ativos > 0) {
+        a.enviar_e_esperar();
+
+        unsigned cabeca = *a.cq_cabeca;
+        unsigned cauda = __atomic_load_n(a.cq_cauda, __ATOMIC_ACQUIRE);
+        for (; cabeca != cauda; ++cabeca) {
+            const io_uring_cqe &cqe = a.cqes[cabeca & *a.cq_mascara];
+            auto s = static_cast<unsigned>(cqe.user_data);
+            int res = cqe.res;
+            Slot &slot = slots[s];
+            ArquivoLote &arq = lote[slot.arquivo];
+
+            if (res == -EINTR || res == -EAGAIN) {
+                // repete a mesma operação
+                if (slot.etapa == Etapa::LENDO) ler(s);
+                else if (slot.etapa == Etapa::ESCREVENDO) escrever(s);
+                else if (slot.etapa == Etapa::SINCRONIZANDO) sincronizar_destino(s);
+                else if (slot.etapa == Etapa::ABRINDO_ORIGEM) abrir(s, arq.origem, O_RDONLY, slot.etapa);
+                else abrir(s, arq.destino, O_WRONLY | O_CREAT | O_TRUNC, slot.etapa);
+                continue;
+            }
+            if (res < 0) {
+                if (arq.erro == 0) arq.erro = -res;
+                iniciar(s);
+                continue;
+            }
+
+            switch (slot.etapa) {
+            case Etapa::ABRINDO_ORIGEM:
+                slot.in = res;
+                if (!arq.destino.empty()) abrir(s, arq.destino, O_WRONLY | O_CREAT | O_TRUNC, Etapa::ABRINDO_DESTINO);
+                else ler(s);
+                break;
+            case Etapa::ABRINDO_DESTINO:
+                slot.out = res;
+                ler(s);
+                break;
+            case Etapa::LENDO:
+                if (res == 0) {
+                    concluir(s);
+                    break;
+                }
+                if (calcular_hash) slot.resumo.atualizar(buffer(s), res);
+                if (arq.somas) arq.somas->atualizar(buffer(s), res);
+                arq.bytes += res;
+                slot.offset += res;
+                slot.lidos = res;
+                slot.escritos = 0;
+                if (slot.out >= 0) escrever(s);
+                else ler(s);
+                break;
+            case Etapa::ESCREVENDO:
+                slot.escritos += res;
+                if (slot.escritos < slot.lidos) escrever(s);
+                else ler(s);
+                break;
+            case Etapa::SINCRONIZANDO:
+                iniciar(s);
+                break;
+            case Etapa::LIVRE:
+                break;
+            }
+        }
+        __atomic_store_n(a.cq_cabeca, cabeca, __ATOMIC_RELEASE);
+    }
+}
@@ -0,0 +1,627 @@
+#include "replicacao.h"
+#include "bloom.h"
+#include "cripto.h"
+#include "indice.h"
+#include "integridade.h"
+#include "journal.h"
+#include "store.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+#include <stdexcept>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr size_t TAMANHO_LOTE = 512;
+constexpr size_t LOTES_EM_VOO = 4;
+constexpr size_t TAMANHO_DESAFIO = 32;
+
+// segredo compartilhado lido do arquivo em MONITOR_SEGREDO_REPLICACAO; vazio se não configurado
+const std::string &segredo_replicacao() {
+    static const std::string segredo = [] {
+        const char *arquivo = std::getenv("MONITOR_SEGREDO_REPLICACAO");
+        if (!arquivo || !*arquivo) return std::string();
+        std::ifstream in(arquivo, std::ios::binary);
+        if (!in) throw std::runtime_error(std::string("não foi possível ler ") + arquivo);
+        std::string conteudo((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        while (!conteudo.empty() && (conteudo.back() == '\n' || conteudo.back() == '\r')) conteudo.pop_back();
+        if (conteudo.size() < 16)
+            throw std::runtime_error(std::string("segredo de replicação inválido em ") + arquivo +
+                                     " (esperado ao menos 16 bytes)");
+        return conteudo;
+    }();
+    return segredo;
+}
+
+void resposta_desafio(const std::string &segredo, const unsigned char desafio[TAMANHO_DESAFIO],
+                      unsigned char saida[32]) {
+    unsigned int n = 32;
+    if (!HMAC(EVP_sha256(), segredo.data(), static_cast<int>(segredo.size()), desafio, TAMANHO_DESAFIO, saida, &n))
+        throw std::runtime_error("erro calculando HMAC");
+}
+
+bool endereco_local(const sockaddr *a) {
+    if (a->sa_family == AF_INET)
+        return (ntohl(reinterpret_cast<const sockaddr_in *>(a)->sin_addr.s_addr) >> 24) == 127;
+    if (a->sa_family == AF_INET6) {
+        const in6_addr &ip = reinterpret_cast<const sockaddr_in6 *>(a)->sin6_addr;
+        if (IN6_IS_ADDR_LOOPBACK(&ip)) return true;
+        return IN6_IS_ADDR_V4MAPPED(&ip) && ip.s6_addr[12] == 127;
+    }
+    return false;
+}
+
+void escrever_tudo(int fd, const void *dados, size_t n) {
+    const char *p = static_cast<const char *>(dados);
+    while (n > 0) {
+        ssize_t r = ::send(fd, p, n, MSG_NOSIGNAL);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("erro enviando: ") + std::strerror(errno));
+        }
+        p += r;
+        n -= r;
+    }
+}
+
+void ler_tudo(int fd, void *dados, size_t n) {
+    char *p = static_cast<char *>(dados);
+    while (n > 0) {
+        ssize_t r = ::recv(fd, p, n, 0);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) throw std::runtime_error("conexão encerrada");
+        p += r;
+        n -= r;
+    }
+}
+
+template <typename T>
+void anexar(std::string &buf, T valor) {
+    for (size_t i = 0; i < sizeof(T); ++i) buf.push_back(static_cast<char>((static_cast<uint64_t>(valor) >> (8 * i)) & 0xFF));
+}
+
+template <typename T>
+T ler_inteiro(int fd) {
+    unsigned char b[sizeof(T)];
+    ler_tudo(fd, b, sizeof(T));
+    uint64_t v = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) v |= static_cast<uint64_t>(b[i]) << (8 * i);
+    return static_cast<T>(v);
+}
+
+std::string ler_caminho(int fd) {
+    uint16_t len = ler_inteiro<uint16_t>(fd);
+    std::string s(len, '\0');
+    ler_tudo(fd, s.data(), len);
+    return s;
+}
+
+// rejeita caminhos absolutos ou que saiam do backup_dir
+bool caminho_seguro(const std::string &relativo) {
+    if (relativo.empty() || relativo[0] == '/') return false;
+    for (auto &parte : fs::path(relativo)) {
+        if (parte == ".." || parte == ".monitor") return false;
+    }
+    return true;
+}
+
+void enviar_arquivo(int sock, const fs::path &arquivo, const std::string &relativo, uint64_t &bytes) {
+    int fd = ::open(arquivo.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("não foi possível abrir " + arquivo.string());
+    struct stat st {};
+    ::fstat(fd, &st);
+
+    std::string cabecalho;
+    cabecalho.push_back('A');
+    anexar<uint16_t>(cabecalho, relativo.size());
+    cabecalho += relativo;
+    anexar<uint64_t>(cabecalho, st.st_size);
+    escrever_tudo(sock, cabecalho.data(), cabecalho.size());
+
+    off_t deslocamento = 0;
+    while (deslocamento < st.st_size) {
+        ssize_t r = ::sendfile(sock, fd, &deslocamento, st.st_size - deslocamento);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) {
+            ::close(fd);
+            throw std::runtime_error("erro enviando " + relativo);
+        }
+    }
+    ::close(fd);
+    bytes += st.st_size;
+}
+
+// uma captura oferecida: a versão e os metadados do seu registro no índice
+struct Oferta {
+    std::string relativo;
+    MetadadosVersao meta;
+};
+
+// As capturas do store na ordem do índice de cada arquivo, inclusive as re-capturas de
+// um conteúdo já salvo, para que o receptor reproduza o índice do emissor. Versões que
+// o índice não cita (gravadas por quem não o mantém) vão no fim do seu arquivo, pelo
+// mtime no store; registros de versões que não estão mais no store são omitidos.
+std::vector<Oferta> listar_ofertas(const fs::path &backup_dir) {
+    std::map<std::string, std::vector<std::string>> por_nome; // nome -> hashes no store
+    percorrer_versoes(backup_dir, [&](const std::string &relativo) {
+        std::string nome, hash;
+        if (separar_versao(relativo, nome, hash)) por_nome[nome].push_back(hash);
+    });
+
+    IndiceVersoes indice(backup_dir);
+    std::vector<Oferta> ofertas;
+    for (auto &[nome, hashes] : por_nome) {
+        std::unordered_set<std::string> no_store(hashes.begin(), hashes.end()), indexadas;
+        for (auto &e : indice.ler(nome, 0, indice.total(nome))) {
+            if (!no_store.count(e.hash)) continue;
+            indexadas.insert(e.hash);
+            ofertas.push_back({nome + "_" + e.hash, e.meta});
+        }
+        size_t inicio = ofertas.size();
+        for (auto &hash : hashes) {
+            if (indexadas.count(hash)) continue;
+            Oferta o{nome + "_" + hash, {}};
+            std::error_code ec;
+            auto quando = std::chrono::file_clock::to_sys(fs::last_write_time(backup_dir / o.relativo, ec));
+            o.meta.captura_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(quando.time_since_epoch()).count();
+            o.meta.tamanho = fs::file_size(backup_dir / o.relativo, ec);
+            ofertas.push_back(std::move(o));
+        }
+        std::sort(ofertas.begin() + inicio, ofertas.end(),
+                  [](const Oferta &x, const Oferta &y) { return x.meta.captura_ns < y.meta.captura_ns; });
+    }
+    return ofertas;
+}
+
+} // namespace
+
+ResultadoReplicacao replicar_para(const fs::path &backup_dir, const std::string &host, uint16_t porta) {
+    std::vector<Oferta> ofertas = listar_ofertas(backup_dir);
+
+    addrinfo dicas{}, *enderecos = nullptr;
+    dicas.ai_family = AF_UNSPEC;
+    dicas.ai_socktype = SOCK_STREAM;
+    if (::getaddrinfo(host.c_str(), std::to_string(porta).c_str(), &dicas, &enderecos) != 0)
+        throw std::runtime_error("host inválido: " + host);
+
+    int sock = -1;
+    for (addrinfo *a = enderecos; a; a = a->ai_next) {
+        sock = ::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+        if (sock < 0) continue;
+        if (::connect(sock, a->ai_addr, a->ai_addrlen) == 0) break;
+        ::close(sock);
+        sock = -1;
+    }
+    ::freeaddrinfo(enderecos);
+    if (sock < 0) throw std::runtime_error("não foi possível conectar a " + host + ":" + std::to_string(porta));
+
+    ResultadoReplicacao resultado;
+    std::deque<std::pair<size_t, size_t>> em_voo;
+    size_t proximo = 0;
+
+    auto enviar_oferta = [&]() {
+        size_t fim = std::min(ofertas.size(), proximo + TAMANHO_LOTE);
+        std::string quadro;
+        quadro.push_back('O');
+        anexar<uint32_t>(quadro, fim - proximo);
+        for (size_t i = proximo; i < fim; ++i) {
+            const MetadadosVersao &meta = ofertas[i].meta;
+            anexar<uint16_t>(quadro, ofertas[i].relativo.size());
+            quadro += ofertas[i].relativo;
+            anexar<int64_t>(quadro, meta.captura_ns);
+            anexar<uint64_t>(quadro, meta.tamanho);
+            anexar<int64_t>(quadro, meta.mtime_origem_ns);
+            anexar<uint32_t>(quadro, meta.modo);
+        }
+        escrever_tudo(sock, quadro.data(), quadro.size());
+        em_voo.emplace_back(proximo, fim);
+        resultado.oferecidas += fim - proximo;
+        proximo = fim;
+    };
+
+    try {
+        // saudação do receptor: 'D', se exige autenticação e o desafio
+        char saudacao;
+        unsigned char exige = 0, desafio[TAMANHO_DESAFIO];
+        ler_tudo(sock, &saudacao, 1);
+        ler_tudo(sock, &exige, 1);
+        ler_tudo(sock, desafio, sizeof(desafio));
+        if (saudacao != 'D') throw std::runtime_error("resposta inesperada do receptor");
+        if (exige) {
+            const std::string &segredo = segredo_replicacao();
+            if (segredo.empty()) throw std::runtime_error("o receptor exige MONITOR_SEGREDO_REPLICACAO");
+            unsigned char quadro[1 + 32] = {'R'};
+            resposta_desafio(segredo, desafio, quadro + 1);
+            escrever_tudo(sock, quadro, sizeof(quadro));
+        }
+
+        while (proximo < ofertas.size() && em_voo.size() < LOTES_EM_VOO) enviar_oferta();
+
+        while (!em_voo.empty()) {
+            auto [inicio, fim] = em_voo.front();
+            em_voo.pop_front();
+
+            char tipo;
+            ler_tudo(sock, &tipo, 1);
+            uint32_t n = ler_inteiro<uint32_t>(sock);
+            if (tipo != 'Q' || n != fim - inicio) throw std::runtime_error("resposta inesperada do receptor");
+            std::vector<unsigned char> bitmap((n + 7) / 8);
+            ler_tudo(sock, bitmap.data(), bitmap.size());
+
+            // o próximo lote já segue antes dos dados, mantendo o receptor ocupado
+            if (proximo < ofertas.size()) enviar_oferta();
+
+            for (uint32_t i = 0; i < n; ++i) {
+                if (!(bitmap[i / 8] & (1u << (i % 8)))) continue;
+                const std::string &relativo = ofertas[inicio + i].relativo;
+                enviar_arquivo(sock, backup_dir / relativo, relativo, resultado.bytes);
+                ++resultado.enviadas;
+            }
+        }
+
+        char fim = 'F';
+        escrever_tudo(sock, &fim, 1);
+        ler_tudo(sock, &fim, 1);
+    } catch (...) {
+        ::close(sock);
+        throw;
+    }
+    ::close(sock);
+    return resultado;
+}
+
+namespace {
+
+std::string para_hex(const unsigned char *dados, unsigned n) {
+    static const char digitos[] = "0123456789abcdef";
+    std::string s(2 * n, '0');
+    for (unsigned i = 0; i < n; ++i) {
+        s[2 * i] = digitos[dados[i] >> 4];
+        s[2 * i + 1] = digitos[dados[i] & 0xF];
+    }
+    return s;
+}
+
+// confere o conteúdo recebido com o hash do nome: SHA-256 do texto claro, calculado
+// durante a gravação ou, para versões cifradas, o HMAC do SHA-256 do texto decifrado
+// com a chave local (ver hash_nome_cifrado). Sem a
+// chave uma versão cifrada não pode ser conferida aqui; a autenticação GCM de cada
+// segmento ainda impede que um conteúdo forjado sem a chave seja lido como válido.
+bool conteudo_confere(const fs::path &pendente, const std::string &hash, const std::string &calculado,
+                      bool cifrado) {
+    if (!cifrado) return calculado == hash;
+    const ChaveCripto *chave = chave_configurada();
+    if (!chave) return true;
+
+    int fd = ::open(pendente.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    EVP_MD_CTX *sha = EVP_MD_CTX_new();
+    bool ok = sha && EVP_DigestInit_ex(sha, EVP_sha256(), nullptr) == 1;
+    try {
+        DecifradorVersao decifrador(fd, *chave);
+        std::vector<char> buffer(TAMANHO_SEGMENTO_CRIPTO);
+        size_t n;
+        while (ok && (n = decifrador.ler(buffer.data(), buffer.size())) > 0)
+            ok = EVP_DigestUpdate(sha, buffer.data(), n) == 1;
+    } catch (const std::exception &) {
+        ok = false;
+    }
+    unsigned char bruto[32];
+    unsigned int tamanho = 0;
+    ok = ok && EVP_DigestFinal_ex(sha, bruto, &tamanho) == 1;
+    EVP_MD_CTX_free(sha);
+    ::close(fd);
+
+    if (!ok) return false;
+    std::string claro = para_hex(bruto, tamanho);
+    // nomes gravados antes do HMAC ainda usam o SHA-256 puro
+    return hash_nome_cifrado(claro, *chave) == hash || claro == hash;
+}
+
+// somas da versão recebida: ligadas às da versão local de mesmo conteúdo (mesmo
+// inode) ou calculadas aqui, já que o emissor não envia .monitor
+void gravar_somas(const fs::path &backup_dir, const fs::path &pendente, const std::string &relativo,
+                  const std::string &mesmo_conteudo) {
+    fs::path somas = arquivo_integridade(backup_dir, relativo);
+    try {
+        std::error_code ec;
+        if (!mesmo_conteudo.empty()) {
+            fs::path antigas = arquivo_integridade(backup_dir, mesmo_conteudo);
+            fs::create_directories(somas.parent_path(), ec);
+            fs::remove(somas, ec);
+            fs::create_hard_link(antigas, somas, ec);
+            if (!ec) return;
+        }
+        gravar_integridade(pendente, somas, grupo_paridade_configurado());
+    } catch (const std::exception &e) {
+        std::cerr << "Erro gravando somas de " << relativo << ": " << e.what() << std::endl;
+    }
+}
+
+void autenticar(int sock) {
+    const std::string &segredo = segredo_replicacao();
+    unsigned char quadro[2 + TAMANHO_DESAFIO] = {'D', static_cast<unsigned char>(segredo.empty() ? 0 : 1)};
+    if (RAND_bytes(quadro + 2, TAMANHO_DESAFIO) != 1) throw std::runtime_error("erro gerando desafio");
+    escrever_tudo(sock, quadro, sizeof(quadro));
+    if (segredo.empty()) return;
+
+    char tipo;
+    unsigned char recebida[32], esperada[32];
+    ler_tudo(sock, &tipo, 1);
+    ler_tudo(sock, recebida, sizeof(recebida));
+    resposta_desafio(segredo, quadro + 2, esperada);
+    if (tipo != 'R' || CRYPTO_memcmp(recebida, esperada, sizeof(esperada)) != 0)
+        throw std::runtime_error("emissor não autenticado");
+}
+
+// captura oferecida ao receptor; entra no journal na ordem da oferta
+struct CapturaRecebida {
+    std::string relativo;
+    MetadadosVersao meta;
+    fs::path pendente;   // conteúdo a publicar; vazio: a versão já está no store, só o índice
+    bool pronta = false; // false: aguardando o conteúdo pedido
+};
+
+std::string chave_captura(const std::string &hash, int64_t captura_ns) {
+    return hash + '@' + std::to_string(captura_ns);
+}
+
+void atender(int sock, const fs::path &backup_dir, JournalVersoes &journal, FiltroBloom &filtro,
+             std::unordered_map<std::string, std::string> &por_hash) {
+    autenticar(sock);
+
+    std::vector<char> buffer(1 << 18);
+    uint64_t recebidas = 0, ligadas = 0, repetidas = 0, rejeitadas = 0;
+
+    // O índice da réplica precisa sair igual ao do emissor: as capturas vão ao journal
+    // na ordem em que foram oferecidas, e uma captura cujo conteúdo foi pedido segura
+    // as seguintes até ele chegar. As referências da deque sobrevivem a push_back e
+    // pop_front, então `aguardando` aponta direto para a captura.
+    std::deque<CapturaRecebida> fila;
+    std::unordered_map<std::string, CapturaRecebida *> aguardando; // pedidas, ainda não recebidas
+    std::unordered_set<std::string> nesta_conexao; // versões pedidas ou ligadas: as próximas capturas só indexam
+    std::unordered_set<std::string> descartadas;   // conteúdo recebido que não conferiu
+    IndiceVersoes indice(backup_dir);
+    std::string nome_atual;                        // as ofertas vêm agrupadas por arquivo
+    std::unordered_set<std::string> capturas_do_nome; // já no índice da réplica ou na fila
+
+    auto publicar_prontas = [&]() {
+        while (!fila.empty() && fila.front().pronta) {
+            CapturaRecebida &c = fila.front();
+            fs::path destino = backup_dir / c.relativo;
+            if (!c.pendente.empty()) {
+                journal.adicionar(c.pendente, destino, c.meta);
+            } else if (!descartadas.count(c.relativo)) {
+                journal.registrar_existente(destino, c.meta);
+            }
+            fila.pop_front();
+        }
+    };
+
+    while (true) {
+        char tipo;
+        ler_tudo(sock, &tipo, 1);
+
+        if (tipo == 'O') {
+            uint32_t n = ler_inteiro<uint32_t>(sock);
+            std::vector<unsigned char> bitmap((n + 7) / 8, 0);
+            for (uint32_t i = 0; i < n; ++i) {
+                CapturaRecebida c;
+                c.relativo = ler_caminho(sock);
+                c.meta.captura_ns = ler_inteiro<int64_t>(sock);
+                c.meta.tamanho = ler_inteiro<uint64_t>(sock);
+                c.meta.mtime_origem_ns = ler_inteiro<int64_t>(sock);
+                c.meta.modo = ler_inteiro<uint32_t>(sock);
+                const std::string &relativo = c.relativo;
+                std::string nome, hash;
+                if (!caminho_seguro(relativo) || !separar_versao(relativo, nome, hash)) continue;
+
+                // a mesma captura já replicada antes não se repete no índice
+                if (nome != nome_atual) {
+                    nome_atual = nome;
+                    capturas_do_nome.clear();
+                    for (auto &e : indice.ler(nome, 0, indice.total(nome)))
+                        capturas_do_nome.insert(chave_captura(e.hash, e.meta.captura_ns));
+                }
+                if (!capturas_do_nome.insert(chave_captura(hash, c.meta.captura_ns)).second) continue;
+
+                // versão que já temos: só o registro do índice (o filtro evita um stat por
+                // nome oferecido que certamente não temos)
+                if (nesta_conexao.count(relativo) ||
+                    (filtro.talvez_contem(relativo) && fs::exists(backup_dir / relativo))) {
+                    c.pronta = true;
+                    ++repetidas;
+                    fila.push_back(std::move(c));
+                    continue;
+                }
+
+                // mesmo conteúdo com outro nome: liga localmente em vez de trafegar
+                auto it = por_hash.find(hash);
+                if (it != por_hash.end()) {
+                    std::error_code ec;
+                    fs::path pendente = journal.proximo_pendente();
+                    fs::create_hard_link(backup_dir / it->second, pendente, ec);
+                    bool ligado = !ec;
+                    if (ec) fs::copy_file(backup_dir / it->second, pendente, ec);
+                    if (!ec) {
+                        gravar_somas(backup_dir, pendente, relativo, ligado ? it->second : std::string());
+                        filtro.adicionar(relativo);
+                        nesta_conexao.insert(relativo);
+                        c.pendente = pendente;
+                        c.pronta = true;
+                        fila.push_back(std::move(c));
+                        ++ligadas;
+                        continue;
+                    }
+                }
+                bitmap[i / 8] |= static_cast<unsigned char>(1u << (i % 8));
+                nesta_conexao.insert(relativo);
+                fila.push_back(std::move(c));
+                aguardando[fila.back().relativo] = &fila.back();
+            }
+            publicar_prontas();
+            std::string quadro;
+            quadro.push_back('Q');
+            anexar<uint32_t>(quadro, n);
+            quadro.append(reinterpret_cast<const char *>(bitmap.data()), bitmap.size());
+            escrever_tudo(sock, quadro.data(), quadro.size());
+        } else if (tipo == 'A') {
+            std::string relativo = ler_caminho(sock);
+            uint64_t tamanho = ler_inteiro<uint64_t>(sock);
+            // só o que foi pedido: um nome não pedido dessincronizaria o protocolo
+            auto pedido = aguardando.find(relativo);
+            if (pedido == aguardando.end()) throw std::runtime_error("versão não pedida recebida: " + relativo);
+            CapturaRecebida &captura = *pedido->second;
+            aguardando.erase(pedido);
+            captura.pronta = true;
+            std::string nome, hash;
+            separar_versao(relativo, nome, hash);
+
+            fs::path pendente = journal.proximo_pendente();
+            int fd = ::open(pendente.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0) throw std::runtime_error("não foi possível criar " + pendente.string());
+            EVP_MD_CTX *sha = EVP_MD_CTX_new();
+            bool ok = sha && EVP_DigestInit_ex(sha, EVP_sha256(), nullptr) == 1;
+            bool primeiro = true, cifrado = false;
+            while (tamanho > 0) {
+                size_t parte = std::min<uint64_t>(tamanho, buffer.size());
+                ler_tudo(sock, buffer.data(), parte);
+                if (primeiro) {
+                    cifrado = cabecalho_cifrado(reinterpret_cast<const unsigned char *>(buffer.data()), parte);
+                    primeiro = false;
+                }
+                ok = ok && EVP_DigestUpdate(sha, buffer.data(), parte) == 1;
+                if (::write(fd, buffer.data(), parte) != static_cast<ssize_t>(parte)) {
+                    EVP_MD_CTX_free(sha);
+                    ::close(fd);
+                    ::unlink(pendente.c_str());
+                    throw std::runtime_error("erro gravando " + pendente.string());
+                }
+                tamanho -= parte;
+            }
+            unsigned char bruto[32];
+            unsigned int n = 0;
+            ok = ok && EVP_DigestFinal_ex(sha, bruto, &n) == 1;
+            EVP_MD_CTX_free(sha);
+            ::close(fd);
+
+            if (!ok || !conteudo_confere(pendente, hash, para_hex(bruto, n), cifrado)) {
+                ::unlink(pendente.c_str());
+                std::cerr << "Conteúdo recebido não confere com o hash, descartado: " << relativo << std::endl;
+                descartadas.insert(relativo);
+                ++rejeitadas;
+            } else {
+                gravar_somas(backup_dir, pendente, relativo, std::string());
+                captura.pendente = pendente;
+                filtro.adicionar(relativo);
+                por_hash.emplace(hash, relativo);
+                ++recebidas;
+            }
+            publicar_prontas();
+        } else if (tipo == 'F') {
+            if (!aguardando.empty()) throw std::runtime_error("replicação encerrada sem todas as versões pedidas");
+            journal.confirmar();
+            if (filtro.cheio()) abrir_filtro_versoes(filtro, backup_dir);
+            escrever_tudo(sock, &tipo, 1);
+            std::cout << "📥 Replicação concluída: " << recebidas << " versões recebidas, " << ligadas
+                      << " reaproveitadas localmente";
+            if (repetidas) std::cout << ", " << repetidas << " capturas de versões já presentes";
+            if (rejeitadas) std::cout << ", " << rejeitadas << " descartadas";
+            std::cout << std::endl;
+            return;
+        } else {
+            throw std::runtime_error("quadro desconhecido");
+        }
+    }
+}
+
+} // namespace
+
+void receber_replicacao(const fs::path &backup_dir, uint16_t porta, const std::string &endereco) {
+    addrinfo dicas{}, *enderecos = nullptr;
+    dicas.ai_family = AF_UNSPEC;
+    dicas.ai_socktype = SOCK_STREAM;
+    dicas.ai_flags = AI_PASSIVE | AI_NUMERICHOST;
+    if (::getaddrinfo(endereco.c_str(), std::to_string(porta).c_str(), &dicas, &enderecos) != 0)
+        throw std::runtime_error("endereço inválido: " + endereco);
+    // fora do loopback qualquer um na rede poderia gravar no store
+    for (addrinfo *a = enderecos; a; a = a->ai_next) {
+        if (!endereco_local(a->ai_addr) && segredo_replicacao().empty()) {
+            ::freeaddrinfo(enderecos);
+            throw std::runtime_error("escutar em " + endereco + " exige MONITOR_SEGREDO_REPLICACAO");
+        }
+    }
+
+    preparar_store(backup_dir);
+    JournalVersoes journal(backup_dir);
+    journal.recuperar();
+
+    FiltroBloom filtro;
+    abrir_filtro_versoes(filtro, backup_dir);
+
+    std::unordered_map<std::string, std::string> por_hash;
+    percorrer_versoes(backup_dir, [&](const std::string &relativo) {
+        std::string nome, hash;
+        if (separar_versao(relativo, nome, hash)) por_hash.emplace(hash, relativo);
+    });
+
+    int servidor = -1;
+    for (addrinfo *a = enderecos; a && servidor < 0; a = a->ai_next) {
+        servidor = ::socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+        if (servidor < 0) continue;
+        int sim = 1, nao = 0;
+        ::setsockopt(servidor, SOL_SOCKET, SO_REUSEADDR, &sim, sizeof(sim));
+        if (a->ai_family == AF_INET6) ::setsockopt(servidor, IPPROTO_IPV6, IPV6_V6ONLY, &nao, sizeof(nao));
+        if (::bind(servidor, a->ai_addr, a->ai_addrlen) != 0 || ::listen(servidor, 4) != 0) {
+            ::close(servidor);
+            servidor = -1;
+        }
+    }
+    ::freeaddrinfo(enderecos);
+    if (servidor < 0)
+        throw std::runtime_error("não foi possível escutar em " + endereco + ":" + std::to_string(porta));
+
+    std::cout << "📡 Aguardando replicação em " << endereco << ":" << porta << " para " << backup_dir
+              << (segredo_replicacao().empty() ? "" : " (com autenticação)") << std::endl;
+    while (true) {
+        int sock = ::accept4(servidor, nullptr, nullptr, SOCK_CLOEXEC);
+        if (sock < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        try {
+            atender(sock, backup_dir, journal, filtro, por_hash);
+        } catch (const std::exception &e) {
+            journal.confirmar();
+            std::cerr << "Erro na replicação: " << e.what() << std::endl;
+        }
+        ::close(sock);
+    }
+    ::close(servidor);
+}
@@ -0,0 +1,96 @@
+#include "store.h"
+#include "bloom.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+void verificar_formato_store(const fs::path &backup_dir) {
+    fs::path marcador = backup_dir / ".monitor" / "formato";
+    std::ifstream in(marcador);
+    if (!in) return;
+    std::string assinatura;
+    int versao = 0;
+    if (!(in >> assinatura >> versao) || assinatura != "monitor-store" || versao < 1)
+        throw std::runtime_error("marcador de formato inválido em " + marcador.string());
+    if (versao > VERSAO_FORMATO_STORE)
+        throw std::runtime_error(backup_dir.string() + " usa o formato " + std::to_string(versao) +
+                                 " do store; esta versão do monitor entende até o " +
+                                 std::to_string(VERSAO_FORMATO_STORE));
+}
+
+void preparar_store(const fs::path &backup_dir) {
+    verificar_formato_store(backup_dir);
+    fs::path marcador = backup_dir / ".monitor" / "formato";
+    if (fs::exists(marcador)) return;
+    fs::create_directories(marcador.parent_path());
+    fs::path temporario = marcador;
+    temporario += ".novo";
+    {
+        std::ofstream out(temporario, std::ios::trunc);
+        out << "monitor-store " << VERSAO_FORMATO_STORE << "\n";
+        if (!out.flush()) throw std::runtime_error("não foi possível gravar " + marcador.string());
+    }
+    fs::rename(temporario, marcador);
+}
+
+void percorrer_versoes(const fs::path &backup_dir, const std::function<void(const std::string &relativo)> &visitar) {
+    std::error_code ec;
+    fs::recursive_directory_iterator it(backup_dir, ec), fim;
+    for (; it != fim; it.increment(ec)) {
+        if (ec) break;
+        if (it.depth() == 0 && it->path().filename() == ".monitor") {
+            it.disable_recursion_pending();
+            continue;
+        }
+        if (it->is_regular_file(ec)) {
+            visitar(fs::relative(it->path(), backup_dir, ec).generic_string());
+        }
+    }
+}
+
+bool separar_versao(const std::string &relativo, std::string &nome, std::string &hash) {
+    size_t sep = relativo.rfind('_');
+    if (sep == std::string::npos || relativo.size() - sep - 1 != 64) return false;
+    for (size_t i = sep + 1; i < relativo.size(); ++i) {
+        char c = relativo[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+    }
+    nome = relativo.substr(0, sep);
+    hash = relativo.substr(sep + 1);
+    return true;
+}
+
+fs::path encontrar_versao(const fs::path &backup_dir, const std::string &nome_base, const std::string &hash_parcial) {
+    // o arquivo pode estar em um subdiretório: as versões ficam no mesmo caminho relativo
+    fs::path pasta = (backup_dir / nome_base).parent_path();
+    std::string base = fs::path(nome_base).filename().string();
+    std::error_code ec;
+    if (!fs::is_directory(pasta, ec)) return {};
+
+    for (auto &entry : fs::directory_iterator(pasta, ec)) {
+        if (entry.is_regular_file(ec)) {
+            std::string nome = entry.path().filename().string();
+            if (nome.find(base + "_") == 0 && nome.substr(base.size() + 1).find(hash_parcial) == 0)
+                return entry.path();
+        }
+    }
+    return {};
+}
+
+void abrir_filtro_versoes(FiltroBloom &filtro, const fs::path &backup_dir) {
+    fs::path arquivo = backup_dir / ".monitor" / "versoes.bloom";
+    if (filtro.abrir(arquivo) && !filtro.cheio()) return;
+
+    std::vector<std::string> versoes;
+    percorrer_versoes(backup_dir, [&](const std::string &relativo) { versoes.push_back(relativo); });
+
+    fs::create_directories(arquivo.parent_path());
+    filtro.criar(arquivo, std::max<uint64_t>(1 << 20, versoes.size() * 2));
+    for (auto &v : versoes) filtro.adicionar(v);
+    std::cout << "🔎 Filtro de versões reconstruído com " << versoes.size() << " entradas" << std::endl;
+}
@@ -0,0 +1,201 @@
+#include "tabela_arquivos.h"
+
+#include <cstring>
+#include <stdexcept>
+
+// o registro é percorrido a cada varredura: dois por linha de cache
+static_assert(sizeof(TabelaArquivos::Registro) == 32, "registro da tabela deve ter 32 bytes");
+
+TabelaArquivos::TabelaArquivos() {
+    static_assert(sizeof(EntradaIdentidade) == 24, "identidade da tabela deve ter 24 bytes");
+    nos.push_back({NENHUM, 0, 0}); // raiz: caminho vazio
+    registros.emplace_back();
+    redimensionar(1024);
+    redimensionar_identidades(64);
+}
+
+// FNV-1a sobre o nome, misturado com o id do pai
+uint64_t TabelaArquivos::espalhar(Id pai, std::string_view nome) {
+    uint64_t h = 1469598103934665603ULL ^ (static_cast<uint64_t>(pai) * 0x9E3779B97F4A7C15ULL);
+    for (unsigned char c : nome) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h ^ (h >> 29);
+}
+
+void TabelaArquivos::redimensionar(size_t capacidade) {
+    slots.assign(capacidade, 0);
+    mascara = capacidade - 1;
+    for (Id id = 1; id < nos.size(); ++id) {
+        size_t i = espalhar(nos[id].pai, nome(id)) & mascara;
+        while (slots[i] != 0) i = (i + 1) & mascara;
+        slots[i] = id + 1;
+    }
+}
+
+std::string_view TabelaArquivos::nome(Id id) const {
+    const No &no = nos[id];
+    return std::string_view(arena.data() + no.deslocamento, no.comprimento);
+}
+
+TabelaArquivos::Id TabelaArquivos::buscar(Id pai, std::string_view n) const {
+    size_t i = espalhar(pai, n) & mascara;
+    while (slots[i] != 0) {
+        Id id = slots[i] - 1;
+        if (nos[id].pai == pai && nome(id) == n) return id;
+        i = (i + 1) & mascara;
+    }
+    return NENHUM;
+}
+
+TabelaArquivos::Id TabelaArquivos::internar(Id pai, std::string_view n) {
+    Id existente = buscar(pai, n);
+    if (existente != NENHUM) return existente;
+
+    if (n.size() > UINT16_MAX || arena.size() + n.size() > UINT32_MAX || nos.size() >= NENHUM - 1)
+        throw std::length_error("tabela de arquivos cheia");
+
+    // carga máxima de 3/4
+    if ((nos.size() + 1) * 4 > slots.size() * 3) redimensionar(slots.size() * 2);
+
+    Id id = static_cast<Id>(nos.size());
+    nos.push_back({pai, static_cast<uint32_t>(arena.size()), static_cast<uint16_t>(n.size())});
+    registros.emplace_back();
+    arena.insert(arena.end(), n.begin(), n.end());
+
+    size_t i = espalhar(pai, n) & mascara;
+    while (slots[i] != 0) i = (i + 1) & mascara;
+    slots[i] = id + 1;
+    return id;
+}
+
+std::string TabelaArquivos::caminho(Id id) const {
+    std::vector<Id> cadeia;
+    size_t total = 0;
+    for (Id atual = id; atual != RAIZ && atual != NENHUM; atual = nos[atual].pai) {
+        cadeia.push_back(atual);
+        total += nos[atual].comprimento + 1;
+    }
+
+    std::string resultado;
+    resultado.reserve(total);
+    for (auto it = cadeia.rbegin(); it != cadeia.rend(); ++it) {
+        if (!resultado.empty()) resultado += '/';
+        resultado += nome(*it);
+    }
+    return resultado;
+}
+
+size_t TabelaArquivos::bytes_usados() const {
+    return nos.capacity() * sizeof(No) + registros.capacity() * sizeof(Registro) +
+           arena.capacity() + slots.capacity() * sizeof(Id) + identidades.capacity() * sizeof(EntradaIdentidade) +
+           (slots_por_id.capacity() + slots_por_inode.capacity()) * sizeof(uint32_t);
+}
+
+// Identidades: dois índices de endereçamento aberto sobre o mesmo vetor denso. A remoção
+// desloca para trás os slots seguintes da sequência (sem marcas de apagado) e traz a
+// última entrada para a posição liberada.
+
+static size_t espalhar_chave(uint64_t chave) {
+    chave *= 0x9E3779B97F4A7C15ULL;
+    return static_cast<size_t>(chave ^ (chave >> 32));
+}
+
+size_t TabelaArquivos::slot_do_id(Id id) const {
+    size_t i = espalhar_chave(id) & mascara_identidades;
+    while (slots_por_id[i] != 0 && identidades[slots_por_id[i] - 1].id != id) i = (i + 1) & mascara_identidades;
+    return i;
+}
+
+size_t TabelaArquivos::slot_do_inode(uint64_t inode) const {
+    size_t i = espalhar_chave(inode) & mascara_identidades;
+    while (slots_por_inode[i] != 0 && identidades[slots_por_inode[i] - 1].inode != inode)
+        i = (i + 1) & mascara_identidades;
+    return i;
+}
+
+void TabelaArquivos::redimensionar_identidades(size_t capacidade) {
+    slots_por_id.assign(capacidade, 0);
+    slots_por_inode.assign(capacidade, 0);
+    mascara_identidades = capacidade - 1;
+    for (uint32_t p = 0; p < identidades.size(); ++p) {
+        slots_por_id[slot_do_id(identidades[p].id)] = p + 1;
+        // inode repetido (hard link): fica a captura mais recente, como nas inserções
+        uint32_t &slot = slots_por_inode[slot_do_inode(identidades[p].inode)];
+        if (slot == 0 || identidades[slot - 1].capturado_ns <= identidades[p].capturado_ns) slot = p + 1;
+    }
+}
+
+void TabelaArquivos::remover_slot(std::vector<uint32_t> &slots_identidade, size_t i, bool por_inode) {
+    size_t j = i;
+    for (;;) {
+        slots_identidade[i] = 0;
+        for (;;) {
+            j = (j + 1) & mascara_identidades;
+            if (slots_identidade[j] == 0) return;
+            const auto &e = identidades[slots_identidade[j] - 1];
+            size_t ideal = espalhar_chave(por_inode ? e.inode : e.id) & mascara_identidades;
+            // fica onde está se a posição ideal estiver entre o buraco (exclusive) e ele
+            bool entre = i <= j ? (i < ideal && ideal <= j) : (i < ideal || ideal <= j);
+            if (!entre) break;
+        }
+        slots_identidade[i] = slots_identidade[j];
+        i = j;
+    }
+}
+
+void TabelaArquivos::remover_identidade(uint32_t posicao) {
+    const EntradaIdentidade removida = identidades[posicao];
+    remover_slot(slots_por_id, slot_do_id(removida.id), false);
+    size_t i = slot_do_inode(removida.inode);
+    if (slots_por_inode[i] == posicao + 1) remover_slot(slots_por_inode, i, true);
+
+    uint32_t ultima = static_cast<uint32_t>(identidades.size() - 1);
+    if (posicao != ultima) {
+        const EntradaIdentidade &movida = identidades[ultima];
+        slots_por_id[slot_do_id(movida.id)] = posicao + 1;
+        size_t j = slot_do_inode(movida.inode);
+        if (slots_por_inode[j] == ultima + 1) slots_por_inode[j] = posicao + 1;
+        identidades[posicao] = movida;
+    }
+    identidades.pop_back();
+}
+
+TabelaArquivos::Identidade TabelaArquivos::identidade(Id id) const {
+    uint32_t posicao = slots_por_id[slot_do_id(id)];
+    if (posicao == 0) return {};
+    const EntradaIdentidade &e = identidades[posicao - 1];
+    return {e.inode, e.capturado_ns, e.dispositivo};
+}
+
+void TabelaArquivos::definir_identidade(Id id, const Identidade &identidade) {
+    uint32_t posicao = slots_por_id[slot_do_id(id)];
+    if (posicao != 0) remover_identidade(posicao - 1);
+    if (identidade.inode == 0) return;
+
+    // carga máxima de 3/4, como na busca por nome
+    if ((identidades.size() + 1) * 4 > slots_por_id.size() * 3) redimensionar_identidades(slots_por_id.size() * 2);
+    posicao = static_cast<uint32_t>(identidades.size());
+    identidades.push_back({identidade.inode, identidade.capturado_ns, identidade.dispositivo, id});
+    slots_por_id[slot_do_id(id)] = posicao + 1;
+    slots_por_inode[slot_do_inode(identidade.inode)] = posicao + 1;
+}
+
+TabelaArquivos::Id TabelaArquivos::capturado_com_inode(uint64_t inode) const {
+    if (inode == 0) return NENHUM;
+    uint32_t posicao = slots_por_inode[slot_do_inode(inode)];
+    return posicao == 0 ? NENHUM : identidades[posicao - 1].id;
+}
+
+void TabelaArquivos::hash_de_hex(std::string_view hex, uint8_t saida[TAMANHO_HASH]) {
+    auto valor = [](char c) -> uint8_t {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return 0;
+    };
+    std::memset(saida, 0, TAMANHO_HASH);
+    for (size_t i = 0; i < TAMANHO_HASH && 2 * i + 1 < hex.size(); ++i)
+        saida[i] = static_cast<uint8_t>(valor(hex[2 * i]) << 4 | valor(hex[2 * i + 1]));
+}
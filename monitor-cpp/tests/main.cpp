@@ -0,0 +1,59 @@
+#include "teste.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace fs = std::filesystem;
+
+std::vector<CasoTeste> &casos_teste() {
+    static std::vector<CasoTeste> casos;
+    return casos;
+}
+
+PastaTemporaria::PastaTemporaria() {
+    std::string modelo = (fs::temp_directory_path() / "monitor-teste-XXXXXX").string();
+    if (!::mkdtemp(modelo.data())) throw std::runtime_error("não foi possível criar a pasta temporária");
+    pasta = modelo;
+}
+
+PastaTemporaria::~PastaTemporaria() {
+    std::error_code ec;
+    fs::remove_all(pasta, ec);
+}
+
+void gravar_arquivo(const fs::path &caminho, const std::string &conteudo) {
+    fs::create_directories(caminho.parent_path());
+    std::ofstream out(caminho, std::ios::binary | std::ios::trunc);
+    out.write(conteudo.data(), static_cast<std::streamsize>(conteudo.size()));
+    if (!out) throw std::runtime_error("erro gravando " + caminho.string());
+}
+
+std::string ler_arquivo(const fs::path &caminho) {
+    std::ifstream in(caminho, std::ios::binary);
+    if (!in) throw std::runtime_error("erro lendo " + caminho.string());
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+int main(int argc, char **argv) {
+    std::string grupo = argc > 1 ? argv[1] : "";
+    size_t executados = 0, falhas = 0;
+    for (auto &caso : casos_teste()) {
+        if (!grupo.empty() && grupo != caso.grupo) continue;
+        ++executados;
+        try {
+            caso.executar();
+            std::cout << "✅ " << caso.grupo << "." << caso.nome << std::endl;
+        } catch (const std::exception &e) {
+            ++falhas;
+            std::cout << "❌ " << caso.grupo << "." << caso.nome << ": " << e.what() << std::endl;
+        }
+    }
+    if (executados == 0) {
+        std::cerr << "Nenhum teste no grupo " << grupo << std::endl;
+        return 1;
+    }
+    std::cout << executados - falhas << "/" << executados << " testes passaram" << std::endl;
+    return falhas == 0 ? 0 : 1;
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <filesystem>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Testes do monitor_core, sem dependências externas.
+// Cada TESTE(grupo, nome) se registra ao carregar o executável; `monitor_testes <grupo>`
+// roda só os testes do grupo (um add_test por grupo no CMakeLists.txt) e sem argumentos
+// roda todos. Uma verificação que falha lança FalhaTeste, que encerra só aquele teste.
+
+struct CasoTeste {
+    const char *grupo;
+    const char *nome;
+    void (*executar)();
+};
+
+std::vector<CasoTeste> &casos_teste();
+
+struct RegistroTeste {
+    RegistroTeste(const char *grupo, const char *nome, void (*executar)()) {
+        casos_teste().push_back({grupo, nome, executar});
+    }
+};
+
+class FalhaTeste : public std::runtime_error {
+public:
+    FalhaTeste(const char *arquivo, int linha, const std::string &mensagem)
+        : std::runtime_error(std::string(arquivo) + ":" + std::to_string(linha) + ": " + mensagem) {}
+};
+
+#define TESTE(grupo, nome)                                                                \
+    static void teste_##grupo##_##nome();                                                 \
+    static RegistroTeste registro_##grupo##_##nome(#grupo, #nome, teste_##grupo##_##nome); \
+    static void teste_##grupo##_##nome()
+
+#define VERIFICAR(condicao)                                                  \
+    do {                                                                     \
+        if (!(condicao)) throw FalhaTeste(__FILE__, __LINE__, #condicao);   \
+    } while (0)
+
+#define VERIFICAR_IGUAL(obtido, esperado)                                                      \
+    do {                                                                                       \
+        const auto &obtido_ = (obtido);                                                        \
+        const auto &esperado_ = (esperado);                                                    \
+        if (!(obtido_ == esperado_)) {                                                         \
+            std::ostringstream texto_;                                                         \
+            texto_ << #obtido << " == " << #esperado << " (obtido " << obtido_ << ", esperado " \
+                   << esperado_ << ")";                                                        \
+            throw FalhaTeste(__FILE__, __LINE__, texto_.str());                                \
+        }                                                                                      \
+    } while (0)
+
+// lança FalhaTeste se `expressao` não lançar uma exceção do tipo `tipo`
+#define VERIFICAR_LANCA(expressao, tipo)                                                  \
+    do {                                                                                  \
+        bool lancou_ = false;                                                             \
+        try {                                                                             \
+            expressao;                                                                    \
+        } catch (const tipo &) {                                                          \
+            lancou_ = true;                                                               \
+        }                                                                                 \
+        if (!lancou_) throw FalhaTeste(__FILE__, __LINE__, #expressao " não lançou " #tipo); \
+    } while (0)
+
+// pasta vazia em /tmp, removida com tudo o que houver dentro no fim do escopo
+class PastaTemporaria {
+public:
+    PastaTemporaria();
+    ~PastaTemporaria();
+
+    PastaTemporaria(const PastaTemporaria &) = delete;
+    PastaTemporaria &operator=(const PastaTemporaria &) = delete;
+
+    const std::filesystem::path &caminho() const { return pasta; }
+    std::filesystem::path operator/(const std::filesystem::path &relativo) const { return pasta / relativo; }
+
+private:
+    std::filesystem::path pasta;
+};
+
+// utilitários de arquivo para montar cenários
+void gravar_arquivo(const std::filesystem::path &caminho, const std::string &conteudo);
+std::string ler_arquivo(const std::filesystem::path &caminho);
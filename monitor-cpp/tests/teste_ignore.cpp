@@ -0,0 +1,150 @@
+#include "ignore.h"
+#include "teste.h"
+
+#include <fnmatch.h>
+#include <random>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// avalia o caminho componente a componente, como a varredura: ignorado se algum
+// componente for; `diretorio` vale para o último
+bool ignorado(const FiltroIgnorar &filtro, std::string_view caminho, bool diretorio = false) {
+    FiltroIgnorar::Estado estado = filtro.estado_inicial(), filho;
+    for (size_t inicio = 0; inicio < caminho.size();) {
+        size_t fim = std::min(caminho.find('/', inicio), caminho.size());
+        bool ultimo = fim == caminho.size();
+        if (filtro.ignorado(estado, caminho.substr(inicio, fim - inicio), !ultimo || diretorio, filho)) return true;
+        std::swap(estado, filho);
+        inicio = fim + 1;
+    }
+    return false;
+}
+
+FiltroIgnorar filtro_de(std::initializer_list<const char *> linhas) {
+    FiltroIgnorar filtro;
+    for (const char *linha : linhas) filtro.adicionar_regra(linha);
+    return filtro;
+}
+
+} // namespace
+
+TESTE(ignore, negacao_vence_quando_vem_depois) {
+    FiltroIgnorar filtro = filtro_de({"# comentário", "*.log", "!importante.log"});
+    VERIFICAR(ignorado(filtro, "a.log"));
+    VERIFICAR(ignorado(filtro, "sub/b.log"));
+    VERIFICAR(!ignorado(filtro, "importante.log"));
+    VERIFICAR(!ignorado(filtro, "sub/importante.log"));
+    VERIFICAR(!ignorado(filtro, "a.txt"));
+
+    // a última regra que casa decide, como no git
+    FiltroIgnorar invertido = filtro_de({"!importante.log", "*.log"});
+    VERIFICAR(ignorado(invertido, "importante.log"));
+
+    // "\!" é um nome que começa com '!', não uma negação
+    FiltroIgnorar escapado = filtro_de({"\\!urgente"});
+    VERIFICAR(ignorado(escapado, "!urgente"));
+    VERIFICAR(!ignorado(escapado, "urgente"));
+}
+
+TESTE(ignore, duplo_asterisco) {
+    FiltroIgnorar filtro = filtro_de({"a/**/b", "**/cache", "logs/**"});
+    VERIFICAR(ignorado(filtro, "a/b"));
+    VERIFICAR(ignorado(filtro, "a/x/b"));
+    VERIFICAR(ignorado(filtro, "a/x/y/b"));
+    VERIFICAR(!ignorado(filtro, "x/a/b"));
+
+    VERIFICAR(ignorado(filtro, "cache", true));
+    VERIFICAR(ignorado(filtro, "x/y/cache/arquivo"));
+
+    // "logs/**" é o conteúdo da pasta, não a pasta
+    VERIFICAR(!ignorado(filtro, "logs", true));
+    VERIFICAR(ignorado(filtro, "logs/hoje.txt"));
+    VERIFICAR(ignorado(filtro, "logs/2024/janeiro.txt"));
+}
+
+TESTE(ignore, regras_ancoradas) {
+    FiltroIgnorar filtro = filtro_de({"/build", "doc/tmp", "segredo"});
+    VERIFICAR(ignorado(filtro, "build", true));
+    VERIFICAR(!ignorado(filtro, "src/build", true));
+    VERIFICAR(ignorado(filtro, "doc/tmp/rascunho.txt"));
+    VERIFICAR(!ignorado(filtro, "x/doc/tmp/rascunho.txt"));
+    // sem barra a regra vale em qualquer nível
+    VERIFICAR(ignorado(filtro, "segredo"));
+    VERIFICAR(ignorado(filtro, "a/b/segredo"));
+}
+
+TESTE(ignore, regras_so_de_diretorio) {
+    FiltroIgnorar filtro = filtro_de({"saida/", "*.d/"});
+    VERIFICAR(ignorado(filtro, "saida", true));
+    VERIFICAR(ignorado(filtro, "saida/a.txt"));
+    VERIFICAR(!ignorado(filtro, "saida"));
+    VERIFICAR(ignorado(filtro, "x/conf.d/a"));
+    VERIFICAR(!ignorado(filtro, "x/conf.d"));
+}
+
+TESTE(ignore, arquivos_aninhados) {
+    PastaTemporaria pasta;
+    gravar_arquivo(pasta / ".monitorignore", "*.tmp\nignorada/\n");
+    gravar_arquivo(pasta / "sub" / ".monitorignore", "!manter.tmp\n/local\n*.bak\n");
+    gravar_arquivo(pasta / "ignorada" / ".monitorignore", "!*.tmp\n");
+    gravar_arquivo(pasta / "a[1]" / ".monitorignore", "x\n");
+    fs::create_directories(pasta / "sub" / "fundo");
+
+    FiltroIgnorar filtro;
+    // o da pasta ignorada não é lido
+    VERIFICAR_IGUAL(filtro.carregar_arvore(pasta.caminho()), size_t{3});
+
+    VERIFICAR(ignorado(filtro, "x.tmp"));
+    VERIFICAR(ignorado(filtro, "manter.tmp"));
+    VERIFICAR(!ignorado(filtro, "sub/manter.tmp"));
+    VERIFICAR(!ignorado(filtro, "sub/fundo/manter.tmp"));
+    VERIFICAR(ignorado(filtro, "sub/outro.tmp"));
+
+    // "/local" é relativo à pasta do arquivo de regras
+    VERIFICAR(ignorado(filtro, "sub/local", true));
+    VERIFICAR(!ignorado(filtro, "local", true));
+    VERIFICAR(!ignorado(filtro, "sub/fundo/local", true));
+
+    VERIFICAR(ignorado(filtro, "sub/fundo/a.bak"));
+    VERIFICAR(!ignorado(filtro, "a.bak"));
+    VERIFICAR(ignorado(filtro, "ignorada/a.tmp"));
+
+    // o caminho da pasta entra literalmente, mesmo com metacaracteres no nome
+    VERIFICAR(ignorado(filtro, "a[1]/x"));
+    VERIFICAR(!ignorado(filtro, "a1/x"));
+}
+
+TESTE(ignore, globs_agrupados_casam_como_fnmatch) {
+    // padrões que não são literal, "*sufixo" nem "prefixo*": vão para os grupos de globs
+    std::vector<std::string> padroes = {"log-?-*.t?t", "*.sw[a-p]", "[Mm]akefile", "?core*", "*~*",
+                                        "a\\*b*c",     "*[[:digit:]]", "x[!y]z*w",   "[ab"};
+    std::mt19937 aleatorio(7);
+    const std::string alfabeto = "abxyzw*?[]!-.~0123456789Mmt\\";
+    for (int i = 0; i < 300; ++i) {
+        std::string p;
+        for (int n = 1 + aleatorio() % 7; n > 0; --n) p += alfabeto[aleatorio() % alfabeto.size()];
+        if (p[0] == '!') p.insert(0, "a"); // seria uma negação
+        padroes.push_back(p);
+    }
+
+    FiltroIgnorar filtro;
+    for (auto &p : padroes) filtro.adicionar_regra(p);
+
+    std::vector<std::string> nomes = {"log-1-a.txt", "log-1-a.tzt", "x.swp", "x.swq", "Makefile", "makefile",
+                                      "score.c",     "core",        "a~",    "a*bxc", "abbc",    "f9",
+                                      "xaz-w",       "xyzw",        "[ab",   "[abc"};
+    const std::string letras = "abxyzw-.~019Mt*?[]\\";
+    for (int i = 0; i < 3000; ++i) {
+        std::string n;
+        for (int k = 1 + aleatorio() % 8; k > 0; --k) n += letras[aleatorio() % letras.size()];
+        nomes.push_back(n);
+    }
+
+    for (auto &nome : nomes) {
+        bool esperado = false;
+        for (auto &p : padroes) esperado = esperado || fnmatch(p.c_str(), nome.c_str(), 0) == 0;
+        if (ignorado(filtro, nome) != esperado) throw FalhaTeste(__FILE__, __LINE__, "divergência em " + nome);
+    }
+}
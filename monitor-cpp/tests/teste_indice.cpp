@@ -0,0 +1,154 @@
+#include "indice.h"
+#include "journal.h"
+#include "teste.h"
+
+#include <chrono>
+#include <cstring>
+#include <sys/stat.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string hash_de(char c) {
+    return std::string(64, c);
+}
+
+MetadadosVersao meta(int64_t captura_ns, uint32_t modo = 0644) {
+    return {.captura_ns = captura_ns,
+            .tamanho = 100 + static_cast<uint64_t>(captura_ns),
+            .mtime_origem_ns = -captura_ns,
+            .modo = modo};
+}
+
+} // namespace
+
+TESTE(indice, ida_e_volta_em_ordem_de_captura) {
+    PastaTemporaria pasta;
+    IndiceVersoes indice(pasta.caminho());
+    indice.adicionar("dir/a.txt", hash_de('1'), meta(10, 0600));
+    indice.adicionar("dir/a.txt", hash_de('2'), meta(20, 0755));
+    indice.adicionar("dir/a.txt", hash_de('3'), meta(30));
+
+    VERIFICAR_IGUAL(indice.total("dir/a.txt"), 3u);
+    auto entradas = indice.ler("dir/a.txt", 1, 10);
+    VERIFICAR_IGUAL(entradas.size(), 2u);
+    VERIFICAR_IGUAL(entradas[0].hash, hash_de('2'));
+    VERIFICAR_IGUAL(entradas[0].meta.captura_ns, 20);
+    VERIFICAR_IGUAL(entradas[0].meta.tamanho, 120u);
+    VERIFICAR_IGUAL(entradas[0].meta.mtime_origem_ns, -20);
+    VERIFICAR_IGUAL(entradas[0].meta.modo, 0755u);
+    VERIFICAR_IGUAL(entradas[1].hash, hash_de('3'));
+    VERIFICAR(indice.ler("dir/a.txt", 3, 10).empty());
+
+    // cabeçalho de 16 bytes e registros de 64
+    VERIFICAR_IGUAL(fs::file_size(pasta / ".monitor/indice/dir/a.txt.idx"), 16u + 3 * 64);
+}
+
+TESTE(indice, repeticao_do_ultimo_registro_e_ignorada) {
+    PastaTemporaria pasta;
+    IndiceVersoes indice(pasta.caminho());
+    indice.adicionar("a.txt", hash_de('1'), meta(10));
+    indice.adicionar("a.txt", hash_de('1'), meta(10)); // replay do journal
+    VERIFICAR_IGUAL(indice.total("a.txt"), 1u);
+    indice.adicionar("a.txt", hash_de('1'), meta(11)); // nova captura do mesmo conteúdo
+    VERIFICAR_IGUAL(indice.total("a.txt"), 2u);
+}
+
+TESTE(indice, buscar_devolve_a_captura_mais_recente) {
+    PastaTemporaria pasta;
+    IndiceVersoes indice(pasta.caminho());
+    // o mesmo conteúdo volta depois de muitas versões: a busca precisa ir até o fim
+    indice.adicionar("a.txt", hash_de('a'), meta(1));
+    for (int64_t i = 2; i < 5000; ++i) indice.adicionar("a.txt", hash_de(i % 2 ? 'b' : 'c'), meta(i));
+    indice.adicionar("a.txt", hash_de('a'), meta(5000, 0700));
+
+    IndiceVersoes::Entrada entrada;
+    VERIFICAR(indice.buscar("a.txt", hash_de('a'), entrada));
+    VERIFICAR_IGUAL(entrada.meta.captura_ns, 5000);
+    VERIFICAR_IGUAL(entrada.meta.modo, 0700u);
+    VERIFICAR(!indice.buscar("a.txt", hash_de('d'), entrada));
+    VERIFICAR(!indice.buscar("outro.txt", hash_de('a'), entrada));
+}
+
+TESTE(indice, versao_1_e_lida_e_convertida) {
+    PastaTemporaria pasta;
+    struct RegistroV1 {
+        int64_t captura_ns;
+        uint64_t tamanho;
+        int64_t mtime_origem_ns;
+        uint8_t hash[32];
+    } antigo{7, 8, 9, {}};
+    std::memset(antigo.hash, 0xab, sizeof(antigo.hash));
+    std::string conteudo("MONIDX01\x01\0\0\0\x38\0\0\0", 16);
+    conteudo.append(reinterpret_cast<const char *>(&antigo), sizeof(antigo));
+    gravar_arquivo(pasta / ".monitor/indice/a.txt.idx", conteudo);
+
+    IndiceVersoes indice(pasta.caminho());
+    VERIFICAR_IGUAL(indice.total("a.txt"), 1u);
+    auto entradas = indice.ler("a.txt", 0, 1);
+    std::string abab;
+    for (int i = 0; i < 32; ++i) abab += "ab";
+    VERIFICAR_IGUAL(entradas.at(0).hash, abab);
+    VERIFICAR_IGUAL(entradas[0].meta.captura_ns, 7);
+    VERIFICAR_IGUAL(entradas[0].meta.modo, 0u);
+
+    // a primeira gravação converte o arquivo para a versão 2
+    indice.adicionar("a.txt", hash_de('1'), meta(20, 0640));
+    VERIFICAR_IGUAL(fs::file_size(pasta / ".monitor/indice/a.txt.idx"), 16u + 2 * 64);
+    entradas = indice.ler("a.txt", 0, 2);
+    VERIFICAR_IGUAL(entradas.size(), 2u);
+    VERIFICAR_IGUAL(entradas[0].meta.tamanho, 8u);
+    VERIFICAR_IGUAL(entradas[1].meta.modo, 0640u);
+}
+
+TESTE(indice, reconstruido_a_partir_do_store) {
+    PastaTemporaria pasta;
+    fs::path antiga = pasta / ("dir/a.txt_" + hash_de('1'));
+    fs::path nova = pasta / ("dir/a.txt_" + hash_de('2'));
+    gravar_arquivo(antiga, "um");
+    gravar_arquivo(nova, "dois!");
+    ::chmod(nova.c_str(), 0750);
+    fs::last_write_time(antiga, fs::file_time_type::clock::now() - std::chrono::hours(1));
+
+    IndiceVersoes indice(pasta.caminho());
+    VERIFICAR_IGUAL(indice.total("dir/a.txt"), 2u);
+    auto entradas = indice.ler("dir/a.txt", 0, 2);
+    VERIFICAR_IGUAL(entradas[0].hash, hash_de('1'));
+    VERIFICAR_IGUAL(entradas[1].hash, hash_de('2'));
+    VERIFICAR_IGUAL(entradas[1].meta.tamanho, 5u);
+    VERIFICAR_IGUAL(entradas[1].meta.modo, 0750u);
+}
+
+TESTE(indice, captura_de_conteudo_ja_salvo_entra_no_indice) {
+    PastaTemporaria pasta;
+    fs::path versao = pasta / ("a.txt_" + hash_de('1'));
+    gravar_arquivo(versao, "conteudo");
+    {
+        JournalVersoes journal(pasta.caminho());
+        journal.registrar_existente(versao, meta(42));
+    }
+    IndiceVersoes::Entrada entrada;
+    VERIFICAR(IndiceVersoes(pasta.caminho()).buscar("a.txt", hash_de('1'), entrada));
+    VERIFICAR_IGUAL(entrada.meta.captura_ns, 42);
+    VERIFICAR_IGUAL(ler_arquivo(versao), std::string("conteudo"));
+}
+
+TESTE(indice, instantes) {
+    int64_t ns = 0;
+    VERIFICAR(interpretar_instante("1700000000", ns));
+    VERIFICAR_IGUAL(ns, 1700000000LL * 1000000000);
+    // segundos que não cabem em nanossegundos de 64 bits
+    VERIFICAR(!interpretar_instante("9223372037", ns));
+    VERIFICAR(!interpretar_instante("99999999999999999999999", ns));
+    VERIFICAR(!interpretar_instante("2024-13-40 99:00:00", ns));
+    VERIFICAR(!interpretar_instante("", ns));
+
+    VERIFICAR(interpretar_instante("2024-05-06 07:08:09", ns));
+    VERIFICAR_IGUAL(formatar_instante(ns), std::string("2024-05-06 07:08:09"));
+    int64_t com_t = 0;
+    VERIFICAR(interpretar_instante("2024-05-06T07:08:09", com_t));
+    VERIFICAR_IGUAL(com_t, ns);
+    VERIFICAR(interpretar_instante("2024-05-06", ns));
+    VERIFICAR_IGUAL(formatar_instante(ns), std::string("2024-05-06 00:00:00"));
+}
@@ -0,0 +1,229 @@
+#include "integridade.h"
+#include "store.h"
+#include "teste.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string HASH = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+
+// conteúdo em que cada bloco é diferente dos outros, para a paridade não se anular
+std::string conteudo_de_blocos(size_t blocos, size_t sobra) {
+    std::string conteudo(blocos * TAMANHO_BLOCO_INTEGRIDADE + sobra, '\0');
+    for (size_t i = 0; i < conteudo.size(); ++i) conteudo[i] = static_cast<char>('a' + (i * 7 + i / 4096) % 26);
+    return conteudo;
+}
+
+// grava a versão no store com as suas somas
+fs::path salvar_versao(const fs::path &store, const std::string &conteudo, uint32_t grupo) {
+    preparar_store(store);
+    std::string relativo = "dir/a.bin_" + HASH;
+    fs::path versao = store / relativo;
+    gravar_arquivo(versao, conteudo);
+    gravar_integridade(versao, arquivo_integridade(store, relativo), grupo);
+    return versao;
+}
+
+// troca um byte no bloco `bloco` sem mudar o mtime, como um erro do disco faria
+void corromper(const fs::path &versao, size_t bloco) {
+    auto mtime = fs::last_write_time(versao);
+    std::string conteudo = ler_arquivo(versao);
+    conteudo[bloco * TAMANHO_BLOCO_INTEGRIDADE + 100] ^= 0x5a;
+    gravar_arquivo(versao, conteudo);
+    fs::last_write_time(versao, mtime);
+}
+
+std::string mensagem_de(const fs::path &versao, bool reparar) {
+    try {
+        conferir_versao(versao, reparar);
+    } catch (const std::runtime_error &e) {
+        return e.what();
+    }
+    return "";
+}
+
+// lê a versão inteira pelo LeitorConferido em pedaços de `parte` bytes
+std::string ler_conferido(const fs::path &versao, size_t parte, size_t *reconstruidos = nullptr) {
+    int fd = ::open(versao.c_str(), O_RDONLY | O_CLOEXEC);
+    VERIFICAR(fd >= 0);
+    std::string conteudo;
+    try {
+        LeitorConferido leitor(fd, versao);
+        VERIFICAR(leitor.com_somas());
+        std::vector<char> buffer(parte);
+        while (size_t n = leitor.ler(buffer.data(), buffer.size(), conteudo.size())) conteudo.append(buffer.data(), n);
+        if (reconstruidos) *reconstruidos = leitor.reconstruidos();
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    return conteudo;
+}
+
+} // namespace
+
+TESTE(integridade, crc32c_valor_de_referencia) {
+    const std::string texto = "123456789";
+    VERIFICAR_IGUAL(crc32c(0, texto.data(), texto.size()), 0xE3069283u);
+    // continuar de um trecho anterior dá o mesmo que calcular tudo de uma vez
+    std::string longo = conteudo_de_blocos(0, 10007);
+    uint32_t parcial = crc32c(crc32c(0, longo.data(), 3), longo.data() + 3, longo.size() - 3);
+    VERIFICAR_IGUAL(parcial, crc32c(0, longo.data(), longo.size()));
+}
+
+TESTE(integridade, versao_intacta_e_conferida) {
+    PastaTemporaria pasta;
+    fs::path versao = salvar_versao(pasta.caminho(), conteudo_de_blocos(5, 123), 4);
+    VerificacaoVersao v = conferir_versao(versao);
+    VERIFICAR(v.com_somas);
+    VERIFICAR_IGUAL(v.blocos, 6u);
+    VERIFICAR_IGUAL(v.reparados, 0u);
+    conferir_tamanho(versao);
+}
+
+TESTE(integridade, bloco_corrompido_so_e_reparado_com_reparar) {
+    PastaTemporaria pasta;
+    std::string original = conteudo_de_blocos(5, 123);
+    fs::path versao = salvar_versao(pasta.caminho(), original, 4);
+    corromper(versao, 1);
+
+    // a leitura comum aponta o --verify e não escreve na versão
+    std::string mensagem = mensagem_de(versao, false);
+    VERIFICAR(mensagem.find("--verify") != std::string::npos);
+    VERIFICAR(ler_arquivo(versao) != original);
+
+    VerificacaoVersao v = conferir_versao(versao, true);
+    VERIFICAR_IGUAL(v.reparados, 1u);
+    VERIFICAR(ler_arquivo(versao) == original);
+    // o reparo preserva o mtime: as somas continuam valendo
+    VERIFICAR(conferir_versao(versao).com_somas);
+}
+
+TESTE(integridade, bloco_do_ultimo_grupo_incompleto_e_reparado) {
+    PastaTemporaria pasta;
+    std::string original = conteudo_de_blocos(5, 123);
+    fs::path versao = salvar_versao(pasta.caminho(), original, 4);
+    corromper(versao, 5);
+    VERIFICAR_IGUAL(conferir_versao(versao, true).reparados, 1u);
+    VERIFICAR(ler_arquivo(versao) == original);
+}
+
+TESTE(integridade, dois_blocos_no_mesmo_grupo_nao_tem_reparo) {
+    PastaTemporaria pasta;
+    fs::path versao = salvar_versao(pasta.caminho(), conteudo_de_blocos(5, 123), 4);
+    corromper(versao, 0);
+    corromper(versao, 2);
+    std::string mensagem = mensagem_de(versao, true);
+    VERIFICAR(mensagem.find("sem reparo") != std::string::npos);
+    VERIFICAR(mensagem.find("0-65535") != std::string::npos);
+    VERIFICAR(mensagem.find("131072-196607") != std::string::npos);
+}
+
+TESTE(integridade, sem_paridade_o_dano_so_e_apontado) {
+    PastaTemporaria pasta;
+    fs::path versao = salvar_versao(pasta.caminho(), conteudo_de_blocos(3, 0), 0);
+    corromper(versao, 2);
+    VERIFICAR(mensagem_de(versao, true).find("sem reparo") != std::string::npos);
+}
+
+TESTE(integridade, somas_de_outro_arquivo_sao_ignoradas) {
+    PastaTemporaria pasta;
+    fs::path versao = salvar_versao(pasta.caminho(), conteudo_de_blocos(2, 0), 4);
+    // regravada com outro mtime: as somas descrevem outro arquivo
+    gravar_arquivo(versao, "outro conteudo");
+    fs::last_write_time(versao, fs::last_write_time(versao) + std::chrono::seconds(5));
+    VERIFICAR(!conferir_versao(versao).com_somas);
+    conferir_tamanho(versao);
+}
+
+TESTE(integridade, versao_truncada_falha_no_tamanho) {
+    PastaTemporaria pasta;
+    fs::path versao = salvar_versao(pasta.caminho(), conteudo_de_blocos(2, 10), 0);
+    auto mtime = fs::last_write_time(versao);
+    fs::resize_file(versao, TAMANHO_BLOCO_INTEGRIDADE);
+    fs::last_write_time(versao, mtime);
+    VERIFICAR_LANCA(conferir_tamanho(versao), std::runtime_error);
+    VERIFICAR_LANCA(conferir_versao(versao), std::runtime_error);
+}
+
+TESTE(integridade, verify_percorre_o_store) {
+    PastaTemporaria pasta;
+    std::string original = conteudo_de_blocos(3, 1);
+    fs::path versao = salvar_versao(pasta.caminho(), original, 2);
+    corromper(versao, 1);
+    ResultadoConferencia r = conferir_store(pasta.caminho());
+    VERIFICAR_IGUAL(r.conferidas, 1u);
+    VERIFICAR_IGUAL(r.reparadas, 1u);
+    VERIFICAR_IGUAL(r.corrompidas, 0u);
+    VERIFICAR(ler_arquivo(versao) == original);
+}
+
+TESTE(integridade, leitura_conferida_em_qualquer_tamanho_de_pedaco) {
+    PastaTemporaria pasta;
+    std::string original = conteudo_de_blocos(4, 777);
+    fs::path versao = salvar_versao(pasta.caminho(), original, 0);
+    for (size_t parte : {1000, 65536, 65537, 3 * 65536, 1 << 20}) VERIFICAR(ler_conferido(versao, parte) == original);
+}
+
+TESTE(integridade, leitura_reconstroi_em_memoria_sem_tocar_no_store) {
+    PastaTemporaria pasta;
+    std::string original = conteudo_de_blocos(5, 123);
+    fs::path versao = salvar_versao(pasta.caminho(), original, 4);
+    corromper(versao, 2);
+    std::string corrompido = ler_arquivo(versao);
+
+    for (size_t parte : {4096, 1 << 20}) {
+        size_t reconstruidos = 0;
+        VERIFICAR(ler_conferido(versao, parte, &reconstruidos) == original);
+        VERIFICAR_IGUAL(reconstruidos, 1u);
+    }
+    VERIFICAR(ler_arquivo(versao) == corrompido);
+}
+
+TESTE(integridade, leitura_falha_no_bloco_sem_reparo) {
+    PastaTemporaria pasta;
+    fs::path versao = salvar_versao(pasta.caminho(), conteudo_de_blocos(3, 0), 0);
+    corromper(versao, 1);
+    try {
+        ler_conferido(versao, 1 << 20);
+    } catch (const std::runtime_error &e) {
+        VERIFICAR(std::string(e.what()).find("65536-131071") != std::string::npos);
+        return;
+    }
+    throw FalhaTeste(__FILE__, __LINE__, "a leitura do bloco corrompido não falhou");
+}
+
+TESTE(integridade, somas_em_fluxo_iguais_as_da_releitura) {
+    PastaTemporaria pasta;
+    std::string conteudo = conteudo_de_blocos(9, 321);
+    fs::path versao = salvar_versao(pasta.caminho(), conteudo, 4);
+    std::string relidas = ler_arquivo(arquivo_integridade(pasta.caminho(), "dir/a.bin_" + HASH));
+
+    // a previsão de tamanho errada para menos ou para mais só desloca a paridade
+    for (uint64_t previsto : {uint64_t(0), uint64_t(conteudo.size()), uint64_t(20) * TAMANHO_BLOCO_INTEGRIDADE}) {
+        SomasEmFluxo fluxo(pasta / "pendente.crc", 4, previsto);
+        for (size_t pos = 0; pos < conteudo.size(); pos += 50000)
+            fluxo.atualizar(conteudo.data() + pos, std::min<size_t>(50000, conteudo.size() - pos));
+        fluxo.concluir(versao, pasta / "fluxo.crc");
+        VERIFICAR(ler_arquivo(pasta / "fluxo.crc") == relidas);
+        VERIFICAR(!fs::exists(pasta / "pendente.crc"));
+    }
+}
+
+TESTE(integridade, somas_em_fluxo_recusam_outro_conteudo) {
+    PastaTemporaria pasta;
+    fs::path versao = salvar_versao(pasta.caminho(), conteudo_de_blocos(2, 0), 2);
+    {
+        SomasEmFluxo fluxo(pasta / "pendente.crc", 2, 0);
+        std::string parte = conteudo_de_blocos(2, 0).substr(0, 1000);
+        fluxo.atualizar(parte.data(), parte.size());
+        VERIFICAR_LANCA(fluxo.concluir(versao, pasta / "fluxo.crc"), std::runtime_error);
+    }
+    VERIFICAR(!fs::exists(pasta / "pendente.crc"));
+    VERIFICAR(!fs::exists(pasta / "fluxo.crc"));
+}
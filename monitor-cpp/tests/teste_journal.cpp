@@ -0,0 +1,102 @@
+#include "indice.h"
+#include "journal.h"
+#include "teste.h"
+
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string HASH = "0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef";
+
+MetadadosVersao meta_exemplo() {
+    return {.captura_ns = 1700000000123456789, .tamanho = 8, .mtime_origem_ns = 1690000000987654321, .modo = 0640};
+}
+
+// publica uma versão pelo journal e devolve os registros gravados antes do commit
+std::string publicar(const fs::path &store, const fs::path &destino, const std::string &conteudo) {
+    JournalVersoes journal(store, 100);
+    fs::path pendente = journal.proximo_pendente();
+    gravar_arquivo(pendente, conteudo);
+    journal.adicionar(pendente, destino, meta_exemplo());
+    return ler_arquivo(store / ".monitor" / "journal");
+}
+
+} // namespace
+
+TESTE(journal, caminhos_com_tab_quebra_e_barra) {
+    PastaTemporaria pasta;
+    const std::string nome = "pasta\tcom tab/linha\nquebrada\\e barra.txt";
+    fs::path destino = pasta / (nome + "_" + HASH);
+
+    std::string registros = publicar(pasta.caminho(), destino, "conteudo");
+    VERIFICAR_IGUAL(ler_arquivo(destino), std::string("conteudo"));
+    // um registro por linha, sem tab ou quebra de linha vindos do nome
+    VERIFICAR_IGUAL(std::count(registros.begin(), registros.end(), '\n'), 1);
+    VERIFICAR_IGUAL(std::count(registros.begin(), registros.end(), '\t'), 5);
+
+    // queda depois do commit e antes do rename: a recuperação publica no mesmo nome
+    fs::path pendente = pasta / ".monitor" / "pendentes" / "0";
+    fs::rename(destino, pendente);
+    gravar_arquivo(pasta / ".monitor" / "journal", registros + "C\n");
+    {
+        JournalVersoes journal(pasta.caminho());
+        journal.recuperar();
+    }
+    VERIFICAR(!fs::exists(pendente));
+    VERIFICAR_IGUAL(ler_arquivo(destino), std::string("conteudo"));
+
+    IndiceVersoes indice(pasta.caminho());
+    IndiceVersoes::Entrada entrada;
+    VERIFICAR(indice.buscar(nome, HASH, entrada));
+    VERIFICAR_IGUAL(entrada.meta.captura_ns, meta_exemplo().captura_ns);
+    VERIFICAR_IGUAL(entrada.meta.tamanho, meta_exemplo().tamanho);
+    VERIFICAR_IGUAL(entrada.meta.mtime_origem_ns, meta_exemplo().mtime_origem_ns);
+    VERIFICAR_IGUAL(entrada.meta.modo, 0640u);
+}
+
+TESTE(journal, grupo_sem_commit_e_descartado) {
+    PastaTemporaria pasta;
+    fs::path pendente = pasta / ".monitor" / "pendentes" / "0";
+    gravar_arquivo(pendente, "parcial");
+    gravar_arquivo(pasta / ".monitor" / "journal", "P .monitor/pendentes/0\ta.txt_" + HASH + "\t1\t7\t1\t644\n");
+    {
+        JournalVersoes journal(pasta.caminho());
+        journal.recuperar();
+    }
+    VERIFICAR(!fs::exists(pendente));
+    VERIFICAR(!fs::exists(pasta / ("a.txt_" + HASH)));
+    VERIFICAR_IGUAL(fs::file_size(pasta / ".monitor" / "journal"), 0u);
+}
+
+TESTE(journal, registro_invalido_e_ignorado) {
+    PastaTemporaria pasta;
+    gravar_arquivo(pasta / ".monitor" / "pendentes" / "0", "x");
+    gravar_arquivo(pasta / ".monitor" / "pendentes" / "1", "y");
+    // escape desconhecido e registro cortado no meio, ambos com commit
+    gravar_arquivo(pasta / ".monitor" / "journal", "P .monitor/pendentes/0\ta\\q.txt_" + HASH + "\t1\t1\t1\t644\n" +
+                                                       "P .monitor/pendentes/1\tb.txt_" + HASH + "\t1\t1\nC\n");
+    {
+        JournalVersoes journal(pasta.caminho());
+        journal.recuperar();
+    }
+    VERIFICAR(!fs::exists(pasta / ("a\\q.txt_" + HASH)));
+    VERIFICAR(!fs::exists(pasta / ("b.txt_" + HASH)));
+    VERIFICAR(fs::is_empty(pasta / ".monitor" / "pendentes"));
+}
+
+TESTE(journal, registro_sem_modo_de_versao_anterior) {
+    PastaTemporaria pasta;
+    gravar_arquivo(pasta / ".monitor" / "pendentes" / "0", "antigo");
+    gravar_arquivo(pasta / ".monitor" / "journal", "P .monitor/pendentes/0\tdir/a.txt_" + HASH + "\t5\t6\t7\nC\n");
+    {
+        JournalVersoes journal(pasta.caminho());
+        journal.recuperar();
+    }
+    VERIFICAR_IGUAL(ler_arquivo(pasta / ("dir/a.txt_" + HASH)), std::string("antigo"));
+    IndiceVersoes::Entrada entrada;
+    VERIFICAR(IndiceVersoes(pasta.caminho()).buscar("dir/a.txt", HASH, entrada));
+    VERIFICAR_IGUAL(entrada.meta.captura_ns, 5);
+    VERIFICAR_IGUAL(entrada.meta.modo, 0u);
+}
@@ -0,0 +1,232 @@
+#include "exportar.h"
+#include "indice.h"
+#include "integridade.h"
+#include "motor_es.h"
+#include "store.h"
+#include "teste.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <thread>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr int64_t SEGUNDO = 1000000000;
+
+struct EntradaTar {
+    std::string caminho;
+    unsigned modo = 0;
+    int64_t mtime = 0;
+    std::string conteudo;
+};
+
+uint64_t ler_octal(const char *campo, size_t largura) {
+    uint64_t valor = 0;
+    for (size_t i = 0; i < largura && campo[i] >= '0' && campo[i] <= '7'; ++i) valor = valor * 8 + (campo[i] - '0');
+    return valor;
+}
+
+// lê o tar inteiro conferindo a soma de cada cabeçalho e aplicando os registros pax
+std::map<std::string, EntradaTar> ler_tar(const std::string &tar) {
+    VERIFICAR_IGUAL(tar.size() % (20 * 512), 0u);
+    std::map<std::string, EntradaTar> entradas;
+    std::map<std::string, std::string> pax;
+    size_t pos = 0;
+    while (true) {
+        VERIFICAR(pos + 512 <= tar.size());
+        const char *h = tar.data() + pos;
+        if (std::all_of(h, h + 512, [](char c) { return c == 0; })) break;
+        pos += 512;
+
+        unsigned soma = 0;
+        for (size_t i = 0; i < 512; ++i) soma += (i >= 148 && i < 156) ? ' ' : static_cast<unsigned char>(h[i]);
+        VERIFICAR_IGUAL(ler_octal(h + 148, 8), soma);
+        VERIFICAR_IGUAL(std::string(h + 257, 5), std::string("ustar"));
+
+        uint64_t tamanho = ler_octal(h + 124, 12);
+        if (pax.count("size")) tamanho = std::stoull(pax["size"]);
+        VERIFICAR(pos + tamanho <= tar.size());
+        std::string corpo = tar.substr(pos, tamanho);
+        pos += (tamanho + 511) / 512 * 512;
+
+        if (h[156] == 'x') {
+            pax.clear();
+            for (size_t p = 0; p < corpo.size();) {
+                size_t espaco = corpo.find(' ', p);
+                size_t comprimento = std::stoul(corpo.substr(p, espaco - p));
+                std::string registro = corpo.substr(espaco + 1, comprimento - (espaco - p) - 2);
+                VERIFICAR_IGUAL(corpo[p + comprimento - 1], '\n');
+                size_t igual = registro.find('=');
+                pax[registro.substr(0, igual)] = registro.substr(igual + 1);
+                p += comprimento;
+            }
+            continue;
+        }
+        VERIFICAR_IGUAL(h[156], '0');
+        std::string nome(h, strnlen(h, 100)), prefixo(h + 345, strnlen(h + 345, 155));
+        EntradaTar e;
+        e.caminho = pax.count("path") ? pax["path"] : prefixo.empty() ? nome : prefixo + "/" + nome;
+        e.modo = static_cast<unsigned>(ler_octal(h + 100, 8));
+        e.mtime = static_cast<int64_t>(ler_octal(h + 136, 12));
+        e.conteudo = std::move(corpo);
+        entradas[e.caminho] = std::move(e);
+        pax.clear();
+    }
+    return entradas;
+}
+
+// grava a versão no store e no índice; o hash só precisa ser único no teste
+void salvar_versao(const fs::path &store, const std::string &nome, char hash, const std::string &conteudo,
+                   int64_t captura_s, unsigned modo) {
+    std::string h(64, hash);
+    gravar_arquivo(store / (nome + "_" + h), conteudo);
+    IndiceVersoes(store).adicionar(nome, h,
+                                   {.captura_ns = captura_s * SEGUNDO,
+                                    .tamanho = conteudo.size(),
+                                    .mtime_origem_ns = (captura_s - 1) * SEGUNDO,
+                                    .modo = modo});
+}
+
+std::string exportar_para_arquivo(const fs::path &store, int64_t instante_ns, const fs::path &arquivo) {
+    int fd = ::open(arquivo.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    VERIFICAR(fd >= 0);
+    exportar_tar(store, instante_ns, fd);
+    ::close(fd);
+    return ler_arquivo(arquivo);
+}
+
+} // namespace
+
+TESTE(tar, nomes_curtos_com_prefixo_e_pax) {
+    PastaTemporaria pasta;
+    fs::path store = pasta / "store";
+    std::string com_prefixo = std::string(120, 'd') + "/" + std::string(90, 'n') + ".txt";
+    std::string longo = std::string(200, 'p') + "/" + std::string(150, 'q') + ".txt";
+    salvar_versao(store, "a.txt", '1', "conteudo curto", 100, 0640);
+    salvar_versao(store, com_prefixo, '2', std::string(1000, 'x'), 100, 0755);
+    salvar_versao(store, longo, '3', "", 100, 0600);
+
+    auto entradas = ler_tar(exportar_para_arquivo(store, 200 * SEGUNDO, pasta / "saida.tar"));
+    VERIFICAR_IGUAL(entradas.size(), 3u);
+    VERIFICAR_IGUAL(entradas.at("a.txt").conteudo, std::string("conteudo curto"));
+    VERIFICAR_IGUAL(entradas.at("a.txt").modo, 0640u);
+    VERIFICAR_IGUAL(entradas.at("a.txt").mtime, 99);
+    VERIFICAR_IGUAL(entradas.at(com_prefixo).conteudo, std::string(1000, 'x'));
+    VERIFICAR_IGUAL(entradas.at(com_prefixo).modo, 0755u);
+    VERIFICAR(entradas.at(longo).conteudo.empty());
+}
+
+TESTE(tar, versao_vigente_no_instante) {
+    PastaTemporaria pasta;
+    fs::path store = pasta / "store";
+    salvar_versao(store, "a.txt", '1', "primeira", 10, 0644);
+    salvar_versao(store, "a.txt", '2', "segunda", 20, 0644);
+    salvar_versao(store, "b.txt", '3', "depois", 30, 0644);
+
+    auto antes = ler_tar(exportar_para_arquivo(store, 15 * SEGUNDO, pasta / "antes.tar"));
+    VERIFICAR_IGUAL(antes.size(), 1u);
+    VERIFICAR_IGUAL(antes.at("a.txt").conteudo, std::string("primeira"));
+
+    auto depois = ler_tar(exportar_para_arquivo(store, 30 * SEGUNDO, pasta / "depois.tar"));
+    VERIFICAR_IGUAL(depois.size(), 2u);
+    VERIFICAR_IGUAL(depois.at("a.txt").conteudo, std::string("segunda"));
+    VERIFICAR_IGUAL(depois.at("b.txt").conteudo, std::string("depois"));
+}
+
+TESTE(tar, pipe_e_arquivo_geram_os_mesmos_bytes) {
+    PastaTemporaria pasta;
+    fs::path store = pasta / "store";
+    salvar_versao(store, "grande.bin", '1', std::string(300000, 'g'), 10, 0644);
+    salvar_versao(store, "dir/pequeno.txt", '2', "p", 10, 0644);
+    std::string por_arquivo = exportar_para_arquivo(store, 10 * SEGUNDO, pasta / "saida.tar");
+
+    // pipe: o corpo das versões vai por splice
+    int fds[2];
+    VERIFICAR(::pipe(fds) == 0);
+    std::string por_pipe;
+    std::thread leitor([&]() {
+        char buffer[65536];
+        ssize_t n;
+        while ((n = ::read(fds[0], buffer, sizeof(buffer))) > 0) por_pipe.append(buffer, n);
+    });
+    try {
+        exportar_tar(store, 10 * SEGUNDO, fds[1]);
+    } catch (...) {
+        ::close(fds[1]);
+        leitor.join();
+        ::close(fds[0]);
+        throw;
+    }
+    ::close(fds[1]);
+    leitor.join();
+    ::close(fds[0]);
+
+    VERIFICAR(por_pipe == por_arquivo);
+    VERIFICAR_IGUAL(ler_tar(por_pipe).at("grande.bin").conteudo.size(), 300000u);
+}
+
+namespace {
+
+std::string conteudo_de_blocos() {
+    std::string conteudo;
+    for (size_t i = 0; i < 4 * TAMANHO_BLOCO_INTEGRIDADE; ++i) conteudo += static_cast<char>('a' + i % 23 + i / 65536);
+    return conteudo;
+}
+
+std::string sha256_de(const fs::path &arquivo) {
+    std::vector<ArquivoLote> lote{{.origem = arquivo}};
+    MotorES().executar(lote, true, false);
+    return lote[0].hash;
+}
+
+// grava com o SHA-256 real no nome (a restauração confere) e somas com `grupo`, e troca
+// um bit no segundo bloco preservando o mtime, como um erro do disco
+void salvar_corrompida(const fs::path &store, const std::string &nome, uint32_t grupo) {
+    preparar_store(store);
+    gravar_arquivo(store / "tmp", conteudo_de_blocos());
+    std::string hash = sha256_de(store / "tmp");
+    fs::remove(store / "tmp");
+    std::string relativo = nome + "_" + hash;
+    fs::path versao = store / relativo;
+    gravar_arquivo(versao, conteudo_de_blocos());
+    IndiceVersoes(store).adicionar(nome, hash, {.captura_ns = 10 * SEGUNDO, .tamanho = 0, .modo = 0644});
+    gravar_integridade(versao, arquivo_integridade(store, relativo), grupo);
+    auto mtime = fs::last_write_time(versao);
+    std::string conteudo = ler_arquivo(versao);
+    conteudo[TAMANHO_BLOCO_INTEGRIDADE + 5] ^= 1;
+    gravar_arquivo(versao, conteudo);
+    fs::last_write_time(versao, mtime);
+}
+
+} // namespace
+
+TESTE(tar, bloco_corrompido_e_reconstruido_ou_recusado) {
+    PastaTemporaria pasta;
+    fs::path store = pasta / "store";
+    salvar_corrompida(store, "com_paridade.bin", 4);
+    salvar_corrompida(store, "sem_paridade.bin", 0);
+    VERIFICAR_LANCA(exportar_para_arquivo(store, 10 * SEGUNDO, pasta / "saida.tar"), std::runtime_error);
+
+    for (auto &v : fs::directory_iterator(store))
+        if (v.path().filename().string().rfind("sem_paridade.bin_", 0) == 0) fs::remove(v.path());
+    auto entradas = ler_tar(exportar_para_arquivo(store, 10 * SEGUNDO, pasta / "saida.tar"));
+    VERIFICAR(entradas.at("com_paridade.bin").conteudo == conteudo_de_blocos());
+}
+
+TESTE(tar, restauracao_reconstroi_pela_paridade) {
+    PastaTemporaria pasta;
+    fs::path store = pasta / "store";
+    salvar_corrompida(store, "com_paridade.bin", 4);
+    salvar_corrompida(store, "sem_paridade.bin", 0);
+
+    ResultadoRestauracao r = restaurar_arvore(store, 10 * SEGUNDO, pasta / "destino", 1);
+    VERIFICAR_IGUAL(r.arquivos, 1u);
+    VERIFICAR_IGUAL(r.erros, 1u);
+    VERIFICAR(ler_arquivo(pasta / "destino" / "com_paridade.bin") == conteudo_de_blocos());
+    VERIFICAR(!fs::exists(pasta / "destino" / "sem_paridade.bin"));
+}
@@ -1,95 +1,338 @@
 package main
 
 import (
+	"bytes"
 	"crypto/sha256"
+	"encoding/binary"
 	"encoding/hex"
 	"fmt"
 	"io"
 	"io/fs"
 	"os"
 	"path/filepath"
+	"sort"
+	"strconv"
 	"strings"
 	"time"
 )
 
 var inputDir = "/workspaces/design-patterns/monitor-golang/input"
 var backupDir = "/workspaces/design-patterns/monitor-golang/output"
+var intervalo = 2 * time.Second
 
-// calcular hash SHA-256
-func calcularHash(caminho string) (string, error) {
-	file, err := os.Open(caminho)
+// versão do formato do store (ver monitor-cpp/FORMATO_STORE.md)
+const versaoFormatoStore = 1
+
+// estado de um arquivo na última captura
+type estadoArquivo struct {
+	modTime time.Time
+	tamanho int64
+}
+
+// MONITOR_INPUT, MONITOR_OUTPUT e MONITOR_INTERVALO_MS substituem os padrões
+func lerAmbiente() {
+	if v := os.Getenv("MONITOR_INPUT"); v != "" {
+		inputDir = v
+	}
+	if v := os.Getenv("MONITOR_OUTPUT"); v != "" {
+		backupDir = v
+	}
+	if v := os.Getenv("MONITOR_INTERVALO_MS"); v != "" {
+		if ms, err := strconv.Atoi(v); err == nil && ms > 0 {
+			intervalo = time.Duration(ms) * time.Millisecond
+		}
+	}
+}
+
+// cria .monitor e grava o marcador de formato; recusa stores de formato mais novo
+func prepararStore() error {
+	meta := filepath.Join(backupDir, ".monitor")
+	if err := os.MkdirAll(filepath.Join(meta, "pendentes"), os.ModePerm); err != nil {
+		return err
+	}
+	marcador := filepath.Join(meta, "formato")
+	conteudo, err := os.ReadFile(marcador)
+	if os.IsNotExist(err) {
+		temporario := marcador + ".novo"
+		if err := os.WriteFile(temporario, []byte(fmt.Sprintf("monitor-store %d\n", versaoFormatoStore)), 0644); err != nil {
+			return err
+		}
+		return os.Rename(temporario, marcador)
+	}
 	if err != nil {
-		return "", err
+		return err
+	}
+	var versao int
+	if _, err := fmt.Sscanf(string(conteudo), "monitor-store %d", &versao); err != nil || versao < 1 {
+		return fmt.Errorf("marcador de formato inválido em %s", marcador)
+	}
+	if versao > versaoFormatoStore {
+		return fmt.Errorf("%s usa o formato %d do store; este monitor entende até o %d", backupDir, versao, versaoFormatoStore)
+	}
+	return nil
+}
+
+// copia o arquivo para um pendente calculando o SHA-256 na mesma leitura e publica a
+// versão com rename; devolve o destino, o hash, os bytes copiados e se a versão é nova
+func salvarVersao(caminho, relativo string, modo fs.FileMode) (string, string, int64, bool, error) {
+	input, err := os.Open(caminho)
+	if err != nil {
+		return "", "", 0, false, err
+	}
+	defer input.Close()
+
+	pendente, err := os.CreateTemp(filepath.Join(backupDir, ".monitor", "pendentes"), "go-*")
+	if err != nil {
+		return "", "", 0, false, err
+	}
+	descartar := func() {
+		pendente.Close()
+		os.Remove(pendente.Name())
 	}
-	defer file.Close()
 
 	hash := sha256.New()
-	if _, err := io.Copy(hash, file); err != nil {
-		return "", err
+	tamanho, err := io.Copy(io.MultiWriter(pendente, hash), input)
+	if err != nil {
+		descartar()
+		return "", "", 0, false, err
+	}
+	hashHex := hex.EncodeToString(hash.Sum(nil))
+	destino := filepath.Join(backupDir, filepath.FromSlash(relativo)+"_"+hashHex)
+	if _, err := os.Stat(destino); err == nil {
+		descartar() // conteúdo já salvo
+		return destino, hashHex, tamanho, false, nil
+	}
+
+	// a versão só aparece com o nome definitivo depois de completa e durável
+	if err := pendente.Chmod(modo.Perm()); err != nil {
+		descartar()
+		return "", "", 0, false, err
 	}
-	return hex.EncodeToString(hash.Sum(nil)), nil
+	if err := pendente.Sync(); err != nil {
+		descartar()
+		return "", "", 0, false, err
+	}
+	pendente.Close()
+	if err := os.MkdirAll(filepath.Dir(destino), os.ModePerm); err != nil {
+		os.Remove(pendente.Name())
+		return "", "", 0, false, err
+	}
+	if err := os.Rename(pendente.Name(), destino); err != nil {
+		os.Remove(pendente.Name())
+		return "", "", 0, false, err
+	}
+	return destino, hashHex, tamanho, true, nil
 }
 
-// restaurar arquivo por hash
-func restaurarPorHash(nomeBase, hashParcial string) {
-	found := false
+// índice de versões, versão 2 (ver monitor-cpp/FORMATO_STORE.md)
+const (
+	tamanhoCabecalhoIndice  = 16
+	tamanhoRegistroIndice   = 64
+	tamanhoRegistroIndiceV1 = 56
+)
 
-	err := filepath.WalkDir(backupDir, func(path string, d fs.DirEntry, err error) error {
-		if err != nil {
-			return err
+// registro do índice; os da versão 1 não têm o modo
+type registroIndice struct {
+	capturaNs     int64
+	tamanho       uint64
+	mtimeOrigemNs int64
+	hash          [32]byte
+	modo          uint32
+}
+
+func (r registroIndice) codificar() []byte {
+	b := make([]byte, tamanhoRegistroIndice)
+	binary.LittleEndian.PutUint64(b[0:], uint64(r.capturaNs))
+	binary.LittleEndian.PutUint64(b[8:], r.tamanho)
+	binary.LittleEndian.PutUint64(b[16:], uint64(r.mtimeOrigemNs))
+	copy(b[24:56], r.hash[:])
+	binary.LittleEndian.PutUint32(b[56:], r.modo)
+	return b
+}
+
+func cabecalhoIndice() []byte {
+	b := make([]byte, tamanhoCabecalhoIndice)
+	copy(b, "MONIDX01")
+	binary.LittleEndian.PutUint32(b[8:], 2)
+	binary.LittleEndian.PutUint32(b[12:], tamanhoRegistroIndice)
+	return b
+}
+
+// grava o índice inteiro com outro nome e renomeia
+func gravarIndice(arquivo string, registros []registroIndice) error {
+	conteudo := cabecalhoIndice()
+	for _, r := range registros {
+		conteudo = append(conteudo, r.codificar()...)
+	}
+	if err := os.MkdirAll(filepath.Dir(arquivo), os.ModePerm); err != nil {
+		return err
+	}
+	temporario := arquivo + ".novo"
+	if err := os.WriteFile(temporario, conteudo, 0644); err != nil {
+		return err
+	}
+	return os.Rename(temporario, arquivo)
+}
+
+// registros de um índice existente; converte os da versão 1 (modo desconhecido)
+func lerIndice(conteudo []byte) ([]registroIndice, bool) {
+	if len(conteudo) < tamanhoCabecalhoIndice || string(conteudo[:8]) != "MONIDX01" {
+		return nil, false
+	}
+	versao := binary.LittleEndian.Uint32(conteudo[8:])
+	tamanho := int(binary.LittleEndian.Uint32(conteudo[12:]))
+	if !(versao == 2 && tamanho == tamanhoRegistroIndice) && !(versao == 1 && tamanho == tamanhoRegistroIndiceV1) {
+		return nil, false
+	}
+	registros := []registroIndice{}
+	for pos := tamanhoCabecalhoIndice; pos+tamanho <= len(conteudo); pos += tamanho {
+		b := conteudo[pos : pos+tamanho]
+		r := registroIndice{
+			capturaNs:     int64(binary.LittleEndian.Uint64(b[0:])),
+			tamanho:       binary.LittleEndian.Uint64(b[8:]),
+			mtimeOrigemNs: int64(binary.LittleEndian.Uint64(b[16:])),
+		}
+		copy(r.hash[:], b[24:56])
+		if versao == 2 {
+			r.modo = binary.LittleEndian.Uint32(b[56:])
 		}
-		if !d.IsDir() {
-			nome := d.Name()
-			if strings.HasPrefix(nome, nomeBase+"_") && strings.HasPrefix(nome[len(nomeBase)+1:], hashParcial) {
-				destino := filepath.Join(inputDir, nomeBase)
-				input, _ := os.Open(path)
-				defer input.Close()
-				output, _ := os.Create(destino)
-				defer output.Close()
-				io.Copy(output, input)
-				fmt.Printf("✅ Restaurado %s a partir do hash %s\n", nomeBase, hashParcial)
-				found = true
-				return io.EOF // stop walk
+		registros = append(registros, r)
+	}
+	return registros, true
+}
+
+// o que um leitor reconstruiria sem o índice: as versões da pasta, com o mtime no store
+// como captura e as permissões como modo (desconhecido nas cifradas); `ignorar` fica de fora
+func reconstruirIndice(relativo, ignorar string) []registroIndice {
+	registros := []registroIndice{}
+	for _, v := range versoes(relativo, "") {
+		info, err := os.Stat(v)
+		if v == ignorar || err != nil || !info.Mode().IsRegular() {
+			continue
+		}
+		r := registroIndice{capturaNs: info.ModTime().UnixNano(), tamanho: uint64(info.Size())}
+		hex.Decode(r.hash[:], []byte(v[len(v)-64:]))
+		cabecalho := make([]byte, 8)
+		if f, err := os.Open(v); err == nil {
+			n, _ := io.ReadFull(f, cabecalho)
+			f.Close()
+			if !bytes.Equal(cabecalho[:n], []byte("MONENC01")) {
+				r.modo = uint32(info.Mode().Perm())
 			}
 		}
+		registros = append(registros, r)
+	}
+	sort.SliceStable(registros, func(i, j int) bool { return registros[i].capturaNs < registros[j].capturaNs })
+	return registros
+}
+
+// acrescenta a captura ao índice do arquivo, como o monitor-cpp: re-capturas de um
+// conteúdo já salvo também entram, e o mtime e o modo da origem só existem ali
+func registrarCaptura(relativo, destino, hashHex string, tamanho int64, nova bool, info fs.FileInfo) error {
+	r := registroIndice{
+		capturaNs:     time.Now().UnixNano(),
+		tamanho:       uint64(tamanho),
+		mtimeOrigemNs: info.ModTime().UnixNano(),
+		modo:          uint32(info.Mode().Perm()),
+	}
+	if _, err := hex.Decode(r.hash[:], []byte(hashHex)); err != nil {
+		return err
+	}
+	arquivo := filepath.Join(backupDir, ".monitor", "indice", filepath.FromSlash(relativo)+".idx")
+
+	conteudo, err := os.ReadFile(arquivo)
+	if os.IsNotExist(err) {
+		// sem índice: começa pelo que o leitor reconstruiria, sem a versão recém-gravada
+		ignorar := ""
+		if nova {
+			ignorar = destino
+		}
+		return gravarIndice(arquivo, append(reconstruirIndice(relativo, ignorar), r))
+	}
+	if err != nil {
+		return err
+	}
+	registros, ok := lerIndice(conteudo)
+	if !ok {
+		return fmt.Errorf("índice inválido: %s", arquivo)
+	}
+	if binary.LittleEndian.Uint32(conteudo[8:]) == 1 {
+		return gravarIndice(arquivo, append(registros, r)) // versão 1: reescrito na versão 2
+	}
+
+	// o registro entra logo depois do último completo, sobre um resto de gravação interrompida
+	f, err := os.OpenFile(arquivo, os.O_WRONLY, 0644)
+	if err != nil {
+		return err
+	}
+	_, err = f.WriteAt(r.codificar(), int64(tamanhoCabecalhoIndice+len(registros)*tamanhoRegistroIndice))
+	if fechar := f.Close(); err == nil {
+		err = fechar
+	}
+	return err
+}
+
+// versões de nomeBase (caminho relativo) cujo hash começa com hashParcial
+func versoes(nomeBase, hashParcial string) []string {
+	pasta := filepath.Dir(filepath.Join(backupDir, filepath.FromSlash(nomeBase)))
+	prefixo := filepath.Base(nomeBase) + "_"
+	entradas, err := os.ReadDir(pasta)
+	if err != nil {
 		return nil
-	})
+	}
+	encontradas := []string{}
+	for _, e := range entradas {
+		nome := e.Name()
+		if e.IsDir() || !strings.HasPrefix(nome, prefixo) || len(nome) != len(prefixo)+64 {
+			continue
+		}
+		if strings.HasPrefix(nome[len(prefixo):], hashParcial) {
+			encontradas = append(encontradas, filepath.Join(pasta, nome))
+		}
+	}
+	return encontradas
+}
 
-	if err != nil && err != io.EOF {
-		fmt.Println("Erro ao restaurar:", err)
+// restaurar arquivo por hash
+func restaurarPorHash(nomeBase, hashParcial string) {
+	encontradas := versoes(nomeBase, hashParcial)
+	if len(encontradas) == 0 {
+		fmt.Printf("❌ Versão não encontrada para hash: %s\n", hashParcial)
 		return
 	}
 
-	if !found {
-		fmt.Printf("❌ Versão não encontrada para hash: %s\n", hashParcial)
+	destino := filepath.Join(inputDir, filepath.FromSlash(nomeBase))
+	input, err := os.Open(encontradas[0])
+	if err != nil {
+		fmt.Println("Erro ao restaurar:", err)
+		return
+	}
+	defer input.Close()
+	os.MkdirAll(filepath.Dir(destino), os.ModePerm)
+	output, err := os.Create(destino)
+	if err != nil {
+		fmt.Println("Erro ao restaurar:", err)
+		return
 	}
+	defer output.Close()
+	if _, err := io.Copy(output, input); err != nil {
+		fmt.Println("Erro ao restaurar:", err)
+		return
+	}
+	fmt.Printf("✅ Restaurado %s a partir do hash %s\n", nomeBase, hashParcial)
 }
 
 // listar hashes disponíveis
 func listarHashes(nomeBase string) {
-	hashes := []string{}
-
-	filepath.WalkDir(backupDir, func(path string, d fs.DirEntry, err error) error {
-		if err != nil {
-			return err
-		}
-		if !d.IsDir() {
-			nome := d.Name()
-			if strings.HasPrefix(nome, nomeBase+"_") {
-				hash := nome[len(nomeBase)+1:]
-				hashes = append(hashes, hash)
-			}
-		}
-		return nil
-	})
-
-	if len(hashes) == 0 {
+	encontradas := versoes(nomeBase, "")
+	if len(encontradas) == 0 {
 		fmt.Printf("Nenhuma versão encontrada para %s\n", nomeBase)
-	} else {
-		fmt.Printf("Hashes disponíveis para %s:\n", nomeBase)
-		for _, h := range hashes {
-			fmt.Printf(" - %s\n", h)
-		}
+		return
+	}
+	fmt.Printf("Hashes disponíveis para %s:\n", nomeBase)
+	for _, v := range encontradas {
+		nome := filepath.Base(v)
+		fmt.Printf(" - %s\n", nome[len(nome)-64:])
 	}
 }
 
@@ -100,6 +343,8 @@ func mostrarHelp() {
 	fmt.Println("--list <arquivo>                             : Lista todas as versões (hashes) disponíveis para o arquivo")
 	fmt.Println("--revert <arquivo> <hash>                    : Restaura a versão do arquivo correspondente ao hash (parcial ou completo)")
 	fmt.Println("--help                                       : Ajuda")
+	fmt.Println("\nMONITOR_INPUT, MONITOR_OUTPUT e MONITOR_INTERVALO_MS substituem as pastas e o intervalo padrão.")
+	fmt.Println("O store segue o formato descrito em monitor-cpp/FORMATO_STORE.md e pode ser lido pelo monitor-cpp.")
 	fmt.Println("\nExemplos:")
 	fmt.Println("  ./monitor_app                              : inicia monitoramento")
 	fmt.Println("  ./monitor_app --list arquivo.txt           : lista versões do arquivo")
@@ -107,11 +352,16 @@ func mostrarHelp() {
 }
 
 func main() {
+	lerAmbiente()
 	if _, err := os.Stat(inputDir); os.IsNotExist(err) {
 		fmt.Println("Diretório inválido:", inputDir)
 		return
 	}
 	os.MkdirAll(backupDir, os.ModePerm)
+	if err := prepararStore(); err != nil {
+		fmt.Println("❌", err)
+		os.Exit(1)
+	}
 
 	args := os.Args
 
@@ -141,37 +391,44 @@ func main() {
 	}
 
 	// monitoramento
-	arquivosAnteriores := make(map[string]time.Time)
+	arquivosAnteriores := make(map[string]estadoArquivo)
 	fmt.Printf("📡 Monitorando %s e salvando versões em %s\n", inputDir, backupDir)
 
 	for {
 		filepath.WalkDir(inputDir, func(path string, d fs.DirEntry, err error) error {
-			if err != nil || d.IsDir() {
+			if err != nil || d.IsDir() || !d.Type().IsRegular() {
 				return nil
 			}
-			nome := d.Name()
-			info, _ := os.Stat(path)
-			modTime := info.ModTime()
+			info, err := d.Info()
+			if err != nil {
+				return nil
+			}
+			rel, err := filepath.Rel(inputDir, path)
+			if err != nil {
+				return nil
+			}
+			relativo := filepath.ToSlash(rel)
+			atual := estadoArquivo{info.ModTime(), info.Size()}
 
-			if t, ok := arquivosAnteriores[nome]; !ok || !modTime.Equal(t) {
-				hash, err := calcularHash(path)
+			if anterior, ok := arquivosAnteriores[relativo]; !ok || !anterior.modTime.Equal(atual.modTime) ||
+				anterior.tamanho != atual.tamanho {
+				destino, hash, tamanho, nova, err := salvarVersao(path, relativo, info.Mode())
 				if err != nil {
-					fmt.Println("Erro ao calcular hash:", err)
+					fmt.Println("Erro ao salvar versão:", err)
 					return nil
 				}
-				destino := filepath.Join(backupDir, nome+"_"+hash)
-				input, _ := os.Open(path)
-				defer input.Close()
-				output, _ := os.Create(destino)
-				defer output.Close()
-				io.Copy(output, input)
-				fmt.Println("💾 Nova versão salva:", destino)
-				arquivosAnteriores[nome] = modTime
+				if nova {
+					fmt.Println("💾 Nova versão salva:", destino)
+				}
+				if err := registrarCaptura(relativo, destino, hash, tamanho, nova, info); err != nil {
+					fmt.Println("Erro ao atualizar índice:", err)
+				}
+				arquivosAnteriores[relativo] = atual
 			}
 
 			return nil
 		})
 
-		time.Sleep(2 * time.Second)
+		time.Sleep(intervalo)
 	}
 }